@@ -142,23 +142,23 @@ public static bool ReformatModel(string filepath, string version, string newfile
             List<Material> mats = new List<Material>();
 
             SketchUpNET.SketchUp skp = new SketchUpNET.SketchUp();
-            if (skp.LoadModel(path, includeMeshes))
+            if (skp.LoadModel(path, includeMeshes, LoadOptions.ByLayer(layername)))
             {
 
-                foreach (Surface srf in skp.Surfaces.Where(s=>s.Layer == layername))
+                foreach (Surface srf in skp.Surfaces)
                 {
                     surfaces.Add(srf.ToDSGeo());
                     if (srf.FaceMesh != null)
                         meshes.Add(srf.FaceMesh.ToDSGeo());
                 }
 
-                foreach (Instance i in skp.Instances.Where(s => s.Layer == layername))
+                foreach (Instance i in skp.Instances)
                     Instances.Add(i);
 
-                foreach (Edge e in skp.Edges.Where(s => s.Layer == layername))
+                foreach (Edge e in skp.Edges)
                     edges.Add(e.ToDSGeo());
 
-                foreach (Group gr in skp.Groups.Where(s => s.Layer == layername))
+                foreach (Group gr in skp.Groups)
                     grp.Add(gr);
 
                 foreach (var mat in skp.Materials)
@@ -284,30 +284,24 @@ public static List<Autodesk.DesignScript.Geometry.Geometry> FlattenInstances(Lis
         {
             List<Autodesk.DesignScript.Geometry.Geometry> data = new List<Autodesk.DesignScript.Geometry.Geometry>();
 
-            foreach (Instance instance in instances)
-                FlattenInstance(instance, ref data);
-
-            return data;
-        }
-
-        private static void FlattenInstance(Instance instance, ref List<Autodesk.DesignScript.Geometry.Geometry> data)
-        {
-            Autodesk.DesignScript.Geometry.Point p = Autodesk.DesignScript.Geometry.Point.ByCoordinates(instance.Transformation.X, instance.Transformation.Y, instance.Transformation.Z);
-
-            Component parent = instance.Parent as Component;
+            // Nested groups and instances are placed with their composed world transformation
+            foreach (Placement placement in InstanceTree.Build(null, instances).Placements)
+            {
+                foreach (Surface srf in placement.Surfaces)
+                    data.Add(srf.ToDSGeo(placement.World));
 
-            foreach (Surface srf in parent.Surfaces)
-                data.Add(srf.ToDSGeo(instance.Transformation));
+                foreach (Curve c in placement.Curves)
+                {
+                    var curves = c.ToDSGeo(placement.World);
+                    foreach (var curve in curves)
+                        data.Add(curve);
+                }
 
-            foreach (Curve c in parent.Curves)
-            {
-                var curves = c.ToDSGeo(instance.Transformation);
-                foreach (var curve in curves)
-                    data.Add(curve);
-            }      
+                foreach (Edge e in placement.Edges)
+                    data.Add(e.ToDSGeo(placement.World));
+            }
 
-            foreach (Edge e in parent.Edges)
-                data.Add(e.ToDSGeo(instance.Transformation));
+            return data;
         }
 
         /// <summary>
@@ -438,13 +432,17 @@ public static List<Autodesk.DesignScript.Geometry.Line> ToDSGeo(this SketchUpNET
         [IsVisibleInDynamoLibrary(false)]
         public static Autodesk.DesignScript.Geometry.Mesh ToDSGeo(this SketchUpNET.Mesh mesh, Transform t = null)
         {
-            List<Autodesk.DesignScript.Geometry.Point> points = new List<Autodesk.DesignScript.Geometry.Point>();
-            foreach (var v in mesh.Vertices)
-                points.Add(v.ToDSGeo(t));
-
-            List<Autodesk.DesignScript.Geometry.IndexGroup> faces = new List<Autodesk.DesignScript.Geometry.IndexGroup>();
-            foreach (var v in mesh.Faces)
-                faces.Add(Autodesk.DesignScript.Geometry.IndexGroup.ByIndices(Convert.ToUInt32(v.A),Convert.ToUInt32(v.B),Convert.ToUInt32(v.C)));
+            List<Autodesk.DesignScript.Geometry.Point> points = new List<Autodesk.DesignScript.Geometry.Point>(mesh.VertexCount);
+            double[] positions = mesh.GetPositions();
+            if (t != null)
+                t.TransformPoints(positions);
+            for (int i = 0; i < positions.Length; i += 3)
+                points.Add(Autodesk.DesignScript.Geometry.Point.ByCoordinates(positions[i], positions[i + 1], positions[i + 2]));
+
+            uint[] indices = mesh.GetIndices();
+            List<Autodesk.DesignScript.Geometry.IndexGroup> faces = new List<Autodesk.DesignScript.Geometry.IndexGroup>(indices.Length / 3);
+            for (int i = 0; i < indices.Length; i += 3)
+                faces.Add(Autodesk.DesignScript.Geometry.IndexGroup.ByIndices(indices[i], indices[i + 1], indices[i + 2]));
 
 
             Autodesk.DesignScript.Geometry.Mesh m = Autodesk.DesignScript.Geometry.Mesh.ByPointsFaceIndices(points, faces);
@@ -136,8 +136,12 @@ protected override void RegisterInputParams(GH_Component.GH_InputParamManager pM
             pManager.AddTextParameter("Path", "P", "Path to Sketchup File (skp)", GH_ParamAccess.item);
             int a = pManager.AddCurveParameter("Curves", "C", "Curves", GH_ParamAccess.list);
             int b = pManager.AddSurfaceParameter("Surfaces", "S", "Surfaces", GH_ParamAccess.list);
+            int c = pManager.AddMeshParameter("Meshes", "M", "Meshes, written as welded polygon meshes", GH_ParamAccess.list);
+            int d = pManager.AddBooleanParameter("Soften", "Sm", "Soften and smooth interior mesh edges (Default: False)", GH_ParamAccess.item);
             pManager[a].Optional = true;
             pManager[b].Optional = true;
+            pManager[c].Optional = true;
+            pManager[d].Optional = true;
         }
 
         protected override void RegisterOutputParams(GH_Component.GH_OutputParamManager pManager)
@@ -154,8 +158,15 @@ protected override void SolveInstance(IGH_DataAccess DA)
             DA.GetDataList<GH_Surface>(1, surfaces);
             List<GH_Curve> curves = new List<GH_Curve>();
             DA.GetDataList<GH_Curve>(2, curves);
+            List<GH_Mesh> meshes = new List<GH_Mesh>();
+            DA.GetDataList<GH_Mesh>(3, meshes);
+            GH_Boolean soften = new GH_Boolean(false);
+            if (!DA.GetData<GH_Boolean>(4, ref soften))
+            {
+                soften = new GH_Boolean(false);
+            }
 
-            Geometry.WriteModel(path.Value, surfaces, curves, false);
+            Geometry.WriteModel(path.Value, surfaces, curves, false, meshes, soften.Value);
         }
 
         public override Guid ComponentGuid
@@ -420,23 +431,55 @@ public static Rhino.Geometry.Mesh ToRhinoGeo(this SketchUpNET.Mesh mesh, Transfo
         {
             Rhino.Geometry.Mesh m = new Rhino.Geometry.Mesh();
 
-            foreach (var v in mesh.Vertices)
-                m.Vertices.Add(v.ToRhinoGeo(t));
+            double[] positions = mesh.GetPositions();
+            if (t != null)
+                t.TransformPoints(positions);
+            for (int i = 0; i < positions.Length; i += 3)
+                m.Vertices.Add(positions[i], positions[i + 1], positions[i + 2]);
 
-            foreach (var v in mesh.Faces)
-                m.Faces.AddFace(v.A,v.B,v.C);
+            uint[] indices = mesh.GetIndices();
+            for (int i = 0; i < indices.Length; i += 3)
+                m.Faces.AddFace((int)indices[i], (int)indices[i + 1], (int)indices[i + 2]);
 
             m.Normals.ComputeNormals();
             m.Compact();
             return m;
         }
 
-        public static void WriteModel(string path, List<GH_Surface> surfaces = null, List<GH_Curve> curves = null, bool append = false)
+        /// <summary>
+        /// Converts a Rhino Mesh to a SketchUp Mesh, quads are split into two triangles
+        /// </summary>
+        public static SketchUpNET.Mesh ToSkpGeo(this Rhino.Geometry.Mesh mesh)
+        {
+            double[] positions = new double[3 * mesh.Vertices.Count];
+            for (int i = 0; i < mesh.Vertices.Count; i++)
+            {
+                Rhino.Geometry.Point3d p = mesh.Vertices.Point3dAt(i);
+                positions[3 * i] = p.X;
+                positions[3 * i + 1] = p.Y;
+                positions[3 * i + 2] = p.Z;
+            }
+
+            List<uint> indices = new List<uint>(6 * mesh.Faces.Count);
+            foreach (Rhino.Geometry.MeshFace face in mesh.Faces)
+            {
+                indices.Add((uint)face.A); indices.Add((uint)face.B); indices.Add((uint)face.C);
+                if (face.IsQuad)
+                {
+                    indices.Add((uint)face.A); indices.Add((uint)face.C); indices.Add((uint)face.D);
+                }
+            }
+
+            return new SketchUpNET.Mesh(positions, indices.ToArray(), DefaultLayer);
+        }
+
+        public static void WriteModel(string path, List<GH_Surface> surfaces = null, List<GH_Curve> curves = null, bool append = false, List<GH_Mesh> meshes = null, bool soften = false)
         {
             SketchUpNET.SketchUp skp = new SketchUpNET.SketchUp();
             skp.Surfaces = new List<Surface>();
             skp.Edges = new List<Edge>();
             skp.Curves = new List<Curve>();
+            skp.Meshes = new List<SketchUpNET.Mesh>();
 
             if (curves != null)
                 foreach (var c in curves)
@@ -457,6 +500,14 @@ public static void WriteModel(string path, List<GH_Surface> surfaces = null, Lis
                 foreach (var surface in surfaces)
                     skp.Surfaces.Add(surface.Value.ToSkpGeo());
 
+            if (meshes != null)
+                foreach (var mesh in meshes)
+                    if (mesh.Value != null)
+                        skp.Meshes.Add(mesh.Value.ToSkpGeo());
+
+            // Rhino render meshes may hide their triangulation
+            skp.Writer.SoftenInteriorEdges = soften;
+
             if (System.IO.File.Exists(path) && append)
                 skp.AppendToModel(path);
             else
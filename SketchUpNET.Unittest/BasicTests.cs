@@ -29,9 +29,895 @@ public void TestGetMesh()
                 Assert.IsNotNull(srf.FaceMesh);
                 Assert.IsTrue(srf.FaceMesh.Faces.Count > 0);
                 Assert.IsTrue(srf.FaceMesh.Vertices.Count > 0);
+                Assert.AreEqual(srf.FaceMesh.Vertices.Count, srf.FaceMesh.Normals.Count);
             }
         }
 
+        /// <summary>
+        /// Test packed mesh buffers against the vertex and face lists
+        /// </summary>
+        [TestMethod]
+        public void TestPackedMesh()
+        {
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.LoadModel(TestFile, true);
+            foreach (var srf in skp.Surfaces)
+            {
+                Mesh mesh = srf.FaceMesh;
+                double[] positions = mesh.GetPositions();
+                uint[] indices = mesh.GetIndices();
+                Assert.AreEqual(3 * mesh.VertexCount, positions.Length);
+                Assert.AreEqual(3 * mesh.TriangleCount, indices.Length);
+                Assert.AreEqual(3 * mesh.VertexCount, mesh.GetNormalsSingle().Length);
+                Assert.AreEqual(mesh.Vertices[0].X, positions[0]);
+                Assert.AreEqual((uint)mesh.Faces[0].B, indices[1]);
+            }
+        }
+
+        /// <summary>
+        /// Test extracting texture coordinates with the face meshes
+        /// </summary>
+        [TestMethod]
+        public void TestTextureCoordinates()
+        {
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.LoadModel(TestFile, true, new LoadOptions() { TextureCoordinates = true });
+            foreach (var srf in skp.Surfaces)
+            {
+                Mesh mesh = srf.FaceMesh;
+                Assert.IsTrue(mesh.HasTextureCoordinates);
+                Assert.AreEqual(2 * mesh.VertexCount, mesh.GetFrontUVs().Length);
+                Assert.AreEqual(2 * mesh.VertexCount, mesh.GetBackUVs().Length);
+            }
+
+            skp.LoadModel(TestFile, true);
+            foreach (var srf in skp.Surfaces)
+                Assert.AreEqual(0, srf.FaceMesh.GetFrontUVs().Length);
+        }
+
+        /// <summary>
+        /// Test reading deduplicated texture images and encoding them in memory
+        /// </summary>
+        [TestMethod]
+        public void TestTextureImages()
+        {
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.LoadModel(TestFile, false, new LoadOptions() { TextureImages = true });
+            Assert.IsNotNull(skp.TextureImages);
+            var hashes = new System.Collections.Generic.HashSet<ulong>();
+            foreach (var image in skp.TextureImages)
+            {
+                Assert.AreEqual(4 * image.Width * image.Height, image.Pixels.Length);
+                Assert.IsTrue(image.Materials.Count > 0);
+                hashes.Add(image.Hash);
+            }
+            Assert.AreEqual(skp.TextureImages.Count, hashes.Count);
+
+            TextureImage.EncodeAll(skp.TextureImages, false);
+            foreach (var image in skp.TextureImages)
+                Assert.IsTrue(image.Encoded.Length > 0);
+        }
+
+        /// <summary>
+        /// Test flattening groups and instances with composed world transformations
+        /// </summary>
+        [TestMethod]
+        public void TestInstanceTree()
+        {
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.LoadModel(TestFile);
+            InstanceTree tree = skp.GetInstanceTree();
+            Assert.IsTrue(tree.Placements.Count >= skp.Groups.Count + skp.Instances.Count);
+            foreach (var placement in tree.Placements)
+            {
+                if (placement.Parent < 0)
+                    continue;
+                Transform parent = tree.Placements[placement.Parent].World;
+                Transform local = placement.Group != null ? placement.Group.Transformation : placement.Instance.Transformation;
+                double[] expected = parent.Multiply(local).Data;
+                for (int i = 0; i < 16; i++)
+                    Assert.AreEqual(expected[i], placement.World.Data[i], 1e-9);
+            }
+            Assert.AreEqual(6 * tree.EdgeCount, tree.GetWorldEdges(false).Length);
+        }
+
+        /// <summary>
+        /// Test batch transforms against single point transforms and the inverse
+        /// </summary>
+        [TestMethod]
+        public void TestBatchTransform()
+        {
+            // Uniform scale 2 stored as w = 0.5, rotated 90 degrees about z and moved by (1, 2, 3)
+            Transform t = new Transform(new double[] { 0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 1, 2, 3, 0.5 });
+            double[] points = new double[3 * 100001];
+            for (int i = 0; i < points.Length; i++)
+                points[i] = i % 7 - 3;
+            double[] original = (double[])points.Clone();
+
+            t.TransformPoints(points);
+            for (int i = 0; i < points.Length; i += 3 * 997)
+            {
+                Vertex expected = t.GetTransformed(new Vertex(original[i], original[i + 1], original[i + 2]));
+                Assert.AreEqual(expected.X, points[i], 1e-9);
+                Assert.AreEqual(expected.Y, points[i + 1], 1e-9);
+                Assert.AreEqual(expected.Z, points[i + 2], 1e-9);
+            }
+
+            Vertex moved = t.GetTransformed(new Vertex(1, 0, 0));
+            Assert.AreEqual(2, moved.X, 1e-9);
+            Assert.AreEqual(6, moved.Y, 1e-9);
+
+            t.Inverse().TransformPoints(points);
+            for (int i = 0; i < points.Length; i++)
+                Assert.AreEqual(original[i], points[i], 1e-9);
+
+            double[] normals = { 1, 0, 0 };
+            t.TransformNormals(normals);
+            Assert.AreEqual(1, normals[1], 1e-9);
+        }
+
+        /// <summary>
+        /// Test captured bounds and region and overlap queries of the model hierarchy
+        /// </summary>
+        [TestMethod]
+        public void TestBoundingVolumeHierarchy()
+        {
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.LoadModel(TestFile);
+            foreach (var surface in skp.Surfaces)
+                foreach (var vertex in surface.Vertices)
+                    Assert.IsTrue(surface.Bounds.Contains(vertex));
+
+            BoundingVolumeHierarchy bvh = skp.GetBoundingVolumeHierarchy();
+            Assert.AreEqual(bvh.Items.Count, bvh.Count);
+
+            BoundingBox region = skp.Surfaces[0].Bounds;
+            List<int> hits = bvh.Query(region);
+            for (int i = 0; i < bvh.Count; i++)
+                Assert.AreEqual(bvh.GetBounds(i).Intersects(region), hits.Contains(i));
+
+            foreach (var pair in bvh.FindOverlaps(false))
+            {
+                Assert.IsTrue(pair.Item1 < pair.Item2);
+                Assert.IsTrue(bvh.GetBounds(pair.Item1).Intersects(bvh.GetBounds(pair.Item2)));
+            }
+        }
+
+        /// <summary>
+        /// Test ray casts and nearest points against the surface meshes
+        /// </summary>
+        [TestMethod]
+        public void TestRayCaster()
+        {
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.LoadModel(TestFile, true);
+            RayCaster caster = skp.GetRayCaster();
+            Assert.IsTrue(caster.TriangleCount > 0);
+
+            Mesh mesh = skp.Surfaces[0].FaceMesh;
+            MeshFace face = mesh.Faces[0];
+            Vertex a = mesh.Vertices[face.A], b = mesh.Vertices[face.B], c = mesh.Vertices[face.C];
+            Vertex center = new Vertex((a.X + b.X + c.X) / 3, (a.Y + b.Y + c.Y) / 3, (a.Z + b.Z + c.Z) / 3);
+
+            RayHit nearest = caster.Nearest(center);
+            Assert.IsNotNull(nearest);
+            Assert.AreEqual(0, nearest.Distance, 1e-9);
+
+            Vector normal = skp.Surfaces[0].Normal;
+            Vertex origin = new Vertex(center.X + normal.X, center.Y + normal.Y, center.Z + normal.Z);
+            RayHit hit = caster.Cast(origin, new Vector(-normal.X, -normal.Y, -normal.Z));
+            Assert.IsNotNull(hit);
+            Assert.IsTrue(hit.Distance <= 1 + 1e-9);
+            Assert.IsTrue(hit.U >= 0 && hit.V >= 0 && hit.U + hit.V <= 1);
+
+            RayHit[] hits = caster.Cast(new double[] { origin.X, origin.Y, origin.Z }, new double[] { -normal.X, -normal.Y, -normal.Z }, double.MaxValue, false);
+            Assert.AreEqual(hit.Distance, hits[0].Distance, 1e-12);
+            Assert.AreSame(hit.Surface, hits[0].Surface);
+        }
+
+        /// <summary>
+        /// Test writing a grid of faces in several geometry input batches
+        /// </summary>
+        [TestMethod]
+        public void TestBatchedWriter()
+        {
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.Surfaces = new List<Surface>();
+            skp.Edges = new List<Edge>();
+            skp.Curves = new List<Curve>();
+            for (int i = 0; i < 100; i++)
+            {
+                double x = i % 10, y = i / 10;
+                Vertex[] corners = { new Vertex(x, y, 0), new Vertex(x + 1, y, 0), new Vertex(x + 1, y + 1, 0), new Vertex(x, y + 1, 0) };
+                List<Edge> edges = new List<Edge>();
+                for (int c = 0; c < 4; c++)
+                    edges.Add(new Edge(corners[c], corners[(c + 1) % 4]));
+                skp.Surfaces.Add(new Surface(new Loop(edges)));
+            }
+
+            skp.Writer = new ModelWriter() { BatchSize = 16 };
+            skp.WriteNewModel(@"TempBatchedModel.skp");
+            Assert.AreEqual(100, skp.Writer.FaceCount);
+            Assert.IsTrue(skp.Writer.BatchCount > 1);
+
+            skp.LoadModel(@"TempBatchedModel.skp");
+            Assert.AreEqual(100, skp.Surfaces.Count);
+        }
+
+        /// <summary>
+        /// Test writing a triangle soup as a welded mesh with soft interior edges
+        /// </summary>
+        [TestMethod]
+        public void TestMeshWriter()
+        {
+            // 10x10 grid of quads, every triangle with its own slightly displaced corners
+            List<double> positions = new List<double>();
+            for (int i = 0; i < 100; i++)
+            {
+                double x = i % 10, y = i / 10;
+                double[] quad = { x, y, x + 1, y, x + 1, y + 1, x, y, x + 1, y + 1, x, y + 1 };
+                for (int c = 0; c < 6; c++)
+                    positions.AddRange(new double[] { quad[2 * c] + c * 1e-8, quad[2 * c + 1], 0 });
+            }
+            uint[] indices = new uint[600];
+            for (uint i = 0; i < indices.Length; i++)
+                indices[i] = i;
+
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.Surfaces = new List<Surface>();
+            skp.Edges = new List<Edge>();
+            skp.Curves = new List<Curve>();
+            skp.Meshes = new List<Mesh>() { new Mesh(positions.ToArray(), indices, "Layer0") };
+            skp.Writer = new ModelWriter() { WeldTolerance = 1e-6, SoftenInteriorEdges = true };
+            skp.WriteNewModel(@"TempMeshModel.skp");
+            Assert.AreEqual(200, skp.Writer.FaceCount);
+
+            skp.LoadModel(@"TempMeshModel.skp", true);
+            Assert.AreEqual(200, skp.Surfaces.Count);
+            HashSet<Tuple<double, double>> corners = new HashSet<Tuple<double, double>>();
+            foreach (var srf in skp.Surfaces)
+                foreach (var v in srf.Vertices)
+                    corners.Add(Tuple.Create(Math.Round(v.X, 4), Math.Round(v.Y, 4)));
+            Assert.AreEqual(121, corners.Count);
+        }
+
+        /// <summary>
+        /// Test writing a component definition once with several instances and nested groups
+        /// </summary>
+        [TestMethod]
+        public void TestHierarchyWriter()
+        {
+            Vertex[] corners = { new Vertex(0, 0, 0), new Vertex(1, 0, 0), new Vertex(1, 1, 0), new Vertex(0, 1, 0) };
+            List<Edge> edges = new List<Edge>();
+            for (int c = 0; c < 4; c++)
+                edges.Add(new Edge(corners[c], corners[(c + 1) % 4]));
+            List<Surface> square = new List<Surface>() { new Surface(new Loop(edges)) };
+
+            Component panel = new Component("Panel", "panel-guid", square, new List<Curve>(), new List<Edge>(), new List<Instance>(), "Facade panel", new List<Group>());
+
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.Surfaces = new List<Surface>();
+            skp.Edges = new List<Edge>();
+            skp.Curves = new List<Curve>();
+            skp.Components = new Dictionary<string, Component>() { { panel.Guid, panel } };
+            skp.Instances = new List<Instance>();
+            for (int i = 0; i < 3; i++)
+            {
+                Transform move = new Transform(new double[] { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 2 * i, 0, 0, 1 });
+                skp.Instances.Add(new Instance("Panel " + i, null, panel.Guid, move, "Layer0", null));
+            }
+
+            Group inner = new Group("Inner", square, new List<Curve>(), new List<Edge>(), new List<Instance>(), new List<Group>(), null, "Layer0", null, null);
+            Group outer = new Group("Outer", new List<Surface>(), new List<Curve>(), new List<Edge>(), new List<Instance>(), new List<Group>() { inner }, null, "Layer0", null, null);
+            skp.Groups = new List<Group>() { outer };
+
+            skp.WriteNewModel(@"TempHierarchyModel.skp");
+            Assert.AreEqual(1, skp.Writer.DefinitionCount);
+            Assert.AreEqual(5, skp.Writer.PlacementCount);
+
+            skp.LoadModel(@"TempHierarchyModel.skp");
+            Assert.AreEqual(3, skp.Instances.Count);
+            Assert.AreSame(skp.Instances[0].Parent, skp.Instances[2].Parent);
+            Assert.AreEqual(1, ((Component)skp.Instances[0].Parent).Surfaces.Count);
+            Assert.AreEqual(1, skp.Groups.Count);
+            Assert.AreEqual(1, skp.Groups[0].Groups.Count);
+            Assert.AreEqual(1, skp.Groups[0].Groups[0].Surfaces.Count);
+        }
+
+        /// <summary>
+        /// Test placing many instances of one definition from packed transforms
+        /// </summary>
+        [TestMethod]
+        public void TestPlaceInstances()
+        {
+            Vertex[] corners = { new Vertex(0, 0, 0), new Vertex(1, 0, 0), new Vertex(1, 1, 0), new Vertex(0, 1, 0) };
+            List<Edge> edges = new List<Edge>();
+            for (int c = 0; c < 4; c++)
+                edges.Add(new Edge(corners[c], corners[(c + 1) % 4]));
+            Component seat = new Component("Seat", "seat-guid", new List<Surface>() { new Surface(new Loop(edges)) }, new List<Curve>(), new List<Edge>(), new List<Instance>(), "", new List<Group>());
+
+            double[] transforms = new double[12 * 1000];
+            for (int i = 0; i < 1000; i++)
+            {
+                double[] t = { 1, 0, 0, 2 * i, 0, 1, 0, 0, 0, 0, 1, 0 };
+                Array.Copy(t, 0, transforms, 12 * i, 12);
+            }
+
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.Surfaces = new List<Surface>();
+            skp.Edges = new List<Edge>();
+            skp.Curves = new List<Curve>();
+            Assert.AreEqual(1000, skp.PlaceInstances(seat, transforms, "Layer0", null).Count);
+            skp.WriteNewModel(@"TempPlacedModel.skp");
+            Assert.AreEqual(1, skp.Writer.DefinitionCount);
+            Assert.AreEqual(1000, skp.Writer.PlacementCount);
+
+            skp.LoadModel(@"TempPlacedModel.skp");
+            Assert.AreEqual(1000, skp.Instances.Count);
+            Assert.AreEqual(2 * 999, skp.Instances[999].Transformation.Data[12], 1e-6);
+        }
+
+        /// <summary>
+        /// Test that GLB export is byte for byte deterministic and instances large placement counts
+        /// </summary>
+        [TestMethod]
+        public void TestGltfExport()
+        {
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.LoadModel(TestFile, true);
+
+            GltfExporter exporter = new GltfExporter();
+            System.IO.MemoryStream first = new System.IO.MemoryStream();
+            exporter.Write(first, skp.Surfaces, skp.Groups, skp.Instances);
+            System.IO.MemoryStream second = new System.IO.MemoryStream();
+            new GltfExporter().Write(second, skp.Surfaces, skp.Groups, skp.Instances);
+
+            byte[] bytes = first.ToArray();
+            CollectionAssert.AreEqual(bytes, second.ToArray());
+            Assert.AreEqual(exporter.ByteCount, bytes.Length);
+            Assert.AreEqual(0x46546C67u, BitConverter.ToUInt32(bytes, 0));
+            Assert.AreEqual(2u, BitConverter.ToUInt32(bytes, 4));
+            Assert.AreEqual((uint)bytes.Length, BitConverter.ToUInt32(bytes, 8));
+            Assert.AreEqual(0, bytes.Length % 4);
+
+            // Every placement of a body goes through EXT_mesh_gpu_instancing
+            GltfExporter instancing = new GltfExporter() { InstancingThreshold = 1 };
+            System.IO.MemoryStream third = new System.IO.MemoryStream();
+            instancing.Write(third, skp.Surfaces, skp.Groups, skp.Instances);
+            Assert.IsTrue(instancing.NodeCount <= exporter.NodeCount);
+            Assert.AreEqual(exporter.MeshCount, instancing.MeshCount);
+        }
+
+        /// <summary>
+        /// Test streaming the triangles of a model into STL, PLY and OBJ files
+        /// </summary>
+        [TestMethod]
+        public void TestMeshExporter()
+        {
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.LoadModel(TestFile, true);
+            long triangles = 0;
+            foreach (var srf in skp.Surfaces)
+                triangles += srf.FaceMesh.TriangleCount;
+            foreach (var placement in skp.GetInstanceTree().Placements)
+                foreach (var srf in placement.Surfaces)
+                    triangles += srf.FaceMesh.TriangleCount;
+
+            MeshExporter exporter = new MeshExporter();
+            Assert.IsTrue(exporter.Export(TestFile, @"TempExport.stl", MeshFormat.Stl));
+            Assert.AreEqual(triangles, exporter.TriangleCount);
+            Assert.AreEqual(84 + 50 * triangles, new System.IO.FileInfo(@"TempExport.stl").Length);
+
+            Assert.IsTrue(exporter.Export(TestFile, @"TempExport.ply", MeshFormat.Ply));
+            Assert.AreEqual(triangles, exporter.TriangleCount);
+
+            Assert.IsTrue(exporter.Export(TestFile, @"TempExport.obj", MeshFormat.Obj));
+            int faces = 0;
+            foreach (string line in System.IO.File.ReadLines(@"TempExport.obj"))
+                if (line.StartsWith("f "))
+                    faces++;
+            Assert.AreEqual(triangles, faces);
+        }
+
+        /// <summary>
+        /// Test loading a model from the binary cache and rebuilding a damaged cache file
+        /// </summary>
+        [TestMethod]
+        public void TestModelCache()
+        {
+            ModelCache cache = new ModelCache(System.IO.Path.Combine(System.IO.Path.GetTempPath(), "SketchUpNETCache"));
+            cache.Invalidate(TestFile);
+
+            SketchUpNET.SketchUp skp = new SketchUp();
+            Assert.IsTrue(skp.LoadModelCached(TestFile, true, cache));
+            Assert.IsFalse(cache.Hit);
+            string path = cache.GetCachePath(TestFile);
+            Assert.AreEqual(new System.IO.FileInfo(path).Length, cache.ByteCount);
+
+            SketchUpNET.SketchUp cached = new SketchUp();
+            Assert.IsTrue(cached.LoadModelCached(TestFile, true, cache));
+            Assert.IsTrue(cache.Hit);
+            Assert.AreEqual(skp.ModelGuid, cached.ModelGuid);
+            Assert.AreEqual(skp.Surfaces.Count, cached.Surfaces.Count);
+            Assert.AreEqual(skp.Edges.Count, cached.Edges.Count);
+            Assert.AreEqual(skp.Groups.Count, cached.Groups.Count);
+            Assert.AreEqual(skp.Components.Count, cached.Components.Count);
+            Assert.AreEqual(skp.Materials.Count, cached.Materials.Count);
+            Assert.AreEqual(skp.Layers.Count, cached.Layers.Count);
+            Assert.AreEqual(skp.GetInstanceTree().Placements.Count, cached.GetInstanceTree().Placements.Count);
+            for (int i = 0; i < skp.Surfaces.Count; i++)
+            {
+                Assert.AreEqual(skp.Surfaces[i].Vertices.Count, cached.Surfaces[i].Vertices.Count);
+                Assert.AreEqual(skp.Surfaces[i].Vertices[0].X, cached.Surfaces[i].Vertices[0].X);
+                Assert.AreEqual(skp.Surfaces[i].FaceMesh.TriangleCount, cached.Surfaces[i].FaceMesh.TriangleCount);
+                Assert.AreEqual(skp.Surfaces[i].FrontMaterial.Name, cached.Surfaces[i].FrontMaterial.Name);
+            }
+
+            // Another mesh setting is another key
+            Assert.IsTrue(new SketchUp().LoadModelCached(TestFile, false, cache));
+            Assert.IsFalse(cache.Hit);
+
+            byte[] bytes = System.IO.File.ReadAllBytes(path);
+            bytes[bytes.Length - 1] ^= 0xFF;
+            System.IO.File.WriteAllBytes(path, bytes);
+            SketchUpNET.SketchUp rebuilt = new SketchUp();
+            Assert.IsTrue(rebuilt.LoadModelCached(TestFile, false, cache));
+            Assert.IsFalse(cache.Hit);
+            Assert.AreEqual(skp.Surfaces.Count, rebuilt.Surfaces.Count);
+        }
+
+        /// <summary>
+        /// Test that layer, region and kind filters skip excluded top level entities
+        /// </summary>
+        [TestMethod]
+        public void TestLoadOptions()
+        {
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.LoadModel(TestFile, false);
+            string layer = skp.Surfaces[0].Layer;
+
+            SketchUpNET.SketchUp byLayer = new SketchUp();
+            Assert.IsTrue(byLayer.LoadModel(TestFile, false, LoadOptions.ByLayer(layer)));
+            int onLayer = 0;
+            foreach (var srf in skp.Surfaces)
+                if (srf.Layer == layer)
+                    onLayer++;
+            Assert.AreEqual(onLayer, byLayer.Surfaces.Count);
+            foreach (var srf in byLayer.Surfaces)
+                Assert.AreEqual(layer, srf.Layer);
+            foreach (var edge in byLayer.Edges)
+                Assert.AreEqual(layer, edge.Layer);
+            foreach (var group in byLayer.Groups)
+                Assert.AreEqual(layer, group.Layer);
+            foreach (var instance in byLayer.Instances)
+                Assert.AreEqual(layer, instance.Layer);
+
+            SketchUpNET.SketchUp noLayer = new SketchUp();
+            Assert.IsTrue(noLayer.LoadModel(TestFile, false, LoadOptions.ByLayer("No such layer")));
+            Assert.AreEqual(0, noLayer.Surfaces.Count + noLayer.Edges.Count + noLayer.Curves.Count + noLayer.Groups.Count + noLayer.Instances.Count);
+
+            // Region around the first surface, grown by a millimeter against unit rounding
+            BoundingBox box = skp.Surfaces[0].Bounds;
+            LoadOptions region = new LoadOptions()
+            {
+                RegionMin = new Vertex(box.Min.X - 1e-3, box.Min.Y - 1e-3, box.Min.Z - 1e-3),
+                RegionMax = new Vertex(box.Max.X + 1e-3, box.Max.Y + 1e-3, box.Max.Z + 1e-3)
+            };
+            BoundingBox regionBox = new BoundingBox(region.RegionMin, region.RegionMax);
+            SketchUpNET.SketchUp regional = new SketchUp();
+            Assert.IsTrue(regional.LoadModel(TestFile, false, region));
+            int inRegion = 0;
+            foreach (var srf in skp.Surfaces)
+                if (regionBox.Intersects(srf.Bounds))
+                    inRegion++;
+            Assert.IsTrue(regional.Surfaces.Count > 0);
+            Assert.AreEqual(inRegion, regional.Surfaces.Count);
+            foreach (var srf in regional.Surfaces)
+                Assert.IsTrue(regionBox.Intersects(srf.Bounds));
+
+            SketchUpNET.SketchUp farAway = new SketchUp();
+            Assert.IsTrue(farAway.LoadModel(TestFile, false, new LoadOptions() { RegionMin = new Vertex(1e5, 1e5, 1e5), RegionMax = new Vertex(1e5 + 1, 1e5 + 1, 1e5 + 1) }));
+            Assert.AreEqual(0, farAway.Surfaces.Count + farAway.Edges.Count + farAway.Groups.Count + farAway.Instances.Count);
+
+            // Instances keep their parents when the definitions are not loaded
+            SketchUpNET.SketchUp instancesOnly = new SketchUp();
+            Assert.IsTrue(instancesOnly.LoadModel(TestFile, false, new LoadOptions() { Kinds = EntityKinds.Instances }));
+            Assert.AreEqual(0, instancesOnly.Surfaces.Count);
+            Assert.AreEqual(0, instancesOnly.Components.Count);
+            Assert.AreEqual(skp.Instances.Count, instancesOnly.Instances.Count);
+            foreach (var instance in instancesOnly.Instances)
+                Assert.IsNotNull(instance.Parent);
+        }
+
+        /// <summary>
+        /// Test surfaces and meshes reading from the shared geometry store
+        /// </summary>
+        [TestMethod]
+        public void TestGeometryStore()
+        {
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.LoadModel(TestFile, true);
+            Assert.IsNotNull(skp.Geometry);
+            Assert.IsTrue(skp.Geometry.FaceCount >= skp.Surfaces.Count);
+            Assert.IsTrue(skp.Geometry.MeshCount >= skp.Surfaces.Count);
+            foreach (var srf in skp.Surfaces)
+            {
+                Assert.IsTrue(srf.OuterEdges.Edges.Count > 0);
+                Assert.IsTrue(srf.Vertices.Count > 0);
+                Assert.AreSame(srf.Vertices, srf.Vertices);
+            }
+        }
+
+        /// <summary>
+        /// Test merging face meshes into batches
+        /// </summary>
+        [TestMethod]
+        public void TestBatchedMeshes()
+        {
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.LoadModel(TestFile, true);
+
+            int triangles = 0;
+            foreach (var srf in skp.Surfaces)
+                triangles += srf.FaceMesh.TriangleCount;
+
+            int batched = 0;
+            foreach (var batch in skp.GetBatchedMeshes(BatchGrouping.Definition))
+            {
+                Assert.AreEqual(batch.Surfaces.Count + 1, batch.FaceTriangles.Length);
+                Assert.AreEqual(batch.Indices.Length / 3, batch.FaceTriangles[batch.Surfaces.Count]);
+                if (ReferenceEquals(batch.Definition, skp.Surfaces))
+                    batched = batch.Indices.Length / 3;
+            }
+            Assert.AreEqual(triangles, batched);
+            Assert.IsTrue(skp.GetBatchedMeshes(BatchGrouping.Material).Count > 0);
+        }
+
+        /// <summary>
+        /// Test loading a model from memory and from a memory-mapped file
+        /// </summary>
+        [TestMethod]
+        public void TestLoadFromBuffer()
+        {
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.LoadModel(TestFile, false);
+
+            SketchUpNET.SketchUp buffered = new SketchUp();
+            Assert.IsTrue(buffered.LoadModel(System.IO.File.ReadAllBytes(TestFile), false));
+            Assert.AreEqual(skp.Surfaces.Count, buffered.Surfaces.Count);
+
+            SketchUpNET.SketchUp mapped = new SketchUp();
+            Assert.IsTrue(mapped.LoadModelMapped(TestFile, false));
+            Assert.AreEqual(skp.Surfaces.Count, mapped.Surfaces.Count);
+        }
+
+        /// <summary>
+        /// Test loading faces with shared vertices and edges
+        /// </summary>
+        [TestMethod]
+        public void TestSharedTopology()
+        {
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.LoadModel(TestFile, false);
+            SketchUpNET.SketchUp shared = new SketchUp();
+            shared.LoadModel(TestFile, false, new LoadOptions() { SharedTopology = true });
+
+            Assert.IsTrue(shared.Geometry.SharedTopology);
+            Assert.AreEqual(skp.Surfaces.Count, shared.Surfaces.Count);
+            Assert.IsTrue(shared.Geometry.PointCount < skp.Geometry.PointCount);
+            Assert.IsTrue(shared.Geometry.EdgeCount <= skp.Geometry.EdgeCount);
+
+            // Every face loop edge is one half-edge; edges between faces of TestFile join exactly two
+            GeometryStore store = shared.Geometry;
+            int uses = 0, interior = 0;
+            for (int i = 0; i < store.EdgeCount; i++)
+            {
+                List<int> faces = store.GetEdgeFaces(i);
+                uses += faces.Count;
+                if (faces.Count > 1)
+                {
+                    Assert.AreEqual(2, faces.Count);
+                    Assert.IsTrue(store.GetAdjacentFaces(faces[0]).Contains(faces[1]));
+                    interior++;
+                }
+
+                int h = store.GetEdgeHalfEdge(i);
+                if (h >= 0)
+                    Assert.AreEqual(i, store.GetHalfEdge(h).Item1);
+            }
+            Assert.AreEqual(store.HalfEdgeCount, uses);
+            Assert.IsTrue(interior > 0);
+
+            for (int i = 0; i < store.PointCount; i++)
+            {
+                int h = store.GetPointHalfEdge(i);
+                if (h >= 0)
+                    Assert.AreEqual(i, store.GetHalfEdge(h).Item2);
+            }
+            for (int h = 0; h < store.HalfEdgeCount; h++)
+            {
+                Assert.IsTrue(store.GetEdgeHalfEdge(store.GetHalfEdge(h).Item1) >= 0);
+                Assert.IsTrue(store.GetPointHalfEdge(store.GetHalfEdge(h).Item2) >= 0);
+            }
+        }
+
+        /// <summary>
+        /// Test lazily converting a model through an open handle
+        /// </summary>
+        [TestMethod]
+        public void TestModelHandle()
+        {
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.LoadModel(TestFile, false);
+
+            using (ModelHandle model = new ModelHandle(TestFile))
+            {
+                Assert.AreEqual(skp.Layers.Count, model.Layers.Count);
+                Assert.AreEqual(0, model.Geometry.FaceCount);
+                Assert.AreEqual(skp.Surfaces.Count, model.Surfaces.Count);
+                Assert.AreSame(model.Surfaces, model.Surfaces);
+                foreach (var component in model.Components.Values)
+                    Assert.AreEqual(skp.Components[component.Guid].Surfaces.Count, component.Surfaces.Count);
+            }
+        }
+
+        /// <summary>
+        /// Test that a single-threaded load converts the same geometry in the same order as a parallel load
+        /// </summary>
+        [TestMethod]
+        public void TestSingleThreaded()
+        {
+            SketchUpNET.SketchUp parallel = new SketchUp();
+            Assert.IsTrue(parallel.LoadModel(TestFile, true));
+            SketchUpNET.SketchUp single = new SketchUp() { SingleThreaded = true };
+            Assert.IsTrue(single.LoadModel(TestFile, true));
+
+            Assert.AreEqual(parallel.Surfaces.Count, single.Surfaces.Count);
+            Assert.AreEqual(parallel.Edges.Count, single.Edges.Count);
+            Assert.AreEqual(parallel.Geometry.FaceCount, single.Geometry.FaceCount);
+            Assert.AreEqual(parallel.Geometry.EdgeCount, single.Geometry.EdgeCount);
+            Assert.AreEqual(parallel.Geometry.MeshCount, single.Geometry.MeshCount);
+            Assert.AreEqual(parallel.Geometry.PointCount, single.Geometry.PointCount);
+
+            for (int i = 0; i < parallel.Surfaces.Count; i++)
+            {
+                List<Vertex> expected = parallel.Surfaces[i].Vertices;
+                List<Vertex> actual = single.Surfaces[i].Vertices;
+                Assert.AreEqual(expected.Count, actual.Count);
+                for (int j = 0; j < expected.Count; j++)
+                {
+                    Assert.AreEqual(expected[j].X, actual[j].X);
+                    Assert.AreEqual(expected[j].Y, actual[j].Y);
+                    Assert.AreEqual(expected[j].Z, actual[j].Z);
+                }
+                CollectionAssert.AreEqual(parallel.Surfaces[i].FaceMesh.GetPositions(), single.Surfaces[i].FaceMesh.GetPositions());
+                CollectionAssert.AreEqual(parallel.Surfaces[i].FaceMesh.GetIndices(), single.Surfaces[i].FaceMesh.GetIndices());
+            }
+
+            for (int i = 0; i < parallel.Edges.Count; i++)
+            {
+                Assert.AreEqual(parallel.Edges[i].Start.X, single.Edges[i].Start.X);
+                Assert.AreEqual(parallel.Edges[i].Start.Y, single.Edges[i].Start.Y);
+                Assert.AreEqual(parallel.Edges[i].Start.Z, single.Edges[i].Start.Z);
+                Assert.AreEqual(parallel.Edges[i].End.X, single.Edges[i].End.X);
+                Assert.AreEqual(parallel.Edges[i].End.Y, single.Edges[i].End.Y);
+                Assert.AreEqual(parallel.Edges[i].End.Z, single.Edges[i].End.Z);
+            }
+        }
+
+        /// <summary>
+        /// Test that definitions and group bodies are converted once and shared by all of their placements
+        /// </summary>
+        [TestMethod]
+        public void TestSharedDefinitions()
+        {
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.LoadModel(TestFile, false);
+
+            // Walk every body once, copies of a group are recognized by their shared surface list
+            Dictionary<List<Surface>, Group> bodies = new Dictionary<List<Surface>, Group>();
+            List<Instance> instances = new List<Instance>(skp.Instances);
+            Stack<Group> groups = new Stack<Group>(skp.Groups);
+            int faces = skp.Surfaces.Count;
+            foreach (var component in skp.Components.Values)
+            {
+                faces += component.Surfaces.Count;
+                instances.AddRange(component.Instances);
+                foreach (var group in component.Groups)
+                    groups.Push(group);
+            }
+            while (groups.Count > 0)
+            {
+                Group group = groups.Pop();
+                Group first;
+                if (bodies.TryGetValue(group.Surfaces, out first))
+                {
+                    Assert.AreSame(first.Edges, group.Edges);
+                    Assert.AreSame(first.Curves, group.Curves);
+                    Assert.AreSame(first.Instances, group.Instances);
+                    Assert.AreSame(first.Groups, group.Groups);
+                    continue;
+                }
+                bodies.Add(group.Surfaces, group);
+                faces += group.Surfaces.Count;
+                instances.AddRange(group.Instances);
+                foreach (var child in group.Groups)
+                    groups.Push(child);
+            }
+
+            // A body converted again would add its faces to the store a second time
+            Assert.AreEqual(faces, skp.Geometry.FaceCount);
+            foreach (var instance in instances)
+                Assert.AreSame(skp.Components[instance.ParentID], instance.Parent);
+
+            // Three instances of a definition with a nested group resolve to one component converted once
+            Vertex[] corners = { new Vertex(0, 0, 0), new Vertex(1, 0, 0), new Vertex(1, 1, 0), new Vertex(0, 1, 0) };
+            List<Edge> edges = new List<Edge>();
+            for (int c = 0; c < 4; c++)
+                edges.Add(new Edge(corners[c], corners[(c + 1) % 4]));
+            List<Surface> square = new List<Surface>() { new Surface(new Loop(edges)) };
+            Group frame = new Group("Frame", square, new List<Curve>(), new List<Edge>(), new List<Instance>(), new List<Group>(), null, "Layer0", null, null);
+            Component panel = new Component("Panel", "panel-guid", square, new List<Curve>(), new List<Edge>(), new List<Instance>(), "Facade panel", new List<Group>() { frame });
+
+            SketchUpNET.SketchUp writer = new SketchUp();
+            writer.Surfaces = new List<Surface>();
+            writer.Edges = new List<Edge>();
+            writer.Curves = new List<Curve>();
+            writer.Groups = new List<Group>();
+            writer.Components = new Dictionary<string, Component>() { { panel.Guid, panel } };
+            writer.Instances = new List<Instance>();
+            for (int i = 0; i < 3; i++)
+            {
+                Transform move = new Transform(new double[] { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 2 * i, 0, 0, 1 });
+                writer.Instances.Add(new Instance("Panel " + i, null, panel.Guid, move, "Layer0", null));
+            }
+            writer.WriteNewModel(@"TempSharedModel.skp");
+
+            SketchUpNET.SketchUp shared = new SketchUp();
+            Assert.IsTrue(shared.LoadModel(@"TempSharedModel.skp"));
+            Assert.AreEqual(3, shared.Instances.Count);
+            Component parent = (Component)shared.Instances[0].Parent;
+            Assert.AreSame(shared.Components[parent.Guid], parent);
+            foreach (var instance in shared.Instances)
+                Assert.AreSame(parent, instance.Parent);
+            Assert.AreEqual(1, parent.Groups.Count);
+            Assert.AreEqual(2, shared.Geometry.FaceCount);
+        }
+
+        /// <summary>
+        /// Test that surfaces on one layer or with one material share the interned name and material
+        /// </summary>
+        [TestMethod]
+        public void TestInternedLayersAndMaterials()
+        {
+            Material brick = new Material() { Name = "Brick", Colour = new Color(255, 150, 60, 40) };
+            Material slate = new Material() { Name = "Slate", Colour = new Color(255, 60, 60, 70) };
+
+            SketchUpNET.SketchUp skp = new SketchUp();
+            skp.Surfaces = new List<Surface>();
+            skp.Edges = new List<Edge>();
+            skp.Curves = new List<Curve>();
+            for (int i = 0; i < 6; i++)
+            {
+                Vertex[] corners = { new Vertex(2 * i, 0, 0), new Vertex(2 * i + 1, 0, 0), new Vertex(2 * i + 1, 1, 0), new Vertex(2 * i, 1, 0) };
+                List<Edge> edges = new List<Edge>();
+                for (int c = 0; c < 4; c++)
+                    edges.Add(new Edge(corners[c], corners[(c + 1) % 4]));
+                Surface surface = new Surface(new Loop(edges));
+                surface.Layer = (i % 2 == 0) ? "Walls" : "Roof";
+                surface.FrontMaterial = (i % 2 == 0) ? brick : slate;
+                skp.Surfaces.Add(surface);
+            }
+            skp.WriteNewModel(@"TempInternedModel.skp");
+
+            SketchUpNET.SketchUp loaded = new SketchUp();
+            Assert.IsTrue(loaded.LoadModel(@"TempInternedModel.skp"));
+            Assert.AreEqual(6, loaded.Surfaces.Count);
+
+            List<string> layerNames = new List<string>();
+            foreach (var layer in loaded.Layers)
+                layerNames.Add(layer.Name);
+            Assert.IsTrue(layerNames.Contains("Walls"));
+            Assert.IsTrue(layerNames.Contains("Roof"));
+
+            Dictionary<string, string> layers = new Dictionary<string, string>();
+            int walls = 0;
+            foreach (var srf in loaded.Surfaces)
+            {
+                string first;
+                if (layers.TryGetValue(srf.Layer, out first))
+                    Assert.AreSame(first, srf.Layer);
+                else
+                    layers.Add(srf.Layer, srf.Layer);
+
+                // Names round-trip and every face resolves to the material of the model
+                Assert.AreEqual(srf.Layer == "Walls" ? "Brick" : "Slate", srf.FrontMaterial.Name);
+                Assert.AreSame(loaded.Materials[srf.FrontMaterial.Name], srf.FrontMaterial);
+                if (srf.Layer == "Walls")
+                    walls++;
+            }
+            Assert.AreEqual(3, walls);
+            Assert.AreEqual(2, layers.Count);
+
+            // Faces without a material share one default
+            SketchUpNET.SketchUp model = new SketchUp();
+            model.LoadModel(TestFile, false);
+            Dictionary<string, Material> materials = new Dictionary<string, Material>();
+            Dictionary<string, string> modelLayers = new Dictionary<string, string>();
+            foreach (var srf in model.Surfaces)
+            {
+                string name = srf.FrontMaterial.Name ?? string.Empty;
+                Material material;
+                if (materials.TryGetValue(name, out material))
+                    Assert.AreSame(material, srf.FrontMaterial);
+                else
+                    materials.Add(name, srf.FrontMaterial);
+
+                string layer;
+                if (modelLayers.TryGetValue(srf.Layer, out layer))
+                    Assert.AreSame(layer, srf.Layer);
+                else
+                    modelLayers.Add(srf.Layer, srf.Layer);
+            }
+        }
+
+        /// <summary>
+        /// Test that sessions, handles and loads keep the SketchUp API initialized until their last user leaves
+        /// </summary>
+        [TestMethod]
+        public void TestSessionRefCount()
+        {
+            Assert.IsFalse(SketchUpSession.IsActive);
+
+            // Nested sessions and the loads inside them share one initialization
+            using (new SketchUpSession())
+            {
+                Assert.IsTrue(SketchUpSession.IsActive);
+                using (new SketchUpSession())
+                {
+                    Assert.IsTrue(new SketchUp().LoadModel(TestFile));
+                    Assert.IsTrue(SketchUpSession.IsActive);
+                }
+                Assert.IsTrue(SketchUpSession.IsActive);
+                Assert.IsTrue(new SketchUp().LoadModel(TestFile));
+                Assert.IsTrue(SketchUpSession.IsActive);
+            }
+            Assert.IsFalse(SketchUpSession.IsActive);
+
+            // A load finishing while a handle is open must not terminate the API under the handle
+            using (ModelHandle model = new ModelHandle(TestFile))
+            {
+                Assert.IsTrue(SketchUpSession.IsActive);
+                SketchUpNET.SketchUp skp = new SketchUp();
+                Assert.IsTrue(skp.LoadModel(TestFile));
+                Assert.IsTrue(SketchUpSession.IsActive);
+                Assert.AreEqual(skp.Surfaces.Count, model.Surfaces.Count);
+            }
+            Assert.IsFalse(SketchUpSession.IsActive);
+
+            // Failed loads leave the count balanced
+            Assert.IsFalse(new SketchUp().LoadModel(@"NoSuchModel.skp"));
+            Assert.IsFalse(SketchUpSession.IsActive);
+            Assert.IsFalse(new SketchUp().LoadModel(new byte[] { 1, 2, 3, 4 }, false));
+            Assert.IsFalse(SketchUpSession.IsActive);
+            try
+            {
+                new ModelHandle(@"NoSuchModel.skp");
+                Assert.Fail();
+            }
+            catch (System.IO.IOException)
+            {
+            }
+            Assert.IsFalse(SketchUpSession.IsActive);
+
+            using (new SketchUpSession())
+            {
+                Assert.IsFalse(new SketchUp().LoadModel(@"NoSuchModel.skp"));
+                Assert.IsTrue(SketchUpSession.IsActive);
+            }
+            Assert.IsFalse(SketchUpSession.IsActive);
+        }
+
         /// <summary>
         /// Test saving file as
         /// </summary>
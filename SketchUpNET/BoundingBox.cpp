@@ -0,0 +1,205 @@
+/*
+
+SketchUpNET - a C++ Wrapper for the Trimble(R) SketchUp(R) C API
+Copyright(C) 2015, Autor: Maximilian Thumfart
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+#pragma once
+
+#include <SketchUpAPI/slapi.h>
+#include <SketchUpAPI/geometry.h>
+#include <SketchUpAPI/model/drawing_element.h>
+#include <SketchUpAPI/model/entities.h>
+#include "Vertex.h"
+#include "Transform.h"
+
+using namespace System;
+using namespace System::Collections;
+using namespace System::Collections::Generic;
+
+namespace SketchUpNET
+{
+	/// <summary>
+	/// Axis aligned box in meters
+	/// </summary>
+	public ref class BoundingBox
+	{
+	public:
+		/// <summary>
+		/// Corner with the smallest coordinates
+		/// </summary>
+		Vertex^ Min;
+
+		/// <summary>
+		/// Corner with the largest coordinates
+		/// </summary>
+		Vertex^ Max;
+
+		BoundingBox(Vertex^ min, Vertex^ max)
+		{
+			this->Min = min;
+			this->Max = max;
+		};
+
+		/// <summary>
+		/// Creates an empty box, the union with any box is that box
+		/// </summary>
+		BoundingBox()
+		{
+			this->Min = gcnew Vertex(Double::PositiveInfinity, Double::PositiveInfinity, Double::PositiveInfinity);
+			this->Max = gcnew Vertex(Double::NegativeInfinity, Double::NegativeInfinity, Double::NegativeInfinity);
+		};
+
+		/// <summary>
+		/// The box contains no point
+		/// </summary>
+		property bool IsEmpty
+		{
+			bool get() { return Min->X > Max->X || Min->Y > Max->Y || Min->Z > Max->Z; }
+		}
+
+		/// <summary>
+		/// Center point of the box
+		/// </summary>
+		property Vertex^ Center
+		{
+			Vertex^ get() { return gcnew Vertex((Min->X + Max->X) / 2, (Min->Y + Max->Y) / 2, (Min->Z + Max->Z) / 2); }
+		}
+
+		/// <summary>
+		/// The point lies inside or on the box
+		/// </summary>
+		bool Contains(Vertex^ point)
+		{
+			return point->X >= Min->X && point->X <= Max->X
+				&& point->Y >= Min->Y && point->Y <= Max->Y
+				&& point->Z >= Min->Z && point->Z <= Max->Z;
+		}
+
+		/// <summary>
+		/// The boxes overlap or touch
+		/// </summary>
+		bool Intersects(BoundingBox^ other)
+		{
+			return Min->X <= other->Max->X && Max->X >= other->Min->X
+				&& Min->Y <= other->Max->Y && Max->Y >= other->Min->Y
+				&& Min->Z <= other->Max->Z && Max->Z >= other->Min->Z;
+		}
+
+		/// <summary>
+		/// Smallest box containing both boxes
+		/// </summary>
+		BoundingBox^ Union(BoundingBox^ other)
+		{
+			return gcnew BoundingBox(
+				gcnew Vertex(Math::Min(Min->X, other->Min->X), Math::Min(Min->Y, other->Min->Y), Math::Min(Min->Z, other->Min->Z)),
+				gcnew Vertex(Math::Max(Max->X, other->Max->X), Math::Max(Max->Y, other->Max->Y), Math::Max(Max->Z, other->Max->Z)));
+		}
+
+		/// <summary>
+		/// Axis aligned box around the eight transformed corners
+		/// </summary>
+		BoundingBox^ Transformed(Transform^ transform)
+		{
+			if (IsEmpty || transform == nullptr)
+				return this;
+
+			array<double>^ corners = gcnew array<double>(24);
+			for (int i = 0; i < 8; i++)
+			{
+				corners[3 * i] = (i & 1) ? Max->X : Min->X;
+				corners[3 * i + 1] = (i & 2) ? Max->Y : Min->Y;
+				corners[3 * i + 2] = (i & 4) ? Max->Z : Min->Z;
+			}
+			transform->TransformPoints(corners);
+
+			double box[6] = { corners[0], corners[1], corners[2], corners[0], corners[1], corners[2] };
+			for (int i = 1; i < 8; i++)
+				for (int a = 0; a < 3; a++)
+				{
+					box[a] = Math::Min(box[a], corners[3 * i + a]);
+					box[3 + a] = Math::Max(box[3 + a], corners[3 * i + a]);
+				}
+			return FromArray(box);
+		}
+
+	internal:
+		static BoundingBox^ FromSU(const SUBoundingBox3D& box)
+		{
+			return gcnew BoundingBox(
+				gcnew Vertex(box.min_point.x * 0.0254, box.min_point.y * 0.0254, box.min_point.z * 0.0254),
+				gcnew Vertex(box.max_point.x * 0.0254, box.max_point.y * 0.0254, box.max_point.z * 0.0254));
+		}
+
+		/// <summary>
+		/// Bounds of a drawing element in the coordinates of the entities containing it, null if it has none
+		/// </summary>
+		static BoundingBox^ FromSU(SUDrawingElementRef element)
+		{
+			SUBoundingBox3D box;
+			if (SUDrawingElementGetBoundingBox(element, &box) != SU_ERROR_NONE)
+				return nullptr;
+			return FromSU(box);
+		}
+
+		/// <summary>
+		/// Bounds of the contents of an entities collection in its own coordinates, null if it has none
+		/// </summary>
+		static BoundingBox^ FromSU(SUEntitiesRef entities)
+		{
+			SUBoundingBox3D box;
+			if (SUEntitiesGetBoundingBox(entities, &box) != SU_ERROR_NONE)
+				return nullptr;
+			return FromSU(box);
+		}
+
+		/// <summary>
+		/// Box from min xyz followed by max xyz
+		/// </summary>
+		static BoundingBox^ FromArray(const double* box)
+		{
+			return gcnew BoundingBox(gcnew Vertex(box[0], box[1], box[2]), gcnew Vertex(box[3], box[4], box[5]));
+		}
+
+		static BoundingBox^ FromPoints(List<Vertex^>^ points)
+		{
+			BoundingBox^ result = gcnew BoundingBox();
+			if (points == nullptr || points->Count == 0)
+				return result;
+
+			double box[6] = { points[0]->X, points[0]->Y, points[0]->Z, points[0]->X, points[0]->Y, points[0]->Z };
+			for each (Vertex^ p in points)
+			{
+				box[0] = Math::Min(box[0], p->X); box[3] = Math::Max(box[3], p->X);
+				box[1] = Math::Min(box[1], p->Y); box[4] = Math::Max(box[4], p->Y);
+				box[2] = Math::Min(box[2], p->Z); box[5] = Math::Max(box[5], p->Z);
+			}
+			return FromArray(box);
+		}
+
+		/// <summary>
+		/// Writes min xyz followed by max xyz
+		/// </summary>
+		void CopyTo(double* target)
+		{
+			target[0] = Min->X; target[1] = Min->Y; target[2] = Min->Z;
+			target[3] = Max->X; target[4] = Max->Y; target[5] = Max->Z;
+		}
+	};
+
+
+}
\ No newline at end of file
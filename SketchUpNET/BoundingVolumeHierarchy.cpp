@@ -0,0 +1,631 @@
+/*
+
+SketchUpNET - a C++ Wrapper for the Trimble(R) SketchUp(R) C API
+Copyright(C) 2015, Autor: Maximilian Thumfart
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <numeric>
+#include <vector>
+#include "Utilities.h"
+#include "Vertex.h"
+#include "BoundingBox.h"
+
+using namespace System;
+using namespace System::Collections;
+using namespace System::Collections::Generic;
+
+namespace SketchUpNET
+{
+#pragma managed(push, off)
+	/// <summary>
+	/// Node of a bounding volume hierarchy. Inner nodes have two children, leaves a range of the item order.
+	/// </summary>
+	struct BvhNode
+	{
+		double Min[3];
+		double Max[3];
+		// Children of an inner node, -1 for leaves
+		int Left;
+		int Right;
+		// Range of Bvh::Order covered by a leaf
+		int Start;
+		int Count;
+	};
+
+	/// <summary>
+	/// Subtree built on its own and moved into the tree afterwards
+	/// </summary>
+	struct BvhJob
+	{
+		int Node;
+		int Start;
+		int Count;
+	};
+
+	/// <summary>
+	/// Region of a query: an optional box and optional planes a, b, c, d keeping the side where ax + by + cz + d >= 0
+	/// </summary>
+	struct BvhQuery
+	{
+		const double* Box;
+		const double* Planes;
+		int PlaneCount;
+	};
+
+	/// <summary>
+	/// Binned surface area heuristic hierarchy over axis aligned boxes, six values per item: min xyz then max xyz.
+	/// Items with empty boxes are left out of the tree.
+	/// </summary>
+	class Bvh
+	{
+	public:
+		static const int LeafSize = 4;
+		static const int Bins = 16;
+
+		std::vector<double> Boxes;
+		std::vector<int> Order;
+		std::vector<BvhNode> Nodes;
+
+		size_t ItemCount() const
+		{
+			return Boxes.size() / 6;
+		}
+
+		bool IsValid(size_t item) const
+		{
+			const double* b = &Boxes[6 * item];
+			return b[0] <= b[3] && b[1] <= b[4] && b[2] <= b[5];
+		}
+
+		// Builds the top of the tree. Ranges of at most jobSize items become leaves listed in jobs,
+		// a jobSize of zero builds the whole tree.
+		void BuildTop(int jobSize, std::vector<BvhJob>& jobs)
+		{
+			Order.clear();
+			Nodes.clear();
+			for (size_t i = 0; i < ItemCount(); i++)
+				if (IsValid(i))
+					Order.push_back((int)i);
+			if (Order.empty()) return;
+
+			Nodes.reserve(2 * Order.size() / LeafSize + 1);
+			Build(Nodes, 0, (int)Order.size(), jobSize, (jobSize > 0) ? &jobs : nullptr);
+		}
+
+		// Builds the subtree of a job into its own nodes, root first
+		void BuildJob(const BvhJob& job, std::vector<BvhNode>& nodes)
+		{
+			nodes.reserve(2 * job.Count / LeafSize + 1);
+			Build(nodes, job.Start, job.Count, 0, nullptr);
+		}
+
+		// Appends the nodes of a job, its root replaces the leaf standing in for it
+		void Stitch(const BvhJob& job, const std::vector<BvhNode>& nodes)
+		{
+			int offset = (int)Nodes.size() - 1;
+			for (size_t i = 1; i < nodes.size(); i++)
+				Nodes.push_back(Relocate(nodes[i], offset));
+			Nodes[job.Node] = Relocate(nodes[0], offset);
+		}
+
+		// Appends the items whose boxes meet the query, skipping items up to and including after
+		void Query(const BvhQuery& query, int after, std::vector<int>& hits) const
+		{
+			if (Nodes.empty()) return;
+
+			std::vector<int> stack;
+			stack.reserve(64);
+			stack.push_back(0);
+			while (!stack.empty())
+			{
+				const BvhNode& node = Nodes[stack.back()];
+				stack.pop_back();
+				if (!Meets(query, node.Min, node.Max)) continue;
+
+				if (node.Left < 0)
+				{
+					for (int i = node.Start; i < node.Start + node.Count; i++)
+					{
+						int item = Order[i];
+						if (item > after && Meets(query, &Boxes[6 * item], &Boxes[6 * item + 3]))
+							hits.push_back(item);
+					}
+					continue;
+				}
+
+				stack.push_back(node.Right);
+				stack.push_back(node.Left);
+			}
+		}
+
+	private:
+		static BvhNode Relocate(BvhNode node, int offset)
+		{
+			if (node.Left >= 0)
+			{
+				node.Left += offset;
+				node.Right += offset;
+			}
+			return node;
+		}
+
+		static bool Meets(const BvhQuery& query, const double* min, const double* max)
+		{
+			if (query.Box != nullptr)
+			{
+				const double* b = query.Box;
+				if (min[0] > b[3] || max[0] < b[0] || min[1] > b[4] || max[1] < b[1] || min[2] > b[5] || max[2] < b[2])
+					return false;
+			}
+			for (int p = 0; p < query.PlaneCount; p++)
+			{
+				// The corner furthest along the plane normal decides whether the box is completely outside
+				const double* plane = query.Planes + 4 * p;
+				double x = (plane[0] >= 0) ? max[0] : min[0];
+				double y = (plane[1] >= 0) ? max[1] : min[1];
+				double z = (plane[2] >= 0) ? max[2] : min[2];
+				if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0)
+					return false;
+			}
+			return true;
+		}
+
+		static double Area(const double* min, const double* max)
+		{
+			double dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+			return dx * dy + dy * dz + dz * dx;
+		}
+
+		static void Grow(double* min, double* max, const double* box)
+		{
+			for (int a = 0; a < 3; a++)
+			{
+				min[a] = (box[a] < min[a]) ? box[a] : min[a];
+				max[a] = (box[3 + a] > max[a]) ? box[3 + a] : max[a];
+			}
+		}
+
+		static void Clear(double* min, double* max)
+		{
+			for (int a = 0; a < 3; a++)
+			{
+				min[a] = DBL_MAX;
+				max[a] = -DBL_MAX;
+			}
+		}
+
+		// Twice the center of an item box along an axis
+		double Centroid(int item, int axis) const
+		{
+			return Boxes[6 * item + axis] + Boxes[6 * item + 3 + axis];
+		}
+
+		int Build(std::vector<BvhNode>& nodes, int start, int count, int jobSize, std::vector<BvhJob>* jobs)
+		{
+			BvhJob root = { (int)nodes.size(), start, count };
+			nodes.push_back(BvhNode());
+
+			std::vector<BvhJob> pending(1, root);
+			while (!pending.empty())
+			{
+				BvhJob task = pending.back();
+				pending.pop_back();
+
+				BvhNode node;
+				Clear(node.Min, node.Max);
+				for (int i = task.Start; i < task.Start + task.Count; i++)
+					Grow(node.Min, node.Max, &Boxes[6 * Order[i]]);
+				node.Left = node.Right = -1;
+				node.Start = task.Start;
+				node.Count = task.Count;
+
+				if (jobs != nullptr && task.Count <= jobSize && task.Count > LeafSize)
+				{
+					jobs->push_back(task);
+					nodes[task.Node] = node;
+					continue;
+				}
+
+				int mid = (task.Count > LeafSize) ? Split(node, task.Start, task.Count) : -1;
+				if (mid < 0)
+				{
+					nodes[task.Node] = node;
+					continue;
+				}
+
+				node.Left = (int)nodes.size();
+				node.Right = node.Left + 1;
+				node.Start = 0;
+				node.Count = 0;
+				nodes[task.Node] = node;
+				nodes.push_back(BvhNode());
+				nodes.push_back(BvhNode());
+
+				BvhJob right = { node.Right, mid, task.Start + task.Count - mid };
+				BvhJob left = { node.Left, task.Start, mid - task.Start };
+				pending.push_back(right);
+				pending.push_back(left);
+			}
+			return root.Node;
+		}
+
+		// Partitions a range at the cheapest of the bin borders of all three axes, -1 keeps it as a leaf
+		int Split(const BvhNode& node, int start, int count)
+		{
+			double cmin[3], cmax[3];
+			Clear(cmin, cmax);
+			for (int i = start; i < start + count; i++)
+				for (int a = 0; a < 3; a++)
+				{
+					double c = Centroid(Order[i], a);
+					cmin[a] = (c < cmin[a]) ? c : cmin[a];
+					cmax[a] = (c > cmax[a]) ? c : cmax[a];
+				}
+
+			double bestCost = DBL_MAX;
+			int bestAxis = -1;
+			int bestBin = 0;
+
+			for (int a = 0; a < 3; a++)
+			{
+				double extent = cmax[a] - cmin[a];
+				if (extent <= 0) continue;
+				double scale = Bins / extent;
+
+				int binCount[Bins] = {};
+				double binMin[Bins][3], binMax[Bins][3];
+				for (int b = 0; b < Bins; b++)
+					Clear(binMin[b], binMax[b]);
+
+				for (int i = start; i < start + count; i++)
+				{
+					int item = Order[i];
+					int b = std::min(Bins - 1, (int)((Centroid(item, a) - cmin[a]) * scale));
+					binCount[b]++;
+					Grow(binMin[b], binMax[b], &Boxes[6 * item]);
+				}
+
+				// Sweep from the right to get the cost of everything right of each border
+				double rightArea[Bins];
+				int rightCount[Bins];
+				double min[3], max[3];
+				Clear(min, max);
+				int n = 0;
+				for (int b = Bins - 1; b > 0; b--)
+				{
+					if (binCount[b] > 0)
+					{
+						double box[6] = { binMin[b][0], binMin[b][1], binMin[b][2], binMax[b][0], binMax[b][1], binMax[b][2] };
+						Grow(min, max, box);
+					}
+					n += binCount[b];
+					rightArea[b] = (n > 0) ? Area(min, max) : 0.0;
+					rightCount[b] = n;
+				}
+
+				Clear(min, max);
+				n = 0;
+				for (int b = 0; b < Bins - 1; b++)
+				{
+					if (binCount[b] > 0)
+					{
+						double box[6] = { binMin[b][0], binMin[b][1], binMin[b][2], binMax[b][0], binMax[b][1], binMax[b][2] };
+						Grow(min, max, box);
+					}
+					n += binCount[b];
+					if (n == 0 || rightCount[b + 1] == 0) continue;
+
+					double cost = Area(min, max) * n + rightArea[b + 1] * rightCount[b + 1];
+					if (cost < bestCost)
+					{
+						bestCost = cost;
+						bestAxis = a;
+						bestBin = b;
+					}
+				}
+			}
+
+			// Identical centroids cannot be binned, large ranges of them are halved in place
+			if (bestAxis < 0)
+				return (count > 4 * LeafSize) ? start + count / 2 : -1;
+
+			// Splitting costs one traversal step plus the children, a leaf tests all of its items
+			double area = Area(node.Min, node.Max);
+			if (count <= 4 * LeafSize && area > 0 && 1.0 + bestCost / area >= count)
+				return -1;
+
+			double scale = Bins / (cmax[bestAxis] - cmin[bestAxis]);
+			double low = cmin[bestAxis];
+			int* first = Order.data() + start;
+			int* middle = std::partition(first, first + count, [&](int item)
+			{
+				return std::min(Bins - 1, (int)((Centroid(item, bestAxis) - low) * scale)) <= bestBin;
+			});
+			int mid = start + (int)(middle - first);
+			if (mid == start || mid == start + count)
+				return start + count / 2;
+			return mid;
+		}
+	};
+#pragma managed(pop)
+
+	/// <summary>
+	/// Bounding volume hierarchy over axis aligned boxes for region queries, culling and overlap tests.
+	/// Built with the binned surface area heuristic; subtrees are built in parallel.
+	/// </summary>
+	public ref class BoundingVolumeHierarchy
+	{
+	public:
+		/// <summary>
+		/// Bounded objects in the order of their boxes, null if only boxes were given
+		/// </summary>
+		List<Object^>^ Items;
+
+		/// <summary>
+		/// Number of boxes the hierarchy was built from
+		/// </summary>
+		property int Count { int get() { return (int)Tree->ItemCount(); } }
+
+		/// <summary>
+		/// Number of nodes of the tree
+		/// </summary>
+		property int NodeCount { int get() { return (int)Tree->Nodes.size(); } }
+
+		/// <summary>
+		/// Bounds of all items, empty if there are none
+		/// </summary>
+		property BoundingBox^ Bounds
+		{
+			BoundingBox^ get()
+			{
+				if (Tree->Nodes.empty())
+					return gcnew BoundingBox();
+				const BvhNode& root = Tree->Nodes[0];
+				return gcnew BoundingBox(gcnew Vertex(root.Min[0], root.Min[1], root.Min[2]), gcnew Vertex(root.Max[0], root.Max[1], root.Max[2]));
+			}
+		}
+
+		/// <summary>
+		/// Box of an item
+		/// </summary>
+		/// <param name="item">Item index</param>
+		BoundingBox^ GetBounds(int item)
+		{
+			if (item < 0 || item >= Count)
+				throw gcnew ArgumentOutOfRangeException("item");
+			return BoundingBox::FromArray(&Tree->Boxes[6 * item]);
+		}
+
+		/// <summary>
+		/// Builds a hierarchy over boxes
+		/// </summary>
+		/// <param name="boxes">Boxes in meters, null or empty boxes are never returned by queries</param>
+		/// <param name="singleThreaded">Build on the calling thread only</param>
+		static BoundingVolumeHierarchy^ Build(IList<BoundingBox^>^ boxes, bool singleThreaded)
+		{
+			return Build(nullptr, boxes, singleThreaded);
+		}
+
+		/// <summary>
+		/// Builds a hierarchy over objects and their boxes
+		/// </summary>
+		/// <param name="items">Bounded objects, parallel to boxes</param>
+		/// <param name="boxes">Boxes in meters, null or empty boxes are never returned by queries</param>
+		/// <param name="singleThreaded">Build on the calling thread only</param>
+		static BoundingVolumeHierarchy^ Build(IList<Object^>^ items, IList<BoundingBox^>^ boxes, bool singleThreaded)
+		{
+			if (boxes == nullptr)
+				throw gcnew ArgumentNullException("boxes");
+			if (items != nullptr && items->Count != boxes->Count)
+				throw gcnew ArgumentException("Items and boxes must have the same length.", "items");
+
+			BoundingVolumeHierarchy^ bvh = gcnew BoundingVolumeHierarchy();
+			bvh->Items = (items == nullptr) ? nullptr : gcnew List<Object^>(items);
+			bvh->Tree->Boxes.resize(6 * (size_t)boxes->Count);
+			for (int i = 0; i < boxes->Count; i++)
+			{
+				double* target = &bvh->Tree->Boxes[6 * i];
+				if (boxes[i] == nullptr || boxes[i]->IsEmpty)
+				{
+					target[0] = target[1] = target[2] = 1.0;
+					target[3] = target[4] = target[5] = -1.0;
+				}
+				else
+					boxes[i]->CopyTo(target);
+			}
+			BvhBuilder::Run(bvh->Tree, singleThreaded);
+			return bvh;
+		}
+
+		/// <summary>
+		/// Indices of the items whose boxes intersect or touch a region
+		/// </summary>
+		/// <param name="region">Region in meters</param>
+		List<int>^ Query(BoundingBox^ region)
+		{
+			if (region == nullptr || region->IsEmpty)
+				return gcnew List<int>();
+
+			double box[6];
+			region->CopyTo(box);
+			BvhQuery query = { box, nullptr, 0 };
+			return Run(query);
+		}
+
+		/// <summary>
+		/// Items whose boxes intersect or touch a region, requires Items
+		/// </summary>
+		/// <param name="region">Region in meters</param>
+		List<Object^>^ QueryItems(BoundingBox^ region)
+		{
+			List<int>^ hits = Query(region);
+			List<Object^>^ result = gcnew List<Object^>(hits->Count);
+			for each (int hit in hits)
+				result->Add((Items == nullptr) ? nullptr : Items[hit]);
+			return result;
+		}
+
+		/// <summary>
+		/// Indices of the items whose boxes are not completely outside a convex volume such as a view frustum
+		/// </summary>
+		/// <param name="planes">Planes as a, b, c, d with the inside where ax + by + cz + d >= 0, coordinates in meters</param>
+		List<int>^ Cull(array<double>^ planes)
+		{
+			if (planes == nullptr || planes->Length % 4 != 0)
+				throw gcnew ArgumentException("Planes must be given as four values each.", "planes");
+			if (planes->Length == 0)
+				return Query(Bounds);
+
+			pin_ptr<double> p = &planes[0];
+			BvhQuery query = { nullptr, p, planes->Length / 4 };
+			return Run(query);
+		}
+
+		/// <summary>
+		/// All pairs of items with intersecting or touching boxes, the lower index first.
+		/// Serves as the broad phase of a clash test; items are tested in parallel.
+		/// </summary>
+		/// <param name="singleThreaded">Test on the calling thread only</param>
+		List<Tuple<int, int>^>^ FindOverlaps(bool singleThreaded)
+		{
+			int grain = 256;
+			int count = Count;
+			array<List<Tuple<int, int>^>^>^ chunks = gcnew array<List<Tuple<int, int>^>^>((count + grain - 1) / grain);
+			OverlapWorker^ worker = gcnew OverlapWorker(Tree, chunks, grain);
+			Utilities::ForRange(0, count, grain, gcnew Action<Tuple<int, int>^>(worker, &OverlapWorker::Run), singleThreaded);
+
+			List<Tuple<int, int>^>^ result = gcnew List<Tuple<int, int>^>();
+			for each (List<Tuple<int, int>^>^ chunk in chunks)
+				if (chunk != nullptr)
+					result->AddRange(chunk);
+			return result;
+		}
+
+	internal:
+		Bvh* Tree;
+
+		BoundingVolumeHierarchy()
+		{
+			Tree = new Bvh();
+		}
+
+		!BoundingVolumeHierarchy()
+		{
+			delete Tree;
+			Tree = nullptr;
+		}
+
+		List<int>^ Run(const BvhQuery& query)
+		{
+			std::vector<int> hits;
+			Tree->Query(query, -1, hits);
+			std::sort(hits.begin(), hits.end());
+
+			List<int>^ result = gcnew List<int>((int)hits.size());
+			for (size_t i = 0; i < hits.size(); i++)
+				result->Add(hits[i]);
+			return result;
+		}
+
+		/// <summary>
+		/// Builds the nodes of a tree whose boxes are set.
+		/// The top levels are split on the calling thread, the subtrees below them across the thread pool.
+		/// </summary>
+		ref class BvhBuilder
+		{
+		public:
+			static void Run(Bvh* tree, bool singleThreaded)
+			{
+				int count = (int)tree->ItemCount();
+				int jobSize = singleThreaded ? 0 : Math::Max(4096, count / (8 * Environment::ProcessorCount));
+
+				std::vector<BvhJob> jobs;
+				tree->BuildTop(jobSize, jobs);
+				if (jobs.empty()) return;
+
+				std::vector<std::vector<BvhNode>> parts(jobs.size());
+				BvhBuilder^ builder = gcnew BvhBuilder(tree, &jobs, &parts);
+				Utilities::ForRange(0, (int)jobs.size(), 1, gcnew Action<Tuple<int, int>^>(builder, &BvhBuilder::Build), false);
+
+				for (size_t i = 0; i < jobs.size(); i++)
+					tree->Stitch(jobs[i], parts[i]);
+			}
+
+			void Build(Tuple<int, int>^ range)
+			{
+				for (int i = range->Item1; i < range->Item2; i++)
+					tree->BuildJob((*jobs)[i], (*parts)[i]);
+			}
+
+		private:
+			BvhBuilder(Bvh* tree, std::vector<BvhJob>* jobs, std::vector<std::vector<BvhNode>>* parts)
+			{
+				this->tree = tree;
+				this->jobs = jobs;
+				this->parts = parts;
+			}
+
+			Bvh* tree;
+			std::vector<BvhJob>* jobs;
+			std::vector<std::vector<BvhNode>>* parts;
+		};
+
+	private:
+		/// <summary>
+		/// Queries the tree with the boxes of a range of items, each chunk of the range fills its own list
+		/// </summary>
+		ref class OverlapWorker
+		{
+		public:
+			OverlapWorker(Bvh* tree, array<List<Tuple<int, int>^>^>^ chunks, int grain)
+			{
+				this->tree = tree;
+				this->chunks = chunks;
+				this->grain = grain;
+			}
+
+			void Run(Tuple<int, int>^ range)
+			{
+				List<Tuple<int, int>^>^ pairs = gcnew List<Tuple<int, int>^>();
+				std::vector<int> hits;
+				for (int i = range->Item1; i < range->Item2; i++)
+				{
+					if (!tree->IsValid(i)) continue;
+
+					hits.clear();
+					BvhQuery query = { &tree->Boxes[6 * i], nullptr, 0 };
+					tree->Query(query, i, hits);
+					std::sort(hits.begin(), hits.end());
+					for (size_t h = 0; h < hits.size(); h++)
+						pairs->Add(gcnew Tuple<int, int>(i, hits[h]));
+				}
+				chunks[range->Item1 / grain] = pairs;
+			}
+
+		private:
+			Bvh* tree;
+			array<List<Tuple<int, int>^>^>^ chunks;
+			int grain;
+		};
+	};
+
+	
+}
\ No newline at end of file
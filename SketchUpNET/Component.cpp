@@ -40,6 +40,8 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include "utilities.h"
 #include "Transform.h"
 #include "Instance.h"
+#include "LoadContext.h"
+#include "BoundingBox.h"
 
 using namespace System;
 using namespace System::Collections;
@@ -52,61 +54,153 @@ namespace SketchUpNET
 	public:
 		System::String^ Name;
 		System::String^ Description;
-		List<Surface^>^ Surfaces;
-		List<Instance^>^ Instances;
 		System::String^ Guid;
-		List<Curve^>^ Curves;
-		List<Edge^>^ Edges;
-		List<Group^>^ Groups;
+
+		/// <summary>
+		/// Bounds of the definition contents in definition coordinates, read without loading a lazy body
+		/// </summary>
+		BoundingBox^ Bounds;
+
+		property List<Surface^>^ Surfaces
+		{
+			List<Surface^>^ get() { LoadBody(); return surfaces; }
+			void set(List<Surface^>^ value) { LoadBody(); surfaces = value; }
+		}
+
+		property List<Instance^>^ Instances
+		{
+			List<Instance^>^ get() { LoadBody(); return instances; }
+			void set(List<Instance^>^ value) { LoadBody(); instances = value; }
+		}
+
+		property List<Curve^>^ Curves
+		{
+			List<Curve^>^ get() { LoadBody(); return curves; }
+			void set(List<Curve^>^ value) { LoadBody(); curves = value; }
+		}
+
+		property List<Edge^>^ Edges
+		{
+			List<Edge^>^ get() { LoadBody(); return edges; }
+			void set(List<Edge^>^ value) { LoadBody(); edges = value; }
+		}
+
+		property List<Group^>^ Groups
+		{
+			List<Group^>^ get() { LoadBody(); return groups; }
+			void set(List<Group^>^ value) { LoadBody(); groups = value; }
+		}
 
 		Component(System::String^ name, System::String^ guid, List<Surface^>^ surfaces, List<Curve^>^ curves, List<Edge^>^ edges, List<Instance^>^ instances, System::String^ desc, List<Group^>^ groups)
 		{
 			this->Name = name;
-			this->Surfaces = surfaces;
+			this->surfaces = surfaces;
 			this->Guid = guid;
-			this->Curves = curves;
-			this->Edges = edges;
+			this->curves = curves;
+			this->edges = edges;
 			this->Description = desc;
-			this->Instances = instances;
-			this->Groups = groups;
+			this->instances = instances;
+			this->groups = groups;
 		};
 
 		Component(){};
 	internal:
-		static Component^ FromSU(SUComponentDefinitionRef comp, bool includeMeshes, System::Collections::Generic::Dictionary<String^, Material^>^ materials)
+		static Component^ FromSU(SUComponentDefinitionRef comp, LoadContext^ context)
 		{
-			SUStringRef name = SU_INVALID;
-			SUStringCreate(&name);
-			SUComponentDefinitionGetName(comp, &name);
+			// Each definition is converted only once per load
+			Component^ cached = nullptr;
+			if (context->Definitions->TryGetValue(LoadContext::Key(comp), cached))
+				return cached;
 
-			SUStringRef desc = SU_INVALID;
-			SUStringCreate(&desc);
-			SUComponentDefinitionGetDescription(comp, &desc);
+			Utilities::StringRef name;
+			SUComponentDefinitionGetName(comp, &name.Ref);
 
-			SUEntitiesRef entities = SU_INVALID;
-			SUComponentDefinitionGetEntities(comp, &entities);
+			Utilities::StringRef desc;
+			SUComponentDefinitionGetDescription(comp, &desc.Ref);
 
-			size_t faceCount = 0;
-			SUEntitiesGetNumFaces(entities, &faceCount);
-			
-			
-			SUStringRef guid = SU_INVALID;
-			SUStringCreate(&guid);
-			SUComponentDefinitionGetGuid(comp, &guid);
+			Utilities::StringRef guid;
+			SUComponentDefinitionGetGuid(comp, &guid.Ref);
 
-			List<Surface^>^ surfaces = Surface::GetEntitySurfaces(entities, includeMeshes, materials);
-			List<Curve^>^ curves = Curve::GetEntityCurves(entities);
-			List<Edge^>^ edges = Edge::GetEntityEdges(entities);
-			List<Instance^>^ instances = Instance::GetEntityInstances(entities, materials);
-			List<Group^>^ grps = Group::GetEntityGroups(entities, includeMeshes, materials);
-			
-			
+			SUEntitiesRef entities = SU_INVALID;
+			SUComponentDefinitionGetEntities(comp, &entities);
 
-			Component^ v = gcnew Component(Utilities::GetString(name), Utilities::GetString(guid), surfaces, curves, edges,instances, Utilities::GetString(desc), grps);
+			Component^ v;
+			if (context->Lazy)
+			{
+				// Only the metadata is read now, the body follows on first access
+				v = gcnew Component(name.Value(), guid.Value(), nullptr, nullptr, nullptr, nullptr, desc.Value(), nullptr);
+				v->context = context;
+				v->definition = LoadContext::Key(comp);
+			}
+			else
+			{
+				List<Surface^>^ surfaces = Surface::GetEntitySurfaces(entities, context);
+				List<Curve^>^ curves = Curve::GetEntityCurves(entities, context);
+				List<Edge^>^ edges = Edge::GetEntityEdges(entities, context);
+				List<Instance^>^ instances = Instance::GetEntityInstances(entities, context);
+				List<Group^>^ grps = Group::GetEntityGroups(entities, context);
+
+				v = gcnew Component(name.Value(), guid.Value(), surfaces, curves, edges, instances, desc.Value(), grps);
+			}
+
+			v->Bounds = BoundingBox::FromSU(entities);
+			context->Definitions->Add(LoadContext::Key(comp), v);
 
 			return v;
 		};
 
+		/// <summary>
+		/// Conversion phase for everything extracted into the context since the last call:
+		/// scales the new geometry, builds the pending surfaces and resolves instance parents.
+		/// </summary>
+		static void Convert(LoadContext^ context)
+		{
+			context->Store->Commit(context->SingleThreaded);
+			SurfaceBuilder::Run(context);
+
+			for (int i = context->ResolvedInstances; i < context->Instances->Count; i++)
+			{
+				Instance^ instance = context->Instances[i];
+				Component^ parent = nullptr;
+				if (context->Definitions->TryGetValue(instance->Definition, parent))
+					instance->Parent = parent;
+			}
+			context->ResolvedInstances = context->Instances->Count;
+		}
+
+	private:
+		List<Surface^>^ surfaces;
+		List<Instance^>^ instances;
+		List<Curve^>^ curves;
+		List<Edge^>^ edges;
+		List<Group^>^ groups;
+
+		LoadContext^ context;
+		IntPtr definition;
+
+		void LoadBody()
+		{
+			if (context == nullptr)
+				return;
+
+			if (!context->ModelOpen)
+				throw gcnew ObjectDisposedException("ModelHandle", "The model of this component has been closed before its body was loaded.");
+
+			LoadContext^ c = context;
+			context = nullptr;
+
+			SUComponentDefinitionRef comp = { definition.ToPointer() };
+			SUEntitiesRef entities = SU_INVALID;
+			SUComponentDefinitionGetEntities(comp, &entities);
+
+			surfaces = Surface::GetEntitySurfaces(entities, c);
+			curves = Curve::GetEntityCurves(entities, c);
+			edges = Edge::GetEntityEdges(entities, c);
+			instances = Instance::GetEntityInstances(entities, c);
+			groups = Group::GetEntityGroups(entities, c);
+
+			Convert(c);
+		}
 	};
 
 
@@ -70,7 +70,7 @@ namespace SketchUpNET
 
 	internal:
 
-		static Curve^ FromSU(SUCurveRef curve)
+		static Curve^ FromSU(SUCurveRef curve, GeometryStore^ store)
 		{
 			List<Edge^>^ edgelist = gcnew List<Edge^>();
 
@@ -83,7 +83,7 @@ namespace SketchUpNET
 
 				for (size_t j = 0; j < edgecount; j++)
 				{
-					edgelist->Add(Edge::FromSU(edges[j]));
+					edgelist->Add(Edge::FromSU(edges[j], store));
 				}
 			}
 
@@ -124,10 +124,14 @@ namespace SketchUpNET
 			return result;
 		}
 
-		static List<Curve^>^ GetEntityCurves(SUEntitiesRef entities)
+		static List<Curve^>^ GetEntityCurves(SUEntitiesRef entities, LoadContext^ context)
 		{
 			List<Curve^>^ curves = gcnew List<Curve^>();
 
+			const EntityFilter* filter = context->FilterFor(entities);
+			if (filter != nullptr && !filter->Includes(EntityKinds::Curves))
+				return curves;
+
 			// GetCurves
 			size_t curveCount = 0;
 			SUEntitiesGetNumCurves(entities, &curveCount);
@@ -138,7 +142,9 @@ namespace SketchUpNET
 
 
 				for (size_t i = 0; i < curveCount; i++) {
-					Curve^ curve = Curve::FromSU(curvevector[i]);
+					if (filter != nullptr && !Curve::Accepts(curvevector[i], filter))
+						continue;
+					Curve^ curve = Curve::FromSU(curvevector[i], context->Store);
 					curves->Add(curve);
 				}
 			}
@@ -146,6 +152,17 @@ namespace SketchUpNET
 			return curves;
 		}
 
+	private:
+
+		// Curves are not drawing elements, their first edge carries layer and visibility
+		static bool Accepts(SUCurveRef curve, const EntityFilter* filter)
+		{
+			SUEdgeRef edge = SU_INVALID;
+			size_t edgecount = 0;
+			SUCurveGetEdges(curve, 1, &edge, &edgecount);
+			return edgecount == 0 || filter->Accepts(SUEdgeToDrawingElement(edge));
+		}
+
 
 	};
 
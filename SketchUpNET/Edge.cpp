@@ -36,6 +36,8 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include <vector>
 #include "vertex.h"
 #include "utilities.h"
+#include "GeometryStore.h"
+#include "LoadContext.h"
 
 using namespace System;
 using namespace System::Collections;
@@ -47,8 +49,34 @@ namespace SketchUpNET
 	{
 	public:
 
-		Vertex^ Start;
-		Vertex^ End;
+		/// <summary>
+		/// Startpoint of the edge
+		/// </summary>
+		property Vertex^ Start
+		{
+			Vertex^ get()
+			{
+				if (start == nullptr && store != nullptr)
+					start = store->GetPoint(store->Buffer->EdgePoints[2 * index]);
+				return start;
+			}
+			void set(Vertex^ value) { start = value; }
+		}
+
+		/// <summary>
+		/// Endpoint of the edge
+		/// </summary>
+		property Vertex^ End
+		{
+			Vertex^ get()
+			{
+				if (end == nullptr && store != nullptr)
+					end = store->GetPoint(store->Buffer->EdgePoints[2 * index + 1]);
+				return end;
+			}
+			void set(Vertex^ value) { end = value; }
+		}
+
 		System::String^ Layer;
 
 		/// <summary>
@@ -77,32 +105,49 @@ namespace SketchUpNET
 		};
 
 	internal:
-		static Edge^ FromSU(SUEdgeRef edge)
+		/// <summary>
+		/// Index of the stored edge viewed by this edge, -1 for edges created from vertices
+		/// </summary>
+		property long long StoreIndex
 		{
-			SUVertexRef startVertex = SU_INVALID;
-			SUVertexRef endVertex = SU_INVALID;
-			SUEdgeGetStartVertex(edge, &startVertex);
-			SUEdgeGetEndVertex(edge, &endVertex);
-			SUPoint3D start;
-			SUPoint3D end;
-			SUVertexGetPosition(startVertex, &start);
-			SUVertexGetPosition(endVertex, &end);
-
-			// Layer
-			SULayerRef layer = SU_INVALID;
-			SUDrawingElementGetLayer(SUEdgeToDrawingElement(edge), &layer);
-
-			System::String^ layername = gcnew System::String("");
-			if (!SUIsInvalid(layer))
-			{
-				layername = SketchUpNET::Utilities::GetLayerName(layer);
-			}
-			
-			Edge^ v = gcnew Edge(Vertex::FromSU(start), Vertex::FromSU(end), layername);
+			long long get() { return (store == nullptr) ? -1 : (long long)index; }
+		}
+
+		/// <summary>
+		/// Creates an edge view on a stored edge
+		/// </summary>
+		Edge(GeometryStore^ store, size_t index)
+		{
+			this->store = store;
+			this->index = index;
+			this->Layer = store->EdgeLayer(index);
+		};
+
+		static Edge^ FromSU(SUEdgeRef edge, GeometryStore^ store)
+		{
+			Edge^ v = gcnew Edge(store, store->AddEdge(edge));
 
 			return v;
 		};
 
+		/// <summary>
+		/// Writes start and end point as two xyz triples without creating vertices
+		/// </summary>
+		void CopyPoints(double* target)
+		{
+			if (start == nullptr && end == nullptr && store != nullptr)
+			{
+				GeometryBuffer* b = store->Buffer;
+				size_t s = b->EdgePoints[2 * index];
+				size_t e = b->EdgePoints[2 * index + 1];
+				target[0] = b->X[s]; target[1] = b->Y[s]; target[2] = b->Z[s];
+				target[3] = b->X[e]; target[4] = b->Y[e]; target[5] = b->Z[e];
+				return;
+			}
+			target[0] = Start->X; target[1] = Start->Y; target[2] = Start->Z;
+			target[3] = End->X; target[4] = End->Y; target[5] = End->Z;
+		}
+
 		SUEdgeRef ToSU()
 		{
 			SUEdgeRef edge = SU_INVALID;
@@ -123,10 +168,14 @@ namespace SketchUpNET
 			return result;
 		}
 
-		static List<Edge^>^ GetEntityEdges(SUEntitiesRef entities)
+		static List<Edge^>^ GetEntityEdges(SUEntitiesRef entities, LoadContext^ context)
 		{
 			List<Edge^>^ edges = gcnew List<Edge^>();
 
+			const EntityFilter* filter = context->FilterFor(entities);
+			if (filter != nullptr && !filter->Includes(EntityKinds::Edges))
+				return edges;
+
 			// Get Edges
 			size_t edgeCount = 0;
 			SUEntitiesGetNumEdges(entities, false, &edgeCount);
@@ -138,7 +187,9 @@ namespace SketchUpNET
 
 
 				for (size_t i = 0; i < edgeCount; i++) {
-					Edge^ edge = Edge::FromSU(edgevector[i]);
+					if (filter != nullptr && !filter->Accepts(SUEdgeToDrawingElement(edgevector[i])))
+						continue;
+					Edge^ edge = Edge::FromSU(edgevector[i], context->Store);
 					edges->Add(edge);
 				}
 			}
@@ -146,6 +197,11 @@ namespace SketchUpNET
 			return edges;
 		}
 
+	private:
+		Vertex^ start;
+		Vertex^ end;
+		GeometryStore^ store;
+		size_t index;
 
 	};
 
@@ -0,0 +1,994 @@
+/*
+
+SketchUpNET - a C++ Wrapper for the Trimble(R) SketchUp(R) C API
+Copyright(C) 2015, Autor: Maximilian Thumfart
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <SketchUpAPI/slapi.h>
+#include <SketchUpAPI/geometry.h>
+#include <SketchUpAPI/initialize.h>
+#include <SketchUpAPI/unicodestring.h>
+#include <SketchUpAPI/model/model.h>
+#include <SketchUpAPI/model/entities.h>
+#include <SketchUpAPI/model/face.h>
+#include <SketchUpAPI/model/edge.h>
+#include <SketchUpAPI/model/vertex.h>
+#include <SketchUpAPI/model/loop.h>
+#include <SketchUpAPI/model/edge_use.h>
+#include <SketchUpAPI/model/entity.h>
+#include <SketchUpAPI/model/layer.h>
+#include <SketchUpAPI/model/drawing_element.h>
+#include <SketchUpAPI/model/mesh_helper.h>
+#include <SketchUpAPI/model/texture_writer.h>
+#include <msclr/marshal.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "vertex.h"
+#include "vector.h"
+#include "MeshFace.h"
+#include "utilities.h"
+#include "LoadOptions.h"
+#include "BoundingBox.h"
+
+using namespace System;
+using namespace System::Collections;
+using namespace System::Collections::Generic;
+
+namespace SketchUpNET
+{
+	/// <summary>
+	/// Range of consecutive elements in one of the native geometry arrays
+	/// </summary>
+	struct GeometryRange
+	{
+		size_t Start;
+		size_t Count;
+	};
+
+	/// <summary>
+	/// Use of an edge by a face loop in the shared topology.
+	/// Next follows the loop, Radial links all uses of the same edge.
+	/// </summary>
+	struct HalfEdge
+	{
+		size_t Edge;
+		size_t Origin;
+		size_t Face;
+		size_t Next;
+		size_t Radial;
+	};
+
+	/// <summary>
+	/// Native structure-of-arrays storage of model geometry.
+	/// Coordinates are extracted in inches and converted to meters once the model is committed,
+	/// edges, loops, faces and meshes are index ranges.
+	/// </summary>
+	class GeometryBuffer
+	{
+	public:
+		// Points of all edges and face vertices
+		std::vector<double> X;
+		std::vector<double> Y;
+		std::vector<double> Z;
+
+		// Start and end point index of each edge and the interned layer of each edge
+		std::vector<size_t> EdgePoints;
+		std::vector<int> EdgeLayers;
+
+		// Edge indices of each loop
+		std::vector<size_t> LoopEdges;
+		std::vector<GeometryRange> Loops;
+
+		// Loops of each face (outer loop first) and point indices of each face
+		std::vector<GeometryRange> FaceLoops;
+		std::vector<size_t> FacePoints;
+		std::vector<GeometryRange> FaceVertices;
+
+		// Min xyz and max xyz of each face in meters, filled on commit
+		std::vector<double> FaceBounds;
+
+		// Mesh points, normals and triangle corner indices local to each mesh
+		std::vector<double> MeshX;
+		std::vector<double> MeshY;
+		std::vector<double> MeshZ;
+		std::vector<double> NormalX;
+		std::vector<double> NormalY;
+		std::vector<double> NormalZ;
+		std::vector<size_t> MeshIndices;
+		std::vector<GeometryRange> MeshPoints;
+		std::vector<GeometryRange> MeshNormals;
+		std::vector<GeometryRange> MeshTriangles;
+
+		// Front and back texture coordinates parallel to the mesh points, projected to u = s / q and v = t / q
+		// on commit. Q is only kept for the mesh points added since the last commit.
+		bool TextureCoordinates = false;
+		std::vector<double> FrontU;
+		std::vector<double> FrontV;
+		std::vector<double> BackU;
+		std::vector<double> BackV;
+		std::vector<double> FrontQ;
+		std::vector<double> BackQ;
+
+		// Shared topology: points and edges deduplicated by entity ID, one half-edge per loop edge
+		// parallel to LoopEdges, the first use of each edge and an outgoing half-edge of each point
+		bool Shared = false;
+		std::unordered_map<int32_t, size_t> VertexIds;
+		std::unordered_map<int32_t, size_t> EdgeIds;
+		std::vector<HalfEdge> HalfEdges;
+		std::vector<size_t> EdgeHalfEdge;
+		std::vector<size_t> PointHalfEdge;
+
+		// Points and mesh points already converted to meters
+		size_t CommittedPoints = 0;
+		size_t CommittedMeshPoints = 0;
+		size_t CommittedFaces = 0;
+
+		size_t AddPoint(const SUPoint3D& point)
+		{
+			X.push_back(point.x);
+			Y.push_back(point.y);
+			Z.push_back(point.z);
+			return X.size() - 1;
+		}
+
+		size_t EdgeCount() const
+		{
+			return EdgePoints.size() / 2;
+		}
+
+		size_t AddVertex(SUVertexRef vertex)
+		{
+			int32_t id = 0;
+			if (Shared)
+			{
+				SUEntityGetID(SUVertexToEntity(vertex), &id);
+				auto found = VertexIds.find(id);
+				if (found != VertexIds.end())
+					return found->second;
+			}
+
+			SUPoint3D point;
+			SUVertexGetPosition(vertex, &point);
+			size_t index = AddPoint(point);
+
+			if (Shared)
+			{
+				VertexIds.emplace(id, index);
+				PointHalfEdge.resize(X.size(), SIZE_MAX);
+			}
+			return index;
+		}
+
+		// Appends count homogeneous texture coordinates of which read were retrieved, the rest as zero
+		static void AddSTQ(const std::vector<SUPoint3D>& stq, size_t read, size_t count, std::vector<double>& u, std::vector<double>& v, std::vector<double>& q)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				bool valid = i < read;
+				u.push_back(valid ? stq[i].x : 0.0);
+				v.push_back(valid ? stq[i].y : 0.0);
+				q.push_back(valid ? stq[i].z : 1.0);
+			}
+		}
+
+		// Writes a range of split coordinates as interleaved xyz triples
+		template <typename T>
+		static void Interleave(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z, GeometryRange range, T* target)
+		{
+			const double* px = x.data() + range.Start;
+			const double* py = y.data() + range.Start;
+			const double* pz = z.data() + range.Start;
+			for (size_t i = 0; i < range.Count; i++)
+			{
+				target[3 * i] = (T)px[i];
+				target[3 * i + 1] = (T)py[i];
+				target[3 * i + 2] = (T)pz[i];
+			}
+		}
+
+		// Writes a range of split texture coordinates as interleaved uv pairs
+		template <typename T>
+		static void Interleave(const std::vector<double>& u, const std::vector<double>& v, GeometryRange range, T* target)
+		{
+			const double* pu = u.data() + range.Start;
+			const double* pv = v.data() + range.Start;
+			for (size_t i = 0; i < range.Count; i++)
+			{
+				target[2 * i] = (T)pu[i];
+				target[2 * i + 1] = (T)pv[i];
+			}
+		}
+
+		// Writes min xyz and max xyz of the vertices of a face
+		void FaceBox(size_t face, double* box) const
+		{
+			GeometryRange range = FaceVertices[face];
+			if (range.Count == 0)
+			{
+				box[0] = box[1] = box[2] = 0.0;
+				box[3] = box[4] = box[5] = 0.0;
+				return;
+			}
+			size_t p = FacePoints[range.Start];
+			box[0] = box[3] = X[p];
+			box[1] = box[4] = Y[p];
+			box[2] = box[5] = Z[p];
+			for (size_t i = range.Start + 1; i < range.Start + range.Count; i++)
+			{
+				p = FacePoints[i];
+				box[0] = (X[p] < box[0]) ? X[p] : box[0]; box[3] = (X[p] > box[3]) ? X[p] : box[3];
+				box[1] = (Y[p] < box[1]) ? Y[p] : box[1]; box[4] = (Y[p] > box[4]) ? Y[p] : box[4];
+				box[2] = (Z[p] < box[2]) ? Z[p] : box[2]; box[5] = (Z[p] > box[5]) ? Z[p] : box[5];
+			}
+		}
+
+		// Approximate native memory held by the buffer
+		size_t Bytes() const
+		{
+			return (X.capacity() + Y.capacity() + Z.capacity()
+				+ MeshX.capacity() + MeshY.capacity() + MeshZ.capacity()
+				+ NormalX.capacity() + NormalY.capacity() + NormalZ.capacity()
+				+ FrontU.capacity() + FrontV.capacity() + BackU.capacity() + BackV.capacity()
+				+ FrontQ.capacity() + BackQ.capacity() + FaceBounds.capacity()) * sizeof(double)
+				+ (EdgePoints.capacity() + LoopEdges.capacity() + FacePoints.capacity() + MeshIndices.capacity()) * sizeof(size_t)
+				+ EdgeLayers.capacity() * sizeof(int)
+				+ HalfEdges.capacity() * sizeof(HalfEdge)
+				+ (EdgeHalfEdge.capacity() + PointHalfEdge.capacity()) * sizeof(size_t)
+				+ (VertexIds.size() + EdgeIds.size()) * 2 * sizeof(size_t)
+				+ (Loops.capacity() + FaceLoops.capacity() + FaceVertices.capacity()
+				+ MeshPoints.capacity() + MeshNormals.capacity() + MeshTriangles.capacity()) * sizeof(GeometryRange);
+		}
+	};
+
+	/// <summary>
+	/// Converts a range of native coordinates from inches to meters
+	/// </summary>
+	ref class UnitScaler
+	{
+	public:
+		UnitScaler(double* x, double* y, double* z)
+		{
+			this->x = x;
+			this->y = y;
+			this->z = z;
+		}
+
+		void Scale(Tuple<int, int>^ range)
+		{
+			for (int i = range->Item1; i < range->Item2; i++)
+			{
+				x[i] *= 0.0254;
+				y[i] *= 0.0254;
+				z[i] *= 0.0254;
+			}
+		}
+
+		static void Run(std::vector<double>& x, std::vector<double>& y, std::vector<double>& z, size_t from, bool singleThreaded)
+		{
+			if (x.size() <= from) return;
+			UnitScaler^ scaler = gcnew UnitScaler(x.data(), y.data(), z.data());
+			Utilities::ForRange((int)from, (int)x.size(), 1 << 16, gcnew Action<Tuple<int, int>^>(scaler, &UnitScaler::Scale), singleThreaded);
+		}
+
+	private:
+		double* x;
+		double* y;
+		double* z;
+	};
+
+#pragma managed(push, off)
+	// Divides homogeneous texture coordinates by q. Compiled natively so the loop is vectorized.
+	inline void ProjectTextureCoordinates(double* s, double* t, const double* q, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			double w = (q[i] != 0.0) ? 1.0 / q[i] : 1.0;
+			s[i] *= w;
+			t[i] *= w;
+		}
+	}
+#pragma managed(pop)
+
+	/// <summary>
+	/// Projects a range of texture coordinates from stq to uv.
+	/// The q values start at the first coordinate of the run.
+	/// </summary>
+	ref class TextureProjector
+	{
+	public:
+		TextureProjector(double* s, double* t, const double* q, size_t from)
+		{
+			this->s = s;
+			this->t = t;
+			this->q = q;
+			this->from = from;
+		}
+
+		void Project(Tuple<int, int>^ range)
+		{
+			size_t start = (size_t)range->Item1;
+			ProjectTextureCoordinates(s + start, t + start, q + (start - from), (size_t)(range->Item2 - range->Item1));
+		}
+
+		static void Run(std::vector<double>& s, std::vector<double>& t, const std::vector<double>& q, size_t from, bool singleThreaded)
+		{
+			if (s.size() <= from) return;
+			TextureProjector^ projector = gcnew TextureProjector(s.data(), t.data(), q.data(), from);
+			Utilities::ForRange((int)from, (int)s.size(), 1 << 16, gcnew Action<Tuple<int, int>^>(projector, &TextureProjector::Project), singleThreaded);
+		}
+
+	private:
+		double* s;
+		double* t;
+		const double* q;
+		size_t from;
+	};
+
+	/// <summary>
+	/// Computes the bounds of a range of faces from their converted points
+	/// </summary>
+	ref class FaceBounder
+	{
+	public:
+		FaceBounder(GeometryBuffer* buffer)
+		{
+			this->buffer = buffer;
+		}
+
+		void Bound(Tuple<int, int>^ range)
+		{
+			for (int i = range->Item1; i < range->Item2; i++)
+				buffer->FaceBox((size_t)i, buffer->FaceBounds.data() + 6 * (size_t)i);
+		}
+
+		static void Run(GeometryBuffer* buffer, size_t from, bool singleThreaded)
+		{
+			size_t count = buffer->FaceVertices.size();
+			if (count <= from) return;
+			buffer->FaceBounds.resize(6 * count);
+			FaceBounder^ bounder = gcnew FaceBounder(buffer);
+			Utilities::ForRange((int)from, (int)count, 4096, gcnew Action<Tuple<int, int>^>(bounder, &FaceBounder::Bound), singleThreaded);
+		}
+
+	private:
+		GeometryBuffer* buffer;
+	};
+
+	/// <summary>
+	/// Geometry of a loaded model.
+	/// Surfaces, Edges and Meshes are views into this store and only create
+	/// managed vertices when their properties are accessed.
+	/// </summary>
+	public ref class GeometryStore
+	{
+	public:
+
+		/// <summary>
+		/// Number of stored edge and face points
+		/// </summary>
+		property int PointCount { int get() { return (int)Buffer->X.size(); } }
+
+		/// <summary>
+		/// Number of stored edges
+		/// </summary>
+		property int EdgeCount { int get() { return (int)Buffer->EdgeCount(); } }
+
+		/// <summary>
+		/// Number of stored faces
+		/// </summary>
+		property int FaceCount { int get() { return (int)Buffer->FaceLoops.size(); } }
+
+		/// <summary>
+		/// Number of stored meshes
+		/// </summary>
+		property int MeshCount { int get() { return (int)Buffer->MeshPoints.size(); } }
+
+		/// <summary>
+		/// Points and edges are stored once per SketchUp vertex and edge and shared by all faces using them
+		/// </summary>
+		property bool SharedTopology { bool get() { return Buffer->Shared; } }
+
+		/// <summary>
+		/// Meshes carry front and back texture coordinates
+		/// </summary>
+		property bool TextureCoordinates { bool get() { return Buffer->TextureCoordinates; } }
+
+		/// <summary>
+		/// Number of stored half-edges, one per edge of each face loop in shared topology mode
+		/// </summary>
+		property int HalfEdgeCount { int get() { return (int)Buffer->HalfEdges.size(); } }
+
+		/// <summary>
+		/// Indices of the faces using an edge. Requires SharedTopology.
+		/// </summary>
+		/// <param name="edge">Edge index</param>
+		List<int>^ GetEdgeFaces(int edge)
+		{
+			List<int>^ faces = gcnew List<int>(2);
+			if (!Buffer->Shared) return faces;
+			for (size_t h = Buffer->EdgeHalfEdge[edge]; h != SIZE_MAX; h = Buffer->HalfEdges[h].Radial)
+				if (Buffer->HalfEdges[h].Face != SIZE_MAX)
+					faces->Add((int)Buffer->HalfEdges[h].Face);
+			return faces;
+		}
+
+		/// <summary>
+		/// Indices of the faces sharing at least one edge with a face. Requires SharedTopology.
+		/// </summary>
+		/// <param name="face">Face index</param>
+		List<int>^ GetAdjacentFaces(int face)
+		{
+			List<int>^ faces = gcnew List<int>();
+			if (!Buffer->Shared) return faces;
+
+			GeometryRange loops = Buffer->FaceLoops[face];
+			for (size_t l = loops.Start; l < loops.Start + loops.Count; l++)
+			{
+				GeometryRange loop = Buffer->Loops[l];
+				for (size_t i = loop.Start; i < loop.Start + loop.Count; i++)
+				{
+					for (size_t h = Buffer->EdgeHalfEdge[Buffer->LoopEdges[i]]; h != SIZE_MAX; h = Buffer->HalfEdges[h].Radial)
+					{
+						size_t other = Buffer->HalfEdges[h].Face;
+						if (other != SIZE_MAX && other != (size_t)face && !faces->Contains((int)other))
+							faces->Add((int)other);
+					}
+				}
+			}
+			return faces;
+		}
+
+		/// <summary>
+		/// Start and end point index of an edge
+		/// </summary>
+		/// <param name="edge">Edge index</param>
+		Tuple<int, int>^ GetEdgePoints(int edge)
+		{
+			return gcnew Tuple<int, int>((int)Buffer->EdgePoints[2 * edge], (int)Buffer->EdgePoints[2 * edge + 1]);
+		}
+
+		/// <summary>
+		/// Edge, origin point and face of a half-edge. Requires SharedTopology.
+		/// </summary>
+		/// <param name="halfEdge">Half-edge index</param>
+		Tuple<int, int, int>^ GetHalfEdge(int halfEdge)
+		{
+			const HalfEdge& h = Buffer->HalfEdges[halfEdge];
+			return gcnew Tuple<int, int, int>((int)h.Edge, (int)h.Origin, (int)h.Face);
+		}
+
+		/// <summary>
+		/// Last recorded use of an edge by a face loop, -1 if no face uses it. Requires SharedTopology.
+		/// </summary>
+		/// <param name="edge">Edge index</param>
+		int GetEdgeHalfEdge(int edge)
+		{
+			if (!Buffer->Shared || (size_t)edge >= Buffer->EdgeHalfEdge.size()) return -1;
+			size_t h = Buffer->EdgeHalfEdge[edge];
+			return (h == SIZE_MAX) ? -1 : (int)h;
+		}
+
+		/// <summary>
+		/// A half-edge starting at a point, -1 if no face loop starts at it. Requires SharedTopology.
+		/// </summary>
+		/// <param name="point">Point index</param>
+		int GetPointHalfEdge(int point)
+		{
+			if (!Buffer->Shared || (size_t)point >= Buffer->PointHalfEdge.size()) return -1;
+			size_t h = Buffer->PointHalfEdge[point];
+			return (h == SIZE_MAX) ? -1 : (int)h;
+		}
+
+		/// <summary>
+		/// Frees the native geometry without waiting for the finalizer.
+		/// Surfaces, edges and meshes viewing this store must not be used afterwards.
+		/// </summary>
+		~GeometryStore()
+		{
+			this->!GeometryStore();
+		}
+
+	internal:
+		GeometryBuffer* Buffer;
+
+		/// <summary>
+		/// Distinct layer names, decoded once per layer ref
+		/// </summary>
+		List<String^>^ LayerNames;
+
+		GeometryStore() : GeometryStore(nullptr) {}
+
+		GeometryStore(LoadOptions^ options)
+		{
+			Buffer = new GeometryBuffer();
+			Buffer->Shared = (options != nullptr && options->SharedTopology);
+			Buffer->TextureCoordinates = (options != nullptr && options->TextureCoordinates);
+			LayerNames = gcnew List<String^>();
+			layerIndices = gcnew Dictionary<IntPtr, int>();
+			points = gcnew array<Vertex^>(0);
+		}
+
+		!GeometryStore()
+		{
+			delete Buffer;
+			Buffer = nullptr;
+			if (pressure > 0)
+				GC::RemoveMemoryPressure(pressure);
+			pressure = 0;
+		}
+
+		/// <summary>
+		/// Converts all points extracted since the last commit to meters.
+		/// Runs without SketchUp API calls, so it may be called after the model has been released.
+		/// </summary>
+		void Commit(bool singleThreaded)
+		{
+			UnitScaler::Run(Buffer->X, Buffer->Y, Buffer->Z, Buffer->CommittedPoints, singleThreaded);
+			UnitScaler::Run(Buffer->MeshX, Buffer->MeshY, Buffer->MeshZ, Buffer->CommittedMeshPoints, singleThreaded);
+			if (Buffer->TextureCoordinates)
+			{
+				TextureProjector::Run(Buffer->FrontU, Buffer->FrontV, Buffer->FrontQ, Buffer->CommittedMeshPoints, singleThreaded);
+				TextureProjector::Run(Buffer->BackU, Buffer->BackV, Buffer->BackQ, Buffer->CommittedMeshPoints, singleThreaded);
+				Buffer->FrontQ.clear();
+				Buffer->BackQ.clear();
+			}
+			Buffer->CommittedPoints = Buffer->X.size();
+			Buffer->CommittedMeshPoints = Buffer->MeshX.size();
+
+			FaceBounder::Run(Buffer, Buffer->CommittedFaces, singleThreaded);
+			Buffer->CommittedFaces = Buffer->FaceVertices.size();
+
+			if (Buffer->Shared)
+				Array::Resize(points, (int)Buffer->X.size());
+
+			// Let the collector see the native buffer so stores of earlier loads are finalized in time
+			long long bytes = (long long)Buffer->Bytes();
+			if (bytes > pressure)
+			{
+				GC::AddMemoryPressure(bytes - pressure);
+				pressure = bytes;
+			}
+		}
+
+		Vertex^ GetPoint(size_t index)
+		{
+			if (!Buffer->Shared)
+				return gcnew Vertex(Buffer->X[index], Buffer->Y[index], Buffer->Z[index]);
+
+			// Shared points are materialized once and handed to every edge and face using them
+			Vertex^ point = points[(int)index];
+			if (point == nullptr)
+			{
+				point = gcnew Vertex(Buffer->X[index], Buffer->Y[index], Buffer->Z[index]);
+				points[(int)index] = point;
+			}
+			return point;
+		}
+
+		List<Vertex^>^ GetFaceVertices(size_t face)
+		{
+			GeometryRange range = Buffer->FaceVertices[face];
+			List<Vertex^>^ vertices = gcnew List<Vertex^>((int)range.Count);
+			for (size_t i = range.Start; i < range.Start + range.Count; i++)
+				vertices->Add(GetPoint(Buffer->FacePoints[i]));
+			return vertices;
+		}
+
+		BoundingBox^ GetFaceBounds(size_t face)
+		{
+			return BoundingBox::FromArray(Buffer->FaceBounds.data() + 6 * face);
+		}
+
+		List<Vertex^>^ GetMeshVertices(size_t mesh)
+		{
+			GeometryRange range = Buffer->MeshPoints[mesh];
+			List<Vertex^>^ vertices = gcnew List<Vertex^>((int)range.Count);
+			for (size_t i = range.Start; i < range.Start + range.Count; i++)
+				vertices->Add(gcnew Vertex(Buffer->MeshX[i], Buffer->MeshY[i], Buffer->MeshZ[i]));
+			return vertices;
+		}
+
+		List<Vector^>^ GetMeshNormals(size_t mesh)
+		{
+			GeometryRange range = Buffer->MeshNormals[mesh];
+			List<Vector^>^ normals = gcnew List<Vector^>((int)range.Count);
+			for (size_t i = range.Start; i < range.Start + range.Count; i++)
+				normals->Add(gcnew Vector(Buffer->NormalX[i], Buffer->NormalY[i], Buffer->NormalZ[i]));
+			return normals;
+		}
+
+		/// <summary>
+		/// Copies the points or normals of a mesh as xyz triples into target starting at offset
+		/// </summary>
+		void CopyMeshPoints(size_t mesh, array<double>^ target, int offset)
+		{
+			GeometryRange range = Buffer->MeshPoints[mesh];
+			if (range.Count == 0) return;
+			pin_ptr<double> p = &target[offset];
+			GeometryBuffer::Interleave(Buffer->MeshX, Buffer->MeshY, Buffer->MeshZ, range, (double*)p);
+		}
+
+		void CopyMeshPoints(size_t mesh, array<float>^ target, int offset)
+		{
+			GeometryRange range = Buffer->MeshPoints[mesh];
+			if (range.Count == 0) return;
+			pin_ptr<float> p = &target[offset];
+			CopyMeshPoints(mesh, (float*)p);
+		}
+
+		void CopyMeshPoints(size_t mesh, float* target)
+		{
+			GeometryBuffer::Interleave(Buffer->MeshX, Buffer->MeshY, Buffer->MeshZ, Buffer->MeshPoints[mesh], target);
+		}
+
+		void CopyMeshNormals(size_t mesh, array<double>^ target, int offset)
+		{
+			GeometryRange range = Buffer->MeshNormals[mesh];
+			if (range.Count == 0) return;
+			pin_ptr<double> p = &target[offset];
+			GeometryBuffer::Interleave(Buffer->NormalX, Buffer->NormalY, Buffer->NormalZ, range, (double*)p);
+		}
+
+		void CopyMeshNormals(size_t mesh, array<float>^ target, int offset)
+		{
+			GeometryRange range = Buffer->MeshNormals[mesh];
+			if (range.Count == 0) return;
+			pin_ptr<float> p = &target[offset];
+			CopyMeshNormals(mesh, (float*)p);
+		}
+
+		void CopyMeshNormals(size_t mesh, float* target)
+		{
+			GeometryBuffer::Interleave(Buffer->NormalX, Buffer->NormalY, Buffer->NormalZ, Buffer->MeshNormals[mesh], target);
+		}
+
+		/// <summary>
+		/// Copies the front or back texture coordinates of a mesh as uv pairs into target starting at offset
+		/// </summary>
+		void CopyMeshUVs(size_t mesh, array<double>^ target, int offset, bool front)
+		{
+			GeometryRange range = Buffer->MeshPoints[mesh];
+			if (range.Count == 0 || !Buffer->TextureCoordinates) return;
+			pin_ptr<double> p = &target[offset];
+			if (front)
+				GeometryBuffer::Interleave(Buffer->FrontU, Buffer->FrontV, range, (double*)p);
+			else
+				GeometryBuffer::Interleave(Buffer->BackU, Buffer->BackV, range, (double*)p);
+		}
+
+		void CopyMeshUVs(size_t mesh, array<float>^ target, int offset, bool front)
+		{
+			GeometryRange range = Buffer->MeshPoints[mesh];
+			if (range.Count == 0 || !Buffer->TextureCoordinates) return;
+			pin_ptr<float> p = &target[offset];
+			CopyMeshUVs(mesh, (float*)p, front);
+		}
+
+		void CopyMeshUVs(size_t mesh, float* target, bool front)
+		{
+			GeometryRange range = Buffer->MeshPoints[mesh];
+			if (!Buffer->TextureCoordinates) return;
+			if (front)
+				GeometryBuffer::Interleave(Buffer->FrontU, Buffer->FrontV, range, target);
+			else
+				GeometryBuffer::Interleave(Buffer->BackU, Buffer->BackV, range, target);
+		}
+
+		/// <summary>
+		/// Copies the triangle corner indices of a mesh into target starting at offset, adding base to each index
+		/// </summary>
+		void CopyMeshIndices(size_t mesh, array<unsigned int>^ target, int offset, unsigned int base)
+		{
+			GeometryRange range = Buffer->MeshTriangles[mesh];
+			if (range.Count == 0) return;
+			pin_ptr<unsigned int> p = &target[offset];
+			CopyMeshIndices(mesh, (unsigned int*)p, base);
+		}
+
+		void CopyMeshIndices(size_t mesh, unsigned int* target, unsigned int base)
+		{
+			GeometryRange range = Buffer->MeshTriangles[mesh];
+			if (range.Count == 0) return;
+			const size_t* source = &Buffer->MeshIndices[3 * range.Start];
+			for (size_t i = 0; i < 3 * range.Count; i++)
+				target[i] = (unsigned int)source[i] + base;
+		}
+
+		List<MeshFace^>^ GetMeshFaces(size_t mesh)
+		{
+			GeometryRange range = Buffer->MeshTriangles[mesh];
+			List<MeshFace^>^ faces = gcnew List<MeshFace^>((int)range.Count);
+			for (size_t i = range.Start; i < range.Start + range.Count; i++)
+			{
+				size_t* corners = &Buffer->MeshIndices[3 * i];
+				faces->Add(gcnew MeshFace((int)corners[0], (int)corners[1], (int)corners[2]));
+			}
+			return faces;
+		}
+
+		size_t AddEdge(SUEdgeRef edge)
+		{
+			int32_t id = 0;
+			if (Buffer->Shared)
+			{
+				SUEntityGetID(SUEdgeToEntity(edge), &id);
+				auto found = Buffer->EdgeIds.find(id);
+				if (found != Buffer->EdgeIds.end())
+					return found->second;
+			}
+
+			SUVertexRef startVertex = SU_INVALID;
+			SUVertexRef endVertex = SU_INVALID;
+			SUEdgeGetStartVertex(edge, &startVertex);
+			SUEdgeGetEndVertex(edge, &endVertex);
+
+			// Layer
+			SULayerRef layer = SU_INVALID;
+			SUDrawingElementGetLayer(SUEdgeToDrawingElement(edge), &layer);
+
+			Buffer->EdgePoints.push_back(Buffer->AddVertex(startVertex));
+			Buffer->EdgePoints.push_back(Buffer->AddVertex(endVertex));
+			Buffer->EdgeLayers.push_back(InternLayer(layer));
+
+			size_t index = Buffer->EdgeCount() - 1;
+			if (Buffer->Shared)
+			{
+				Buffer->EdgeIds.emplace(id, index);
+				Buffer->EdgeHalfEdge.push_back(SIZE_MAX);
+			}
+			return index;
+		}
+
+		/// <summary>
+		/// Index of the layer in LayerNames, the name is decoded on the first call per layer
+		/// </summary>
+		int InternLayer(SULayerRef layer)
+		{
+			int index;
+			if (layerIndices->TryGetValue(IntPtr(layer.ptr), index))
+				return index;
+
+			index = LayerNames->Count;
+			LayerNames->Add(SUIsInvalid(layer) ? String::Empty : Utilities::GetLayerName(layer));
+			layerIndices->Add(IntPtr(layer.ptr), index);
+			return index;
+		}
+
+		String^ LayerName(SULayerRef layer)
+		{
+			return LayerNames[InternLayer(layer)];
+		}
+
+		String^ EdgeLayer(size_t edge)
+		{
+			return LayerNames[Buffer->EdgeLayers[edge]];
+		}
+
+		size_t AddLoop(SULoopRef loop)
+		{
+			return AddLoop(loop, SIZE_MAX);
+		}
+
+		size_t AddLoop(SULoopRef loop, size_t face)
+		{
+			if (Buffer->Shared)
+				return AddSharedLoop(loop, face);
+
+			size_t num_vertices = 0;
+			SULoopGetNumVertices(loop, &num_vertices);
+
+			std::vector<size_t> loopEdges;
+			if (num_vertices > 0) {
+				std::vector<SUEdgeRef> edges(num_vertices);
+				SULoopGetEdges(loop, num_vertices, &edges[0], &num_vertices);
+				loopEdges.reserve(num_vertices);
+				for (size_t i = 0; i < num_vertices; i++)
+					loopEdges.push_back(AddEdge(edges[i]));
+			}
+
+			GeometryRange range = { Buffer->LoopEdges.size(), loopEdges.size() };
+			Buffer->LoopEdges.insert(Buffer->LoopEdges.end(), loopEdges.begin(), loopEdges.end());
+			Buffer->Loops.push_back(range);
+
+			return Buffer->Loops.size() - 1;
+		}
+
+		size_t AddFace(SUFaceRef face)
+		{
+			SULoopRef outer = SU_INVALID;
+			SUFaceGetOuterLoop(face, &outer);
+
+			size_t loopCount = 0;
+			SUFaceGetNumInnerLoops(face, &loopCount);
+			std::vector<SULoopRef> loops(loopCount + 1);
+			loops[0] = outer;
+			if (loopCount > 0)
+				SUFaceGetInnerLoops(face, loopCount, &loops[1], &loopCount);
+
+			// Loops of a face are stored consecutively, outer loop first
+			GeometryRange faceLoops = { Buffer->Loops.size(), loopCount + 1 };
+			size_t index = Buffer->FaceLoops.size();
+			for (size_t j = 0; j <= loopCount; j++)
+				AddLoop(loops[j], index);
+
+			GeometryRange faceVertices = { Buffer->FacePoints.size(), 0 };
+			size_t verticesCount = 0;
+			SUFaceGetNumVertices(face, &verticesCount);
+			if (verticesCount > 0)
+			{
+				std::vector<SUVertexRef> vs(verticesCount);
+				SUFaceGetVertices(face, verticesCount, &vs[0], &verticesCount);
+
+				for (size_t j = 0; j < verticesCount; j++)
+					Buffer->FacePoints.push_back(Buffer->AddVertex(vs[j]));
+				faceVertices.Count = verticesCount;
+			}
+
+			Buffer->FaceLoops.push_back(faceLoops);
+			Buffer->FaceVertices.push_back(faceVertices);
+
+			return Buffer->FaceLoops.size() - 1;
+		}
+
+		/// <summary>
+		/// Meshes a face. With a texture writer the face is loaded into it first
+		/// and its front and back texture coordinates are extracted with the points.
+		/// </summary>
+		size_t AddMesh(SUFaceRef face, const SUTextureWriterRef* writer)
+		{
+			GeometryBuffer* b = Buffer;
+
+			SUMeshHelperRef helper = SU_INVALID;
+			bool textured = (writer != nullptr && SUIsValid(*writer));
+			if (textured)
+			{
+				long frontTexture = 0;
+				long backTexture = 0;
+				SUTextureWriterLoadFace(*writer, face, &frontTexture, &backTexture);
+				textured = (SUMeshHelperCreateWithTextureWriter(&helper, face, *writer) == SU_ERROR_NONE);
+			}
+			if (!textured)
+				SUMeshHelperCreate(&helper, face);
+
+			GeometryRange points = { b->MeshX.size(), 0 };
+			size_t vCount = 0;
+			SUMeshHelperGetNumVertices(helper, &vCount);
+			if (vCount > 0)
+			{
+				std::vector<SUPoint3D> vs(vCount);
+				SUMeshHelperGetVertices(helper, vCount, &vs[0], &vCount);
+
+				for (size_t j = 0; j < vCount; j++)
+				{
+					b->MeshX.push_back(vs[j].x);
+					b->MeshY.push_back(vs[j].y);
+					b->MeshZ.push_back(vs[j].z);
+				}
+				points.Count = vCount;
+
+				// Texture coordinates reuse the point buffer, faces meshed without a writer get zeros
+				if (b->TextureCoordinates)
+				{
+					size_t front = 0;
+					size_t back = 0;
+					if (textured)
+					{
+						SUMeshHelperGetFrontSTQCoords(helper, vCount, &vs[0], &front);
+						GeometryBuffer::AddSTQ(vs, front, vCount, b->FrontU, b->FrontV, b->FrontQ);
+						SUMeshHelperGetBackSTQCoords(helper, vCount, &vs[0], &back);
+						GeometryBuffer::AddSTQ(vs, back, vCount, b->BackU, b->BackV, b->BackQ);
+					}
+					else
+					{
+						GeometryBuffer::AddSTQ(vs, 0, vCount, b->FrontU, b->FrontV, b->FrontQ);
+						GeometryBuffer::AddSTQ(vs, 0, vCount, b->BackU, b->BackV, b->BackQ);
+					}
+				}
+			}
+
+			GeometryRange triangles = { b->MeshIndices.size() / 3, 0 };
+			size_t fCount = 0;
+			size_t ret = 0;
+			SUMeshHelperGetNumTriangles(helper, &fCount);
+			if (fCount > 0)
+			{
+				b->MeshIndices.resize(b->MeshIndices.size() + 3 * fCount);
+				SUMeshHelperGetVertexIndices(helper, 3 * fCount, &b->MeshIndices[3 * triangles.Start], &ret);
+				triangles.Count = fCount;
+			}
+
+			// Normals are per vertex
+			GeometryRange normals = { b->NormalX.size(), 0 };
+			size_t nCount = vCount;
+			if (nCount > 0)
+			{
+				std::vector<SUVector3D> norms(nCount);
+				SUMeshHelperGetNormals(helper, nCount, &norms[0], &nCount);
+
+				for (size_t j = 0; j < nCount; j++)
+				{
+					b->NormalX.push_back(norms[j].x);
+					b->NormalY.push_back(norms[j].y);
+					b->NormalZ.push_back(norms[j].z);
+				}
+				normals.Count = nCount;
+			}
+
+			SUMeshHelperRelease(&helper);
+
+			b->MeshPoints.push_back(points);
+			b->MeshTriangles.push_back(triangles);
+			b->MeshNormals.push_back(normals);
+
+			return b->MeshPoints.size() - 1;
+		}
+
+	private:
+		Dictionary<IntPtr, int>^ layerIndices;
+		array<Vertex^>^ points;
+
+		// Records a loop as half-edges in edge use order, linking each use into the radial list of its edge
+		size_t AddSharedLoop(SULoopRef loop, size_t face)
+		{
+			GeometryBuffer* b = Buffer;
+
+			size_t count = 0;
+			SULoopGetNumVertices(loop, &count);
+
+			GeometryRange range = { b->LoopEdges.size(), 0 };
+			if (count > 0)
+			{
+				std::vector<SUEdgeUseRef> uses(count);
+				SULoopGetEdgeUses(loop, count, &uses[0], &count);
+
+				for (size_t i = 0; i < count; i++)
+				{
+					SUEdgeRef edge = SU_INVALID;
+					SUVertexRef start = SU_INVALID;
+					SUEdgeUseGetEdge(uses[i], &edge);
+					SUEdgeUseGetStartVertex(uses[i], &start);
+
+					HalfEdge half;
+					half.Edge = AddEdge(edge);
+					half.Origin = b->AddVertex(start);
+					half.Face = face;
+					half.Next = range.Start + (i + 1) % count;
+					half.Radial = b->EdgeHalfEdge[half.Edge];
+
+					size_t h = b->HalfEdges.size();
+					b->EdgeHalfEdge[half.Edge] = h;
+					if (b->PointHalfEdge[half.Origin] == SIZE_MAX)
+						b->PointHalfEdge[half.Origin] = h;
+
+					b->HalfEdges.push_back(half);
+					b->LoopEdges.push_back(half.Edge);
+				}
+				range.Count = count;
+			}
+
+			b->Loops.push_back(range);
+			return b->Loops.size() - 1;
+		}
+		long long pressure;
+	};
+
+
+}
@@ -0,0 +1,776 @@
+/*
+
+SketchUpNET - a C++ Wrapper for the Trimble(R) SketchUp(R) C API
+Copyright(C) 2015, Autor: Maximilian Thumfart
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+#pragma once
+
+#include <cmath>
+#include "Utilities.h"
+#include "Transform.h"
+#include "Surface.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "Texture.h"
+#include "TextureImage.h"
+#include "Group.h"
+#include "Instance.h"
+#include "Component.h"
+#include "InstanceTree.h"
+#include "BoundingBox.h"
+
+using namespace System;
+using namespace System::Collections;
+using namespace System::Collections::Generic;
+using namespace System::Globalization;
+using namespace System::IO;
+using namespace System::Text;
+
+namespace SketchUpNET
+{
+#pragma managed(push, off)
+	/// <summary>
+	/// Splits an affine column major 4x4 matrix into translation, rotation quaternion (xyzw) and scale.
+	/// Returns false for projective matrices, degenerate axes and shear, which instancing attributes cannot express.
+	/// </summary>
+	inline bool DecomposeTrs(const double* m, float* translation, float* rotation, float* scale)
+	{
+		if (m[3] != 0.0 || m[7] != 0.0 || m[11] != 0.0 || m[15] != 1.0)
+			return false;
+
+		double c[3][3] = { { m[0], m[1], m[2] }, { m[4], m[5], m[6] }, { m[8], m[9], m[10] } };
+		double s[3];
+		for (int i = 0; i < 3; i++)
+		{
+			s[i] = std::sqrt(c[i][0] * c[i][0] + c[i][1] * c[i][1] + c[i][2] * c[i][2]);
+			if (s[i] < 1e-12)
+				return false;
+		}
+
+		// Mirroring shows as a negative determinant and is moved into the x scale
+		double det = c[0][0] * (c[1][1] * c[2][2] - c[1][2] * c[2][1]) - c[0][1] * (c[1][0] * c[2][2] - c[1][2] * c[2][0]) + c[0][2] * (c[1][0] * c[2][1] - c[1][1] * c[2][0]);
+		if (det < 0.0)
+			s[0] = -s[0];
+
+		for (int i = 0; i < 3; i++)
+			for (int j = 0; j < 3; j++)
+				c[i][j] /= s[i];
+
+		for (int i = 0; i < 3; i++)
+			for (int j = i + 1; j < 3; j++)
+				if (std::fabs(c[i][0] * c[j][0] + c[i][1] * c[j][1] + c[i][2] * c[j][2]) > 1e-6)
+					return false;
+
+		// Rotation matrix element (row, column) is c[column][row]
+		double r00 = c[0][0], r11 = c[1][1], r22 = c[2][2];
+		double x, y, z, w;
+		double trace = r00 + r11 + r22;
+		if (trace > 0.0)
+		{
+			double k = 0.5 / std::sqrt(trace + 1.0);
+			w = 0.25 / k;
+			x = (c[1][2] - c[2][1]) * k;
+			y = (c[2][0] - c[0][2]) * k;
+			z = (c[0][1] - c[1][0]) * k;
+		}
+		else if (r00 > r11 && r00 > r22)
+		{
+			double k = 2.0 * std::sqrt(1.0 + r00 - r11 - r22);
+			w = (c[1][2] - c[2][1]) / k;
+			x = 0.25 * k;
+			y = (c[1][0] + c[0][1]) / k;
+			z = (c[2][0] + c[0][2]) / k;
+		}
+		else if (r11 > r22)
+		{
+			double k = 2.0 * std::sqrt(1.0 + r11 - r00 - r22);
+			w = (c[2][0] - c[0][2]) / k;
+			x = (c[1][0] + c[0][1]) / k;
+			y = 0.25 * k;
+			z = (c[2][1] + c[1][2]) / k;
+		}
+		else
+		{
+			double k = 2.0 * std::sqrt(1.0 + r22 - r00 - r11);
+			w = (c[0][1] - c[1][0]) / k;
+			x = (c[2][0] + c[0][2]) / k;
+			y = (c[2][1] + c[1][2]) / k;
+			z = 0.25 * k;
+		}
+		double length = std::sqrt(x * x + y * y + z * z + w * w);
+
+		translation[0] = (float)m[12]; translation[1] = (float)m[13]; translation[2] = (float)m[14];
+		rotation[0] = (float)(x / length); rotation[1] = (float)(y / length); rotation[2] = (float)(z / length); rotation[3] = (float)(w / length);
+		scale[0] = (float)s[0]; scale[1] = (float)s[1]; scale[2] = (float)s[2];
+		return true;
+	}
+
+	// glTF texture coordinates start at the top row of the image
+	inline void FlipV(float* uv, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+			uv[2 * i + 1] = 1.0f - uv[2 * i + 1];
+	}
+
+	// glTF color factors are linear, SketchUp colors sRGB
+	inline double SrgbToLinear(unsigned char value)
+	{
+		double c = value / 255.0;
+		return (c <= 0.04045) ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+	}
+#pragma managed(pop)
+
+	/// <summary>
+	/// Writes a loaded model as binary glTF 2.0 (GLB). The surfaces of each group body and component definition
+	/// become one glTF mesh with a primitive per material, placed by one node per placement. Bodies placed
+	/// InstancingThreshold times or more are placed by a single node with EXT_mesh_gpu_instancing instead.
+	/// The JSON is laid out first, then the buffer is streamed from the geometry store one attribute at a time.
+	/// The model has to be loaded with meshes; texture coordinates and images are written when they were loaded.
+	/// </summary>
+	public ref class GltfExporter
+	{
+	public:
+		/// <summary>
+		/// Placements of one body from which they are written as one node with EXT_mesh_gpu_instancing, zero writes a node per placement
+		/// </summary>
+		int InstancingThreshold;
+
+		/// <summary>
+		/// Embed the texture images of materials, see LoadOptions.TextureImages
+		/// </summary>
+		bool Textures;
+
+		/// <summary>
+		/// Meshes written by the last export
+		/// </summary>
+		int MeshCount;
+
+		/// <summary>
+		/// Nodes written by the last export
+		/// </summary>
+		int NodeCount;
+
+		/// <summary>
+		/// Placements written through EXT_mesh_gpu_instancing by the last export
+		/// </summary>
+		int InstancedCount;
+
+		/// <summary>
+		/// Bytes written by the last export
+		/// </summary>
+		long long ByteCount;
+
+		GltfExporter()
+		{
+			this->InstancingThreshold = 64;
+			this->Textures = true;
+		};
+
+		/// <summary>
+		/// Writes the model to a GLB file
+		/// </summary>
+		/// <param name="path">Path to .glb file</param>
+		/// <param name="surfaces">Top level surfaces</param>
+		/// <param name="groups">Top level groups</param>
+		/// <param name="instances">Top level component instances</param>
+		void Write(String^ path, List<Surface^>^ surfaces, List<Group^>^ groups, List<Instance^>^ instances)
+		{
+			FileStream^ stream = gcnew FileStream(path, FileMode::Create, FileAccess::Write, FileShare::None, 1 << 16);
+			try
+			{
+				Write(stream, surfaces, groups, instances);
+			}
+			finally
+			{
+				delete stream;
+			}
+		}
+
+		/// <summary>
+		/// Writes the model as GLB to a stream. The output only depends on the model, equal models give equal bytes.
+		/// </summary>
+		/// <param name="stream">Target stream</param>
+		/// <param name="surfaces">Top level surfaces</param>
+		/// <param name="groups">Top level groups</param>
+		/// <param name="instances">Top level component instances</param>
+		void Write(Stream^ stream, List<Surface^>^ surfaces, List<Group^>^ groups, List<Instance^>^ instances)
+		{
+			Begin();
+
+			Body^ model = AddBody(surfaces, nullptr, "Model");
+			if (model != nullptr)
+				model->Singles->Add(nullptr);
+
+			for each (Placement^ placement in InstanceTree::Build(groups, instances)->Placements)
+			{
+				List<Surface^>^ body = placement->Surfaces;
+				SketchUpNET::Material^ inherited = Inherits(body) ? placement->Material : nullptr;
+				String^ name = (placement->Group != nullptr) ? placement->Group->Name : placement->Definition->Name;
+				Body^ target = AddBody(body, inherited, name);
+				if (target == nullptr)
+					continue;
+
+				float t[3], r[4], s[3];
+				pin_ptr<double> m = &placement->World->Data[0];
+				if (InstancingThreshold > 0 && DecomposeTrs(m, t, r, s))
+					target->Instanced->Add(placement);
+				else
+					target->Singles->Add(placement);
+			}
+
+			// Bodies with few decomposable placements are placed by nodes after all
+			for each (Body^ body in bodies)
+				if (body->Instanced->Count > 0 && body->Instanced->Count < InstancingThreshold)
+				{
+					body->Singles->AddRange(body->Instanced);
+					body->Instanced->Clear();
+				}
+
+			Layout();
+			array<Byte>^ json = Encoding::UTF8->GetBytes(Json());
+			int jsonLength = (json->Length + 3) & ~3;
+			long long binLength = (length + 3) & ~3LL;
+			ByteCount = 12 + 8 + jsonLength + 8 + binLength;
+			if (ByteCount > UInt32::MaxValue)
+			{
+				End();
+				throw gcnew InvalidOperationException("A GLB file exceeds 4 GB.");
+			}
+
+			WriteUInt32(stream, 0x46546C67);
+			WriteUInt32(stream, 2);
+			WriteUInt32(stream, (unsigned int)ByteCount);
+			WriteUInt32(stream, (unsigned int)jsonLength);
+			WriteUInt32(stream, 0x4E4F534A);
+			stream->Write(json, 0, json->Length);
+			for (int i = json->Length; i < jsonLength; i++)
+				stream->WriteByte(0x20);
+
+			WriteUInt32(stream, (unsigned int)binLength);
+			WriteUInt32(stream, 0x004E4942);
+			WriteBuffer(stream);
+			for (long long i = length; i < binLength; i++)
+				stream->WriteByte(0);
+
+			End();
+		}
+
+	private:
+		/// <summary>
+		/// Face meshes of one material within a body
+		/// </summary>
+		ref class Primitive
+		{
+		public:
+			int Material;
+			List<Mesh^>^ Meshes;
+			int VertexCount;
+			int TriangleCount;
+			bool Textured;
+			BoundingBox^ Bounds;
+			int Position;
+			int Normal;
+			int UV;
+			int Indices;
+
+			Primitive()
+			{
+				this->Meshes = gcnew List<Mesh^>();
+				this->Bounds = gcnew BoundingBox();
+			};
+		};
+
+		/// <summary>
+		/// Surfaces of a group body or definition with the material inherited by faces without one
+		/// </summary>
+		ref class Body
+		{
+		public:
+			String^ Name;
+			List<Primitive^>^ Primitives;
+			List<Placement^>^ Singles;
+			List<Placement^>^ Instanced;
+			int MeshIndex;
+			int Translation;
+			int Rotation;
+			int Scale;
+
+			Body()
+			{
+				this->Primitives = gcnew List<Primitive^>();
+				this->Singles = gcnew List<Placement^>();
+				this->Instanced = gcnew List<Placement^>();
+			};
+		};
+
+		Dictionary<Tuple<Object^, Object^>^, Body^>^ bodyKeys;
+		List<Body^>^ bodies;
+		Dictionary<Object^, bool>^ inherits;
+		Dictionary<SketchUpNET::Material^, int>^ materialKeys;
+		List<SketchUpNET::Material^>^ materials;
+		int defaultMaterial;
+		Dictionary<TextureImage^, int>^ imageKeys;
+		List<array<Byte>^>^ images;
+		StringBuilder^ views;
+		StringBuilder^ accessors;
+		int viewCount;
+		int accessorCount;
+		long long length;
+		array<Byte>^ scratch;
+
+		void Begin()
+		{
+			MeshCount = 0;
+			NodeCount = 0;
+			InstancedCount = 0;
+			ByteCount = 0;
+			bodyKeys = gcnew Dictionary<Tuple<Object^, Object^>^, Body^>();
+			bodies = gcnew List<Body^>();
+			inherits = gcnew Dictionary<Object^, bool>();
+			materialKeys = gcnew Dictionary<SketchUpNET::Material^, int>();
+			materials = gcnew List<SketchUpNET::Material^>();
+			defaultMaterial = -1;
+			imageKeys = gcnew Dictionary<TextureImage^, int>();
+			images = gcnew List<array<Byte>^>();
+			views = gcnew StringBuilder();
+			accessors = gcnew StringBuilder();
+			viewCount = 0;
+			accessorCount = 0;
+			length = 0;
+		}
+
+		void End()
+		{
+			bodyKeys = nullptr;
+			bodies = nullptr;
+			inherits = nullptr;
+			materialKeys = nullptr;
+			materials = nullptr;
+			imageKeys = nullptr;
+			images = nullptr;
+			views = nullptr;
+			accessors = nullptr;
+			scratch = nullptr;
+		}
+
+		// Faces without a material of their own take the material of the placement
+		bool Inherits(List<Surface^>^ surfaces)
+		{
+			if (surfaces == nullptr)
+				return false;
+
+			bool result;
+			if (!inherits->TryGetValue(surfaces, result))
+			{
+				result = false;
+				for each (Surface^ surface in surfaces)
+					if (surface->FaceMesh != nullptr && (surface->FrontMaterial == nullptr || String::IsNullOrEmpty(surface->FrontMaterial->Name)))
+					{
+						result = true;
+						break;
+					}
+				inherits->Add(surfaces, result);
+			}
+			return result;
+		}
+
+		// The body of the surfaces with the inherited material, null if it holds no triangles
+		Body^ AddBody(List<Surface^>^ surfaces, SketchUpNET::Material^ inherited, String^ name)
+		{
+			if (surfaces == nullptr)
+				return nullptr;
+
+			Tuple<Object^, Object^>^ key = gcnew Tuple<Object^, Object^>(surfaces, inherited);
+			Body^ body;
+			if (bodyKeys->TryGetValue(key, body))
+				return body;
+
+			body = gcnew Body();
+			body->Name = name;
+			Dictionary<int, Primitive^>^ byMaterial = gcnew Dictionary<int, Primitive^>();
+			for each (Surface^ surface in surfaces)
+			{
+				Mesh^ mesh = surface->FaceMesh;
+				if (mesh == nullptr || mesh->VertexCount == 0 || mesh->TriangleCount == 0)
+					continue;
+
+				SketchUpNET::Material^ material = InstanceTree::Inherit(inherited, surface->FrontMaterial);
+				int index = MaterialIndex(material);
+				Primitive^ primitive;
+				if (!byMaterial->TryGetValue(index, primitive))
+				{
+					primitive = gcnew Primitive();
+					primitive->Material = index;
+					primitive->Textured = TextureOf(material) != nullptr;
+					byMaterial->Add(index, primitive);
+					body->Primitives->Add(primitive);
+				}
+
+				primitive->Meshes->Add(mesh);
+				primitive->VertexCount += mesh->VertexCount;
+				primitive->TriangleCount += mesh->TriangleCount;
+				primitive->Textured &= mesh->HasTextureCoordinates;
+				BoundingBox^ bounds = surface->Bounds;
+				if (bounds != nullptr && !bounds->IsEmpty)
+					primitive->Bounds = primitive->Bounds->Union(bounds);
+			}
+
+			if (body->Primitives->Count == 0)
+				body = nullptr;
+			bodyKeys->Add(key, body);
+			if (body != nullptr)
+				bodies->Add(body);
+			return body;
+		}
+
+		TextureImage^ TextureOf(SketchUpNET::Material^ material)
+		{
+			if (!Textures || material == nullptr || !material->UsesTexture || material->MaterialTexture == nullptr)
+				return nullptr;
+			TextureImage^ image = material->MaterialTexture->Image;
+			return (image != nullptr && image->Width > 0 && image->Height > 0) ? image : nullptr;
+		}
+
+		int MaterialIndex(SketchUpNET::Material^ material)
+		{
+			if (material == nullptr || String::IsNullOrEmpty(material->Name))
+			{
+				if (defaultMaterial < 0)
+				{
+					defaultMaterial = materials->Count;
+					materials->Add(nullptr);
+				}
+				return defaultMaterial;
+			}
+
+			int index;
+			if (!materialKeys->TryGetValue(material, index))
+			{
+				index = materials->Count;
+				materials->Add(material);
+				materialKeys->Add(material, index);
+
+				TextureImage^ image = TextureOf(material);
+				if (image != nullptr && !imageKeys->ContainsKey(image))
+				{
+					imageKeys->Add(image, images->Count);
+					images->Add((image->Encoded != nullptr) ? image->Encoded : image->EncodePng());
+				}
+			}
+			return index;
+		}
+
+		// Assigns buffer views and accessors in the order WriteBuffer streams the data
+		void Layout()
+		{
+			for each (Body^ body in bodies)
+				for each (Primitive^ p in body->Primitives)
+				{
+					p->Position = Accessor(View(12LL * p->VertexCount, 34962), 5126, p->VertexCount, "VEC3", p->Bounds);
+					p->Normal = Accessor(View(12LL * p->VertexCount, 34962), 5126, p->VertexCount, "VEC3", nullptr);
+					p->UV = p->Textured ? Accessor(View(8LL * p->VertexCount, 34962), 5126, p->VertexCount, "VEC2", nullptr) : -1;
+					p->Indices = Accessor(View(12LL * p->TriangleCount, 34963), 5125, 3 * p->TriangleCount, "SCALAR", nullptr);
+				}
+
+			for each (Body^ body in bodies)
+			{
+				int count = body->Instanced->Count;
+				if (count == 0) continue;
+				body->Translation = Accessor(View(12LL * count, 0), 5126, count, "VEC3", nullptr);
+				body->Rotation = Accessor(View(16LL * count, 0), 5126, count, "VEC4", nullptr);
+				body->Scale = Accessor(View(12LL * count, 0), 5126, count, "VEC3", nullptr);
+			}
+		}
+
+		int View(long long size, int target)
+		{
+			if (viewCount > 0) views->Append(",");
+			views->AppendFormat(CultureInfo::InvariantCulture, "{{\"buffer\":0,\"byteOffset\":{0},\"byteLength\":{1}", length, size);
+			if (target != 0)
+				views->AppendFormat(CultureInfo::InvariantCulture, ",\"target\":{0}", target);
+			views->Append("}");
+			length += (size + 3) & ~3LL;
+			return viewCount++;
+		}
+
+		int Accessor(int view, int componentType, int count, String^ type, BoundingBox^ bounds)
+		{
+			if (accessorCount > 0) accessors->Append(",");
+			accessors->AppendFormat(CultureInfo::InvariantCulture, "{{\"bufferView\":{0},\"componentType\":{1},\"count\":{2},\"type\":\"{3}\"", view, componentType, count, type);
+			if (bounds != nullptr && !bounds->IsEmpty)
+			{
+				accessors->Append(",\"min\":[");
+				accessors->Append(Number((float)bounds->Min->X))->Append(",")->Append(Number((float)bounds->Min->Y))->Append(",")->Append(Number((float)bounds->Min->Z));
+				accessors->Append("],\"max\":[");
+				accessors->Append(Number((float)bounds->Max->X))->Append(",")->Append(Number((float)bounds->Max->Y))->Append(",")->Append(Number((float)bounds->Max->Z));
+				accessors->Append("]");
+			}
+			accessors->Append("}");
+			return accessorCount++;
+		}
+
+		String^ Json()
+		{
+			bool instancing = false;
+			for each (Body^ body in bodies)
+				instancing |= body->Instanced->Count > 0;
+
+			StringBuilder^ json = gcnew StringBuilder();
+			json->Append("{\"asset\":{\"version\":\"2.0\",\"generator\":\"SketchUpNET\"}");
+			if (instancing)
+				json->Append(",\"extensionsUsed\":[\"EXT_mesh_gpu_instancing\"],\"extensionsRequired\":[\"EXT_mesh_gpu_instancing\"]");
+			json->Append(",\"scene\":0,\"scenes\":[{\"nodes\":[0]}]");
+
+			// SketchUp is z up, glTF y up: the root node turns the model by -90 degrees around x
+			StringBuilder^ nodes = gcnew StringBuilder();
+			StringBuilder^ children = gcnew StringBuilder();
+			int node = 1;
+			StringBuilder^ meshes = gcnew StringBuilder();
+			for each (Body^ body in bodies)
+			{
+				body->MeshIndex = MeshCount++;
+				if (body->MeshIndex > 0) meshes->Append(",");
+				meshes->Append("{\"name\":")->Append(Quote(body->Name))->Append(",\"primitives\":[");
+				for (int i = 0; i < body->Primitives->Count; i++)
+				{
+					Primitive^ p = body->Primitives[i];
+					if (i > 0) meshes->Append(",");
+					meshes->AppendFormat(CultureInfo::InvariantCulture, "{{\"attributes\":{{\"POSITION\":{0},\"NORMAL\":{1}", p->Position, p->Normal);
+					if (p->UV >= 0)
+						meshes->AppendFormat(CultureInfo::InvariantCulture, ",\"TEXCOORD_0\":{0}", p->UV);
+					meshes->AppendFormat(CultureInfo::InvariantCulture, "}},\"indices\":{0},\"material\":{1}}}", p->Indices, p->Material);
+				}
+				meshes->Append("]}");
+
+				for each (Placement^ placement in body->Singles)
+				{
+					nodes->Append(",{\"name\":")->Append(Quote(NodeName(placement, body)));
+					nodes->AppendFormat(CultureInfo::InvariantCulture, ",\"mesh\":{0}", body->MeshIndex);
+					if (placement != nullptr)
+					{
+						nodes->Append(",\"matrix\":[");
+						array<double>^ m = placement->World->Data;
+						for (int i = 0; i < 16; i++)
+							nodes->Append((i > 0) ? "," : "")->Append(Number(m[i]));
+						nodes->Append("]");
+					}
+					nodes->Append("}");
+					children->Append((node > 1) ? "," : "")->Append(node++);
+				}
+
+				if (body->Instanced->Count > 0)
+				{
+					nodes->Append(",{\"name\":")->Append(Quote(body->Name));
+					nodes->AppendFormat(CultureInfo::InvariantCulture, ",\"mesh\":{0},\"extensions\":{{\"EXT_mesh_gpu_instancing\":{{\"attributes\":{{\"TRANSLATION\":{1},\"ROTATION\":{2},\"SCALE\":{3}}}}}}}}}",
+						body->MeshIndex, body->Translation, body->Rotation, body->Scale);
+					children->Append((node > 1) ? "," : "")->Append(node++);
+					InstancedCount += body->Instanced->Count;
+				}
+			}
+			NodeCount = node;
+
+			json->Append(",\"nodes\":[{\"name\":\"SketchUp\",\"rotation\":[-0.70710678118654757,0,0,0.70710678118654757]");
+			if (node > 1)
+				json->Append(",\"children\":[")->Append(children)->Append("]");
+			json->Append("}")->Append(nodes)->Append("]");
+
+			if (MeshCount > 0)
+				json->Append(",\"meshes\":[")->Append(meshes)->Append("]");
+
+			if (materials->Count > 0)
+			{
+				json->Append(",\"materials\":[");
+				for (int i = 0; i < materials->Count; i++)
+					json->Append((i > 0) ? "," : "")->Append(MaterialJson(materials[i]));
+				json->Append("]");
+			}
+
+			if (images->Count > 0)
+			{
+				json->Append(",\"samplers\":[{\"wrapS\":10497,\"wrapT\":10497}],\"textures\":[");
+				for (int i = 0; i < images->Count; i++)
+					json->Append((i > 0) ? "," : "")->AppendFormat(CultureInfo::InvariantCulture, "{{\"sampler\":0,\"source\":{0}}}", i);
+				json->Append("],\"images\":[");
+				for (int i = 0; i < images->Count; i++)
+					json->Append((i > 0) ? "," : "")->AppendFormat(CultureInfo::InvariantCulture, "{{\"bufferView\":{0},\"mimeType\":\"image/png\"}}", View(images[i]->Length, 0));
+				json->Append("]");
+			}
+
+			if (accessorCount > 0)
+				json->Append(",\"accessors\":[")->Append(accessors)->Append("]");
+			if (viewCount > 0)
+				json->Append(",\"bufferViews\":[")->Append(views)->Append("]");
+			if (length > 0)
+				json->AppendFormat(CultureInfo::InvariantCulture, ",\"buffers\":[{{\"byteLength\":{0}}}]", length);
+			json->Append("}");
+			return json->ToString();
+		}
+
+		String^ MaterialJson(SketchUpNET::Material^ material)
+		{
+			if (material == nullptr)
+				return "{\"name\":\"Default\",\"pbrMetallicRoughness\":{\"baseColorFactor\":[0.8,0.8,0.8,1],\"metallicFactor\":0,\"roughnessFactor\":1},\"doubleSided\":true}";
+
+			TextureImage^ image = TextureOf(material);
+			double alpha = material->UseOpacity ? Math::Max(0.0, Math::Min(1.0, material->Opacity)) : 1.0;
+			double r = 1.0, g = 1.0, b = 1.0;
+			if (image == nullptr && material->Colour != nullptr)
+			{
+				r = SrgbToLinear(material->Colour->R);
+				g = SrgbToLinear(material->Colour->G);
+				b = SrgbToLinear(material->Colour->B);
+			}
+
+			StringBuilder^ json = gcnew StringBuilder();
+			json->Append("{\"name\":")->Append(Quote(material->Name))->Append(",\"pbrMetallicRoughness\":{\"baseColorFactor\":[");
+			json->Append(Number(r))->Append(",")->Append(Number(g))->Append(",")->Append(Number(b))->Append(",")->Append(Number(alpha))->Append("]");
+			if (image != nullptr)
+				json->AppendFormat(CultureInfo::InvariantCulture, ",\"baseColorTexture\":{{\"index\":{0}}}", imageKeys[image]);
+			json->Append(",\"metallicFactor\":0,\"roughnessFactor\":1},\"doubleSided\":true");
+			if (alpha < 1.0)
+				json->Append(",\"alphaMode\":\"BLEND\"");
+			json->Append("}");
+			return json->ToString();
+		}
+
+		static String^ NodeName(Placement^ placement, Body^ body)
+		{
+			String^ name = nullptr;
+			if (placement != nullptr)
+				name = (placement->Instance != nullptr) ? placement->Instance->Name : placement->Group->Name;
+			return String::IsNullOrEmpty(name) ? body->Name : name;
+		}
+
+		static String^ Number(double value)
+		{
+			return value.ToString("R", CultureInfo::InvariantCulture);
+		}
+
+		static String^ Number(float value)
+		{
+			return value.ToString("R", CultureInfo::InvariantCulture);
+		}
+
+		static String^ Quote(String^ value)
+		{
+			StringBuilder^ quoted = gcnew StringBuilder("\"");
+			if (value != nullptr)
+				for each (wchar_t c in value)
+				{
+					if (c == L'"' || c == L'\\')
+						quoted->Append(L'\\')->Append(c);
+					else if (c < 0x20)
+						quoted->AppendFormat(CultureInfo::InvariantCulture, "\\u{0:x4}", (int)c);
+					else
+						quoted->Append(c);
+				}
+			return quoted->Append("\"")->ToString();
+		}
+
+		static void WriteUInt32(Stream^ stream, unsigned int value)
+		{
+			for (int i = 0; i < 4; i++)
+				stream->WriteByte((Byte)(value >> (8 * i)));
+		}
+
+		// Streams the buffer in the order of Layout, one attribute at a time through a reused scratch buffer
+		void WriteBuffer(Stream^ stream)
+		{
+			for each (Body^ body in bodies)
+				for each (Primitive^ p in body->Primitives)
+				{
+					int vertices = p->VertexCount;
+					Reserve(12LL * Math::Max(vertices, p->TriangleCount));
+					pin_ptr<Byte> pinned = &scratch[0];
+					float* values = (float*)(Byte*)pinned;
+
+					int offset = 0;
+					for each (Mesh^ mesh in p->Meshes)
+					{
+						mesh->CopyPositions(values + 3 * offset);
+						offset += mesh->VertexCount;
+					}
+					stream->Write(scratch, 0, 12 * vertices);
+
+					offset = 0;
+					for each (Mesh^ mesh in p->Meshes)
+					{
+						mesh->CopyNormals(values + 3 * offset);
+						offset += mesh->VertexCount;
+					}
+					stream->Write(scratch, 0, 12 * vertices);
+
+					if (p->Textured)
+					{
+						offset = 0;
+						for each (Mesh^ mesh in p->Meshes)
+						{
+							mesh->CopyUVs(values + 2 * offset, true);
+							offset += mesh->VertexCount;
+						}
+						FlipV(values, vertices);
+						stream->Write(scratch, 0, 8 * vertices);
+					}
+
+					unsigned int* indices = (unsigned int*)(Byte*)pinned;
+					int triangle = 0;
+					offset = 0;
+					for each (Mesh^ mesh in p->Meshes)
+					{
+						mesh->CopyIndices(indices + 3 * triangle, (unsigned int)offset);
+						triangle += mesh->TriangleCount;
+						offset += mesh->VertexCount;
+					}
+					stream->Write(scratch, 0, 12 * p->TriangleCount);
+				}
+
+			for each (Body^ body in bodies)
+			{
+				int count = body->Instanced->Count;
+				if (count == 0) continue;
+
+				Reserve(40LL * count);
+				pin_ptr<Byte> pinned = &scratch[0];
+				float* translations = (float*)(Byte*)pinned;
+				float* rotations = translations + 3 * count;
+				float* scales = rotations + 4 * count;
+				for (int i = 0; i < count; i++)
+				{
+					pin_ptr<double> m = &body->Instanced[i]->World->Data[0];
+					DecomposeTrs(m, translations + 3 * i, rotations + 4 * i, scales + 3 * i);
+				}
+				stream->Write(scratch, 0, 40 * count);
+			}
+
+			for each (array<Byte>^ image in images)
+			{
+				stream->Write(image, 0, image->Length);
+				for (int i = image->Length; i % 4 != 0; i++)
+					stream->WriteByte(0);
+			}
+		}
+
+		void Reserve(long long size)
+		{
+			if (size > Int32::MaxValue)
+				throw gcnew InvalidOperationException("A glTF attribute exceeds 2 GB.");
+			if (scratch == nullptr || scratch->Length < size)
+				scratch = gcnew array<Byte>((int)Math::Max(size, 1LL << 16));
+		}
+	};
+}
\ No newline at end of file
@@ -31,6 +31,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include <SketchUpAPI/model/vertex.h>
 #include <SketchUpAPI/model/layer.h>
 #include <SketchUpAPI/model/group.h>
+#include <SketchUpAPI/model/component_definition.h>
 #include "utilities.h"
 #include <msclr/marshal.h>
 #include <vector>
@@ -38,6 +39,8 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include "Edge.h"
 #include "curve.h"
 #include "Instance.h"
+#include "LoadContext.h"
+#include "BoundingBox.h"
 
 using namespace System;
 using namespace System::Collections;
@@ -59,6 +62,11 @@ namespace SketchUpNET
 		System::String^ Layer;
 		System::String^ Guid;
 
+		/// <summary>
+		/// Bounds of the group in the coordinates of the entities containing it, world coordinates for top level groups
+		/// </summary>
+		BoundingBox^ Bounds;
+
 		Group(System::String^ name, List<Surface^>^ surfaces, List<Curve^>^ curves, List<Edge^>^ edges, List<Instance^>^ insts, List<Group^>^ group, Transform^ transformation, System::String^ layername, SketchUpNET::Material^ mat, System::String^ guid)
 		{
 			this->Name = name;
@@ -75,59 +83,76 @@ namespace SketchUpNET
 
 		Group(){};
 	internal:
-		static Group^ FromSU(SUGroupRef group, bool includeMeshes, System::Collections::Generic::Dictionary<String^, SketchUpNET::Material^>^ materials)
+		static Group^ FromSU(SUGroupRef group, LoadContext^ context)
 		{
-			SUStringRef name = SU_INVALID;
-			SUStringCreate(&name);
-			SUGroupGetName(group, &name);
-
-			SUStringRef guid = SU_INVALID;
-			SUStringCreate(&guid);
-			SUGroupGetGuid(group, &guid);
-
-
-			SUEntitiesRef entities = SU_INVALID;
-			SUGroupGetEntities(group, &entities);
+			Utilities::StringRef name;
+			SUGroupGetName(group, &name.Ref);
 
-			size_t faceCount = 0;
-			SUEntitiesGetNumFaces(entities, &faceCount);
+			Utilities::StringRef guid;
+			SUGroupGetGuid(group, &guid.Ref);
 
 			SUMaterialRef mat = SU_INVALID;
 			SUDrawingElementGetMaterial(SUGroupToDrawingElement(group), &mat);
-			SUStringRef matNameRef = SU_INVALID;
-			SUStringCreate(&matNameRef);
-			SUMaterialGetName(mat, &matNameRef);
-			System::String^ matName = SketchUpNET::Utilities::GetString(matNameRef);
-			SketchUpNET::Material^ groupMat = (materials->ContainsKey(matName)) ? materials[matName] : SketchUpNET::Material::FromSU(mat);
+			SketchUpNET::Material^ groupMat = SketchUpNET::Material::FromSU(mat, context);
 
 			SUTransformation transform = SU_INVALID;
 			SUGroupGetTransform(group, &transform);
-			
-			List<Surface^>^ surfaces = Surface::GetEntitySurfaces(entities, includeMeshes, materials);
-			List<Edge^>^ edges = Edge::GetEntityEdges(entities);
-			List<Curve^>^ curves = Curve::GetEntityCurves(entities);
-			List<Instance^>^ inst = Instance::GetEntityInstances(entities, materials);
-			List<Group^>^ grps = Group::GetEntityGroups(entities, includeMeshes, materials);
-			
+
+			// Copies of a group share one definition, its contents are converted only once
+			SUComponentDefinitionRef definition = SU_INVALID;
+			SUGroupGetDefinition(group, &definition);
+
+			Group^ body = nullptr;
+			bool cached = !SUIsInvalid(definition) && context->GroupDefinitions->TryGetValue(LoadContext::Key(definition), body);
+
+			List<Surface^>^ surfaces;
+			List<Edge^>^ edges;
+			List<Curve^>^ curves;
+			List<Instance^>^ inst;
+			List<Group^>^ grps;
+
+			if (cached)
+			{
+				surfaces = body->Surfaces;
+				edges = body->Edges;
+				curves = body->Curves;
+				inst = body->Instances;
+				grps = body->Groups;
+			}
+			else
+			{
+				SUEntitiesRef entities = SU_INVALID;
+				SUGroupGetEntities(group, &entities);
+
+				surfaces = Surface::GetEntitySurfaces(entities, context);
+				edges = Edge::GetEntityEdges(entities, context);
+				curves = Curve::GetEntityCurves(entities, context);
+				inst = Instance::GetEntityInstances(entities, context);
+				grps = Group::GetEntityGroups(entities, context);
+			}
+
 			// Layer
 			SULayerRef layer = SU_INVALID;
 			SUDrawingElementGetLayer(SUGroupToDrawingElement(group), &layer);
+			System::String^ layername = context->Store->LayerName(layer);
 
-			System::String^ layername = gcnew System::String("");
-			if (!SUIsInvalid(layer))
-			{
-				layername = SketchUpNET::Utilities::GetLayerName(layer);
-			}
+			Group^ v = gcnew Group(name.Value(), surfaces, curves, edges, inst, grps, Transform::FromSU(transform), layername, groupMat, guid.Value());
+			v->Bounds = BoundingBox::FromSU(SUGroupToDrawingElement(group));
 
-			Group^ v = gcnew Group(SketchUpNET::Utilities::GetString(name), surfaces, curves, edges, inst, grps, Transform::FromSU(transform), layername, groupMat, SketchUpNET::Utilities::GetString(guid));
+			if (!cached && !SUIsInvalid(definition))
+				context->GroupDefinitions->Add(LoadContext::Key(definition), v);
 
 			return v;
 		};
 
-		static List<Group^>^ GetEntityGroups(SUEntitiesRef entities, bool includeMeshes, System::Collections::Generic::Dictionary<String^, SketchUpNET::Material^>^ materials)
+		static List<Group^>^ GetEntityGroups(SUEntitiesRef entities, LoadContext^ context)
 		{
 			List<Group^>^ groups = gcnew List<Group^>();
 
+			const EntityFilter* filter = context->FilterFor(entities);
+			if (filter != nullptr && !filter->Includes(EntityKinds::Groups))
+				return groups;
+
 			size_t instanceCount = 0;
 			SUEntitiesGetNumGroups(entities, &instanceCount);
 
@@ -136,7 +161,9 @@ namespace SketchUpNET
 				SUEntitiesGetGroups(entities, instanceCount, &instances[0], &instanceCount);
 
 				for (size_t i = 0; i < instanceCount; i++) {
-					Group^ inst = Group::FromSU(instances[i], includeMeshes, materials);
+					if (filter != nullptr && !filter->Accepts(SUGroupToDrawingElement(instances[i])))
+						continue;
+					Group^ inst = Group::FromSU(instances[i], context);
 					groups->Add(inst);
 				}
 
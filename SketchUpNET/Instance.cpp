@@ -37,6 +37,8 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include "transform.h"
 #include "utilities.h"
 #include "Material.h"
+#include "LoadContext.h"
+#include "BoundingBox.h"
 
 using namespace System;
 using namespace System::Collections;
@@ -55,6 +57,11 @@ namespace SketchUpNET
 		System::String^ Layer;
 		SketchUpNET::Material^ Material;
 
+		/// <summary>
+		/// Bounds of the instance in the coordinates of the entities containing it, world coordinates for top level instances
+		/// </summary>
+		BoundingBox^ Bounds;
+
 		Instance(System::String^ name, System::String^ guid, String^ parent, Transform^ transformation, System::String^ layername, SketchUpNET::Material^ mat)
 		{
 			this->Name = name;
@@ -68,43 +75,36 @@ namespace SketchUpNET
 
 		Instance(){};
 	internal:
-		static Instance^ FromSU(SUComponentInstanceRef comp, System::Collections::Generic::Dictionary<String^, SketchUpNET::Material^>^ materials)
+		/// <summary>
+		/// Definition the instance was created from, used to resolve its Parent
+		/// </summary>
+		IntPtr Definition;
+
+		static Instance^ FromSU(SUComponentInstanceRef comp, LoadContext^ context)
 		{
-			SUStringRef name = SU_INVALID;
-			SUStringCreate(&name);
-			SUComponentInstanceGetName(comp, &name);
+			Utilities::StringRef name;
+			SUComponentInstanceGetName(comp, &name.Ref);
 
 			SUComponentDefinitionRef definition = SU_INVALID;
 			SUComponentInstanceGetDefinition(comp, &definition);
 
-			SUStringRef instanceguid = SU_INVALID;
-			SUStringCreate(&instanceguid);
-			SUComponentInstanceGetGuid(comp, &instanceguid);
+			Utilities::StringRef instanceguid;
+			SUComponentInstanceGetGuid(comp, &instanceguid.Ref);
 
 
 			SUMaterialRef mat = SU_INVALID;
 			SUDrawingElementGetMaterial(SUComponentInstanceToDrawingElement(comp), &mat);
-			SUStringRef matNameRef = SU_INVALID;
-			SUStringCreate(&matNameRef);
-			SUMaterialGetName(mat, &matNameRef);
-			System::String^ matName = SketchUpNET::Utilities::GetString(matNameRef);
-			SketchUpNET::Material^ groupMat = (materials->ContainsKey(matName)) ? materials[matName] : SketchUpNET::Material::FromSU(mat);
+			SketchUpNET::Material^ groupMat = SketchUpNET::Material::FromSU(mat, context);
 			
 
 			// Layer
 			SULayerRef layer = SU_INVALID;
 			SUDrawingElementGetLayer(SUComponentInstanceToDrawingElement(comp), &layer);
+			System::String^ layername = context->Store->LayerName(layer);
 
-			System::String^ layername = gcnew System::String("");
-			if (!SUIsInvalid(layer))
-			{
-				layername = Utilities::GetLayerName(layer);
-			}
-
-			SUStringRef guid = SU_INVALID;
-			SUStringCreate(&guid);
-			SUComponentDefinitionGetGuid(definition, &guid);
-			System::String^ guidstring = SketchUpNET::Utilities::GetString(guid);
+			Utilities::StringRef guid;
+			SUComponentDefinitionGetGuid(definition, &guid.Ref);
+			System::String^ guidstring = guid.Value();
 
 			String^ parent = guidstring;
 
@@ -113,16 +113,23 @@ namespace SketchUpNET
 			SUComponentInstanceGetTransform(comp, &transform);
 			
 
-			Instance^ v = gcnew Instance(SketchUpNET::Utilities::GetString(name), SketchUpNET::Utilities::GetString(instanceguid), parent, Transform::FromSU(transform), layername, groupMat);
+			Instance^ v = gcnew Instance(name.Value(), instanceguid.Value(), parent, Transform::FromSU(transform), layername, groupMat);
+			v->Definition = LoadContext::Key(definition);
+			v->Bounds = BoundingBox::FromSU(SUComponentInstanceToDrawingElement(comp));
+			context->Instances->Add(v);
 
 			return v;
 		};
-		static List<Instance^>^ GetEntityInstances(SUEntitiesRef entities, System::Collections::Generic::Dictionary<String^, SketchUpNET::Material^>^ materials)
+		static List<Instance^>^ GetEntityInstances(SUEntitiesRef entities, LoadContext^ context)
 		{
 			List<Instance^>^ instancelist = gcnew List<Instance^>();
 
 			//Get All Component Instances
 
+			const EntityFilter* filter = context->FilterFor(entities);
+			if (filter != nullptr && !filter->Includes(EntityKinds::Instances))
+				return instancelist;
+
 			size_t instanceCount = 0;
 			SUEntitiesGetNumInstances(entities, &instanceCount);
 
@@ -131,7 +138,9 @@ namespace SketchUpNET
 				SUEntitiesGetInstances(entities, instanceCount, &instances[0], &instanceCount);
 
 				for (size_t i = 0; i < instanceCount; i++) {
-					Instance^ inst = Instance::FromSU(instances[i], materials);
+					if (filter != nullptr && !filter->Accepts(SUComponentInstanceToDrawingElement(instances[i])))
+						continue;
+					Instance^ inst = Instance::FromSU(instances[i], context);
 					instancelist->Add(inst);
 				}
 
@@ -0,0 +1,90 @@
+/*
+
+SketchUpNET - a C++ Wrapper for the Trimble(R) SketchUp(R) C API
+Copyright(C) 2015, Autor: Maximilian Thumfart
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <SketchUpAPI/slapi.h>
+#include "Utilities.h"
+#include "Material.h"
+#include "Component.h"
+
+using namespace System;
+using namespace System::Collections;
+using namespace System::Collections::Generic;
+
+namespace SketchUpNET
+{
+	/// <summary>
+	/// Many instances of one component definition, placed by packed transforms instead of Instance objects
+	/// </summary>
+	public ref class InstanceSet
+	{
+	public:
+		/// <summary>
+		/// Values per instance in Transforms
+		/// </summary>
+		static const int Stride = 12;
+
+		/// <summary>
+		/// Definition placed by all instances
+		/// </summary>
+		Component^ Definition;
+
+		/// <summary>
+		/// Affine transforms as row major 3x4 matrices, twelve values per instance.
+		/// Each row holds three rotation and scale values followed by the translation in meters.
+		/// </summary>
+		array<double>^ Transforms;
+
+		System::String^ Layer;
+
+		SketchUpNET::Material^ Material;
+
+		/// <summary>
+		/// Number of instances
+		/// </summary>
+		property int Count
+		{
+			int get() { return (Transforms == nullptr) ? 0 : Transforms->Length / Stride; }
+		}
+
+		/// <summary>
+		/// Creates a set of instances
+		/// </summary>
+		/// <param name="definition">Definition to place</param>
+		/// <param name="transforms">Row major 3x4 transforms in meters, twelve values per instance</param>
+		/// <param name="layer">Layername</param>
+		/// <param name="material">Material of the instances or null</param>
+		InstanceSet(Component^ definition, array<double>^ transforms, System::String^ layer, SketchUpNET::Material^ material)
+		{
+			if (definition == nullptr)
+				throw gcnew ArgumentNullException("definition");
+			if (transforms == nullptr || transforms->Length % Stride != 0)
+				throw gcnew ArgumentException("Transforms must hold twelve values per instance.", "transforms");
+			this->Definition = definition;
+			this->Transforms = transforms;
+			this->Layer = layer;
+			this->Material = material;
+		};
+
+		InstanceSet() {};
+	};
+}
\ No newline at end of file
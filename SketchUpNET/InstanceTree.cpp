@@ -0,0 +1,322 @@
+/*
+
+SketchUpNET - a C++ Wrapper for the Trimble(R) SketchUp(R) C API
+Copyright(C) 2015, Autor: Maximilian Thumfart
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+#pragma once
+
+#include "Utilities.h"
+#include "Transform.h"
+#include "Surface.h"
+#include "Edge.h"
+#include "Curve.h"
+#include "Material.h"
+#include "Group.h"
+#include "Instance.h"
+#include "Component.h"
+#include "BoundingBox.h"
+
+using namespace System;
+using namespace System::Collections;
+using namespace System::Collections::Generic;
+
+namespace SketchUpNET
+{
+	/// <summary>
+	/// One occurrence of a group or component instance in the model, reached along a unique path from the top level
+	/// </summary>
+	public ref class Placement
+	{
+	public:
+		/// <summary>
+		/// Placed component instance, null for groups
+		/// </summary>
+		SketchUpNET::Instance^ Instance;
+
+		/// <summary>
+		/// Placed group, null for component instances
+		/// </summary>
+		SketchUpNET::Group^ Group;
+
+		/// <summary>
+		/// Definition of the placed instance, null for groups
+		/// </summary>
+		Component^ Definition;
+
+		/// <summary>
+		/// Transformation from the placed contents to model coordinates, composed along the whole path
+		/// </summary>
+		Transform^ World;
+
+		/// <summary>
+		/// Bounds of the placed contents in model coordinates
+		/// </summary>
+		BoundingBox^ Bounds;
+
+		/// <summary>
+		/// Material inherited along the path, applies to faces without a material of their own
+		/// </summary>
+		SketchUpNET::Material^ Material;
+
+		/// <summary>
+		/// Index of the enclosing placement, -1 at the top level of the model
+		/// </summary>
+		int Parent;
+
+		/// <summary>
+		/// Nesting depth, 0 at the top level of the model
+		/// </summary>
+		int Depth;
+
+		/// <summary>
+		/// Index of the first edge of this placement in InstanceTree.GetWorldEdges
+		/// </summary>
+		int FirstEdge;
+
+		/// <summary>
+		/// Surfaces of the placed contents in their own coordinates
+		/// </summary>
+		property List<Surface^>^ Surfaces
+		{
+			List<Surface^>^ get() { return (Group != nullptr) ? Group->Surfaces : Definition->Surfaces; }
+		}
+
+		/// <summary>
+		/// Edges of the placed contents in their own coordinates
+		/// </summary>
+		property List<Edge^>^ Edges
+		{
+			List<Edge^>^ get() { return (Group != nullptr) ? Group->Edges : Definition->Edges; }
+		}
+
+		/// <summary>
+		/// Curves of the placed contents in their own coordinates
+		/// </summary>
+		property List<Curve^>^ Curves
+		{
+			List<Curve^>^ get() { return (Group != nullptr) ? Group->Curves : Definition->Curves; }
+		}
+
+	internal:
+		property List<SketchUpNET::Group^>^ Groups
+		{
+			List<SketchUpNET::Group^>^ get() { return (Group != nullptr) ? Group->Groups : Definition->Groups; }
+		}
+
+		property List<SketchUpNET::Instance^>^ Instances
+		{
+			List<SketchUpNET::Instance^>^ get() { return (Group != nullptr) ? Group->Instances : Definition->Instances; }
+		}
+	};
+
+	/// <summary>
+	/// All groups and component instances of a model with their world transformations.
+	/// The definition graph is walked once; each path from the top level becomes one Placement,
+	/// like an SUInstancePath with its full transformation.
+	/// </summary>
+	public ref class InstanceTree
+	{
+	public:
+		/// <summary>
+		/// Placements in depth first order, parents before their children
+		/// </summary>
+		List<Placement^>^ Placements;
+
+		/// <summary>
+		/// Total number of edges of all placements
+		/// </summary>
+		int EdgeCount;
+
+		/// <summary>
+		/// Placements of a component definition, empty if it is not placed
+		/// </summary>
+		/// <param name="definition">Component definition</param>
+		List<Placement^>^ PlacementsOf(Component^ definition)
+		{
+			List<Placement^>^ result;
+			if (definition == nullptr || !byDefinition->TryGetValue(definition, result))
+				return gcnew List<Placement^>();
+			return result;
+		}
+
+		/// <summary>
+		/// Flattens the groups and component instances below the top level of a model
+		/// </summary>
+		/// <param name="groups">Top level groups</param>
+		/// <param name="instances">Top level component instances</param>
+		static InstanceTree^ Build(List<SketchUpNET::Group^>^ groups, List<SketchUpNET::Instance^>^ instances)
+		{
+			InstanceTree^ tree = gcnew InstanceTree();
+			tree->Add(groups, instances, -1);
+			return tree;
+		}
+
+		/// <summary>
+		/// Transforms packed xyz points given in the coordinates of a placement to model coordinates, in place
+		/// </summary>
+		/// <param name="placement">Placement index</param>
+		/// <param name="points">Points as xyz triples</param>
+		void ToWorld(int placement, array<double>^ points)
+		{
+			Placements[placement]->World->TransformPoints(points);
+		}
+
+		/// <summary>
+		/// Start and end points of the edges of all placements in model coordinates, six values per edge.
+		/// The edges of Placements[i] start at Placements[i].FirstEdge. Placements are transformed in parallel.
+		/// </summary>
+		/// <param name="singleThreaded">Transform on the calling thread only</param>
+		array<double>^ GetWorldEdges(bool singleThreaded)
+		{
+			array<double>^ result = gcnew array<double>(6 * EdgeCount);
+			EdgeWorker^ worker = gcnew EdgeWorker(this, result);
+			Utilities::ForRange(0, Placements->Count, 64, gcnew Action<Tuple<int, int>^>(worker, &EdgeWorker::Run), singleThreaded);
+			return result;
+		}
+
+	internal:
+		static SketchUpNET::Material^ Inherit(SketchUpNET::Material^ inherited, SketchUpNET::Material^ own)
+		{
+			return (own != nullptr && !String::IsNullOrEmpty(own->Name)) ? own : inherited;
+		}
+
+	private:
+		Dictionary<Component^, List<Placement^>^>^ byDefinition;
+
+		InstanceTree()
+		{
+			Placements = gcnew List<Placement^>();
+			byDefinition = gcnew Dictionary<Component^, List<Placement^>^>();
+			EdgeCount = 0;
+		}
+
+		void Add(List<SketchUpNET::Group^>^ groups, List<SketchUpNET::Instance^>^ instances, int parent)
+		{
+			Placement^ owner = (parent < 0) ? nullptr : Placements[parent];
+			int depth = (owner == nullptr) ? 0 : owner->Depth + 1;
+
+			// Guards against cyclic definitions in broken files
+			if (depth > 64) return;
+
+			if (groups != nullptr)
+				for each (SketchUpNET::Group^ group in groups)
+				{
+					Placement^ placement = Place(owner, group->Transformation, group->Material, parent, depth);
+					placement->Group = group;
+					placement->Bounds = WorldBounds(owner, group->Bounds, nullptr, placement->World);
+					AddChildren(placement);
+				}
+
+			if (instances != nullptr)
+				for each (SketchUpNET::Instance^ instance in instances)
+				{
+					Component^ definition = dynamic_cast<Component^>(instance->Parent);
+					if (definition == nullptr) continue;
+
+					Placement^ placement = Place(owner, instance->Transformation, instance->Material, parent, depth);
+					placement->Instance = instance;
+					placement->Definition = definition;
+					placement->Bounds = WorldBounds(owner, instance->Bounds, definition, placement->World);
+
+					List<Placement^>^ placements;
+					if (!byDefinition->TryGetValue(definition, placements))
+					{
+						placements = gcnew List<Placement^>();
+						byDefinition->Add(definition, placements);
+					}
+					placements->Add(placement);
+					AddChildren(placement);
+				}
+		}
+
+		Placement^ Place(Placement^ owner, Transform^ local, SketchUpNET::Material^ material, int parent, int depth)
+		{
+			array<double>^ world = Transform::Compose((owner == nullptr) ? nullptr : owner->World->Data, (local == nullptr) ? nullptr : local->Data);
+
+			Placement^ placement = gcnew Placement();
+			placement->World = (world == nullptr) ? Transform::Identity : gcnew Transform(world);
+			placement->Material = Inherit((owner == nullptr) ? nullptr : owner->Material, material);
+			placement->Parent = parent;
+			placement->Depth = depth;
+			Placements->Add(placement);
+			return placement;
+		}
+
+		/// <summary>
+		/// Bounds read in the coordinates of the owner, or the definition bounds if the element had none
+		/// </summary>
+		static BoundingBox^ WorldBounds(Placement^ owner, BoundingBox^ local, Component^ definition, Transform^ world)
+		{
+			if (local != nullptr)
+				return (owner == nullptr) ? local : local->Transformed(owner->World);
+			if (definition != nullptr && definition->Bounds != nullptr)
+				return definition->Bounds->Transformed(world);
+			return gcnew BoundingBox();
+		}
+
+		void AddChildren(Placement^ placement)
+		{
+			placement->FirstEdge = EdgeCount;
+			List<Edge^>^ edges = placement->Edges;
+			if (edges != nullptr)
+				EdgeCount += edges->Count;
+
+			Add(placement->Groups, placement->Instances, Placements->Count - 1);
+		}
+
+		/// <summary>
+		/// Copies and transforms the edges of a range of placements into their slots of the result
+		/// </summary>
+		ref class EdgeWorker
+		{
+		public:
+			EdgeWorker(InstanceTree^ tree, array<double>^ result)
+			{
+				this->tree = tree;
+				this->result = result;
+			}
+
+			void Run(Tuple<int, int>^ range)
+			{
+				if (result->Length == 0) return;
+				pin_ptr<double> p = &result[0];
+
+				for (int i = range->Item1; i < range->Item2; i++)
+				{
+					Placement^ placement = tree->Placements[i];
+					List<Edge^>^ edges = placement->Edges;
+					if (edges == nullptr || edges->Count == 0) continue;
+
+					double* target = p + 6 * placement->FirstEdge;
+					for (int e = 0; e < edges->Count; e++)
+						edges[e]->CopyPoints(target + 6 * e);
+
+					pin_ptr<double> m = &placement->World->Data[0];
+					TransformMatrix matrix(m);
+					matrix.Points(target, 2 * edges->Count);
+				}
+			}
+
+		private:
+			InstanceTree^ tree;
+			array<double>^ result;
+		};
+	};
+
+
+}
\ No newline at end of file
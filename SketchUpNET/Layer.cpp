@@ -61,6 +61,26 @@ namespace SketchUpNET
 			return v;
 		};
 
+		static List<Layer^>^ GetModelLayers(SUModelRef model)
+		{
+			List<Layer^>^ layerlist = gcnew List<Layer^>();
+
+			size_t layerCount = 0;
+			SUModelGetNumLayers(model, &layerCount);
+
+			if (layerCount > 0) {
+				std::vector<SULayerRef> layers(layerCount);
+				SUModelGetLayers(model, layerCount, &layers[0], &layerCount);
+
+				for (size_t i = 0; i < layerCount; i++) {
+					Layer^ layer = Layer::FromSU(layers[i]);
+					layerlist->Add(layer);
+				}
+			}
+
+			return layerlist;
+		}
+
 	};
 
 
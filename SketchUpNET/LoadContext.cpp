@@ -0,0 +1,253 @@
+/*
+
+SketchUpNET - a C++ Wrapper for the Trimble(R) SketchUp(R) C API
+Copyright(C) 2015, Autor: Maximilian Thumfart
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <SketchUpAPI/slapi.h>
+#include <SketchUpAPI/geometry.h>
+#include <SketchUpAPI/model/entities.h>
+#include <SketchUpAPI/model/component_definition.h>
+#include <SketchUpAPI/model/texture_writer.h>
+#include <msclr/marshal.h>
+#include <vector>
+#include "GeometryStore.h"
+#include "LoadOptions.h"
+
+using namespace System;
+using namespace System::Collections;
+using namespace System::Collections::Generic;
+
+namespace SketchUpNET
+{
+	ref class Material;
+	ref class Group;
+	ref class Component;
+	ref class Instance;
+	ref class Surface;
+
+	/// <summary>
+	/// Raw face data copied from the SketchUp API, converted to a Surface after extraction
+	/// </summary>
+	struct SurfaceRecord
+	{
+		size_t Face;
+		size_t Mesh;
+		SUVector3D Normal;
+		double Area;
+		int Layer;
+	};
+
+	/// <summary>
+	/// State shared by all conversions of a single model load
+	/// </summary>
+	ref class LoadContext
+	{
+	internal:
+
+		/// <summary>
+		/// Load meshed geometries of surfaces
+		/// </summary>
+		bool IncludeMeshes;
+
+		/// <summary>
+		/// Model materials by name
+		/// </summary>
+		Dictionary<String^, Material^>^ Materials;
+
+		/// <summary>
+		/// Materials already resolved for a material ref
+		/// </summary>
+		Dictionary<IntPtr, Material^>^ MaterialRefs;
+
+		/// <summary>
+		/// Native geometry all surfaces, edges and meshes are stored in
+		/// </summary>
+		GeometryStore^ Store;
+
+		/// <summary>
+		/// Converted component definitions by SUComponentDefinitionRef
+		/// </summary>
+		Dictionary<IntPtr, Component^>^ Definitions;
+
+		/// <summary>
+		/// First converted group of each group definition by SUComponentDefinitionRef.
+		/// Groups sharing a definition share its surfaces, edges, curves, instances and groups.
+		/// </summary>
+		Dictionary<IntPtr, Group^>^ GroupDefinitions;
+
+		/// <summary>
+		/// All converted component instances, resolved to their definitions after loading
+		/// </summary>
+		List<Instance^>^ Instances;
+
+		/// <summary>
+		/// Convert extracted geometry on the calling thread only
+		/// </summary>
+		bool SingleThreaded;
+
+		/// <summary>
+		/// Convert component definition bodies only when they are accessed
+		/// </summary>
+		bool Lazy;
+
+		/// <summary>
+		/// The model the context extracts from is still open
+		/// </summary>
+		bool ModelOpen;
+
+		/// <summary>
+		/// Surfaces, surface lists and instances already handled by a conversion phase
+		/// </summary>
+		int BuiltSurfaces;
+		int FilledSurfaceLists;
+		int ResolvedInstances;
+
+		/// <summary>
+		/// Filter for the top level entities, null when everything is loaded
+		/// </summary>
+		EntityFilter* Filter;
+
+		/// <summary>
+		/// Top level entities of the model the filter applies to
+		/// </summary>
+		void* Root;
+
+		/// <summary>
+		/// Texture writer the faces are loaded into to extract texture coordinates, null if they are not extracted
+		/// </summary>
+		SUTextureWriterRef* TextureWriter;
+
+		/// <summary>
+		/// Extracted faces waiting for conversion, with their materials
+		/// </summary>
+		std::vector<SurfaceRecord>* Surfaces;
+		List<Material^>^ FrontMaterials;
+		List<Material^>^ BackMaterials;
+
+		/// <summary>
+		/// Surface lists handed out during extraction and the records they are filled with
+		/// </summary>
+		List<List<Surface^>^>^ SurfaceLists;
+		std::vector<GeometryRange>* SurfaceListRanges;
+
+		LoadContext(bool includeMeshes, Dictionary<String^, Material^>^ materials, GeometryStore^ store)
+		{
+			this->IncludeMeshes = includeMeshes;
+			this->Materials = materials;
+			this->MaterialRefs = gcnew Dictionary<IntPtr, Material^>();
+			this->Store = store;
+			this->Definitions = gcnew Dictionary<IntPtr, Component^>();
+			this->GroupDefinitions = gcnew Dictionary<IntPtr, Group^>();
+			this->Instances = gcnew List<Instance^>();
+			this->SingleThreaded = false;
+			this->Lazy = false;
+			this->ModelOpen = true;
+			this->BuiltSurfaces = 0;
+			this->FilledSurfaceLists = 0;
+			this->ResolvedInstances = 0;
+			this->Filter = nullptr;
+			this->Root = nullptr;
+			this->TextureWriter = nullptr;
+			this->Surfaces = new std::vector<SurfaceRecord>();
+			this->FrontMaterials = gcnew List<Material^>();
+			this->BackMaterials = gcnew List<Material^>();
+			this->SurfaceLists = gcnew List<List<Surface^>^>();
+			this->SurfaceListRanges = new std::vector<GeometryRange>();
+		};
+
+		~LoadContext()
+		{
+			ReleaseTextureWriter();
+			this->!LoadContext();
+		}
+
+		/// <summary>
+		/// Frees native memory only; SDK objects are released by CloseModel or the destructor,
+		/// never on the finalizer thread
+		/// </summary>
+		!LoadContext()
+		{
+			delete Surfaces;
+			delete SurfaceListRanges;
+			delete Filter;
+			Surfaces = nullptr;
+			SurfaceListRanges = nullptr;
+			Filter = nullptr;
+		}
+
+		/// <summary>
+		/// Applies the load options of a model, filtering its top level entities
+		/// </summary>
+		void SetFilter(SUModelRef model, LoadOptions^ options)
+		{
+			if (options == nullptr)
+				return;
+
+			if (options->TextureCoordinates)
+			{
+				TextureWriter = new SUTextureWriterRef();
+				SUSetInvalid(*TextureWriter);
+				SUTextureWriterCreate(TextureWriter);
+			}
+
+			if (!options->Filters)
+				return;
+
+			SUEntitiesRef entities = SU_INVALID;
+			SUModelGetEntities(model, &entities);
+			Root = entities.ptr;
+			Filter = new EntityFilter(model, options);
+		}
+
+		/// <summary>
+		/// Filter to apply to the given entities, null if all of them are loaded
+		/// </summary>
+		const EntityFilter* FilterFor(SUEntitiesRef entities)
+		{
+			return (Filter != nullptr && entities.ptr == Root) ? Filter : nullptr;
+		}
+
+		/// <summary>
+		/// Marks the model as released. The texture writer belongs to the model and is released with it.
+		/// </summary>
+		void CloseModel()
+		{
+			ModelOpen = false;
+			ReleaseTextureWriter();
+		}
+
+		void ReleaseTextureWriter()
+		{
+			if (TextureWriter == nullptr)
+				return;
+			SUTextureWriterRelease(TextureWriter);
+			delete TextureWriter;
+			TextureWriter = nullptr;
+		}
+
+		static IntPtr Key(SUComponentDefinitionRef definition)
+		{
+			return IntPtr(definition.ptr);
+		}
+	};
+
+
+}
@@ -0,0 +1,228 @@
+/*
+
+SketchUpNET - a C++ Wrapper for the Trimble(R) SketchUp(R) C API
+Copyright(C) 2015, Autor: Maximilian Thumfart
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <SketchUpAPI/slapi.h>
+#include <SketchUpAPI/geometry.h>
+#include <SketchUpAPI/model/model.h>
+#include <SketchUpAPI/model/layer.h>
+#include <SketchUpAPI/model/drawing_element.h>
+#include <algorithm>
+#include <vector>
+#include "Utilities.h"
+#include "Vertex.h"
+
+using namespace System;
+using namespace System::Collections;
+using namespace System::Collections::Generic;
+
+namespace SketchUpNET
+{
+	/// <summary>
+	/// Kinds of top level entities to load
+	/// </summary>
+	[Flags]
+	public enum class EntityKinds
+	{
+		None = 0,
+		Surfaces = 1,
+		Edges = 2,
+		Curves = 4,
+		Groups = 8,
+		Instances = 16,
+		Components = 32,
+		All = Surfaces | Edges | Curves | Groups | Instances | Components
+	};
+
+	/// <summary>
+	/// Filters applied while a model is loaded. Entities failing a filter are skipped before they are converted.
+	/// Filters apply to the top level of the model; the contents of an accepted Group or Component are loaded completely.
+	/// </summary>
+	public ref class LoadOptions
+	{
+	public:
+		/// <summary>
+		/// Names of the layers to load, null loads all layers
+		/// </summary>
+		ICollection<String^>^ Layers;
+
+		/// <summary>
+		/// Kinds of entities to load
+		/// </summary>
+		EntityKinds Kinds;
+
+		/// <summary>
+		/// Load hidden entities and entities on hidden layers
+		/// </summary>
+		bool IncludeHidden;
+
+		/// <summary>
+		/// Lower corner of the region to load in meters, null loads the whole model
+		/// </summary>
+		Vertex^ RegionMin;
+
+		/// <summary>
+		/// Upper corner of the region to load in meters
+		/// </summary>
+		Vertex^ RegionMax;
+
+		/// <summary>
+		/// Store each SketchUp vertex and edge once and share it between all faces using it.
+		/// Enables the adjacency queries of GeometryStore.
+		/// </summary>
+		bool SharedTopology;
+
+		/// <summary>
+		/// Extract front and back texture coordinates of surface meshes.
+		/// Requires meshes to be included.
+		/// </summary>
+		bool TextureCoordinates;
+
+		/// <summary>
+		/// Read the pixels of all material textures, one TextureImage per distinct image
+		/// </summary>
+		bool TextureImages;
+
+		LoadOptions()
+		{
+			this->Kinds = EntityKinds::All;
+			this->IncludeHidden = true;
+		};
+
+		/// <summary>
+		/// Options loading only the given layer
+		/// </summary>
+		/// <param name="layer">Layer name</param>
+		static LoadOptions^ ByLayer(String^ layer)
+		{
+			LoadOptions^ options = gcnew LoadOptions();
+			options->Layers = gcnew List<String^>(gcnew array<String^> { layer });
+			return options;
+		}
+
+	internal:
+		/// <summary>
+		/// Any of the filters excludes entities
+		/// </summary>
+		property bool Filters
+		{
+			bool get()
+			{
+				return Layers != nullptr || Kinds != EntityKinds::All || !IncludeHidden || (RegionMin != nullptr && RegionMax != nullptr);
+			}
+		}
+	};
+
+	/// <summary>
+	/// Native form of LoadOptions, resolved against the layers of a model once per load
+	/// so that testing an entity costs a few API calls and no string conversion
+	/// </summary>
+	class EntityFilter
+	{
+	public:
+		EntityFilter(SUModelRef model, LoadOptions^ options)
+		{
+			kinds = (unsigned)options->Kinds;
+			hidden = options->IncludeHidden;
+			allLayers = (options->Layers == nullptr && hidden);
+
+			if (!allLayers)
+			{
+				size_t layerCount = 0;
+				SUModelGetNumLayers(model, &layerCount);
+
+				if (layerCount > 0) {
+					std::vector<SULayerRef> all(layerCount);
+					SUModelGetLayers(model, layerCount, &all[0], &layerCount);
+
+					for (size_t i = 0; i < layerCount; i++) {
+						bool visible = true;
+						SULayerGetVisibility(all[i], &visible);
+						if (!hidden && !visible)
+							continue;
+						if (options->Layers != nullptr && !options->Layers->Contains(Utilities::GetLayerName(all[i])))
+							continue;
+						layers.push_back(all[i].ptr);
+					}
+				}
+				std::sort(layers.begin(), layers.end());
+			}
+
+			region = (options->RegionMin != nullptr && options->RegionMax != nullptr);
+			if (region)
+			{
+				box.min_point.x = options->RegionMin->X * 39.3701;
+				box.min_point.y = options->RegionMin->Y * 39.3701;
+				box.min_point.z = options->RegionMin->Z * 39.3701;
+				box.max_point.x = options->RegionMax->X * 39.3701;
+				box.max_point.y = options->RegionMax->Y * 39.3701;
+				box.max_point.z = options->RegionMax->Z * 39.3701;
+			}
+		}
+
+		bool Includes(EntityKinds kind) const
+		{
+			return (kinds & (unsigned)kind) != 0;
+		}
+
+		bool Accepts(SUDrawingElementRef element) const
+		{
+			if (!allLayers)
+			{
+				SULayerRef layer = SU_INVALID;
+				SUDrawingElementGetLayer(element, &layer);
+				if (!std::binary_search(layers.begin(), layers.end(), layer.ptr))
+					return false;
+			}
+
+			if (!hidden)
+			{
+				bool isHidden = false;
+				SUDrawingElementGetHidden(element, &isHidden);
+				if (isHidden)
+					return false;
+			}
+
+			if (region)
+			{
+				SUBoundingBox3D bounds;
+				if (SUDrawingElementGetBoundingBox(element, &bounds) != SU_ERROR_NONE)
+					return true;
+
+				if (bounds.max_point.x < box.min_point.x || bounds.min_point.x > box.max_point.x ||
+					bounds.max_point.y < box.min_point.y || bounds.min_point.y > box.max_point.y ||
+					bounds.max_point.z < box.min_point.z || bounds.min_point.z > box.max_point.z)
+					return false;
+			}
+
+			return true;
+		}
+
+	private:
+		unsigned kinds;
+		bool hidden;
+		bool allLayers;
+		std::vector<void*> layers;
+		bool region;
+		SUBoundingBox3D box;
+	};
+}
\ No newline at end of file
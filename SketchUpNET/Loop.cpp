@@ -34,6 +34,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include <msclr/marshal.h>
 #include <vector>
 #include "edge.h"
+#include "GeometryStore.h"
 
 using namespace System;
 using namespace System::Collections;
@@ -44,7 +45,21 @@ namespace SketchUpNET
 	public ref class Loop
 	{
 	public:
-		List<Edge^>^ Edges;
+		property List<Edge^>^ Edges
+		{
+			List<Edge^>^ get()
+			{
+				if (edges == nullptr && store != nullptr)
+				{
+					GeometryRange range = store->Buffer->Loops[index];
+					edges = gcnew List<Edge^>((int)range.Count);
+					for (size_t i = range.Start; i < range.Start + range.Count; i++)
+						edges->Add(gcnew Edge(store, store->Buffer->LoopEdges[i]));
+				}
+				return edges;
+			}
+			void set(List<Edge^>^ value) { edges = value; }
+		}
 
 		Loop(List<Edge^>^ corners)
 		{
@@ -53,27 +68,26 @@ namespace SketchUpNET
 
 		Loop(){};
 	internal:
-		static Loop^ FromSU(SULoopRef loop)
+		/// <summary>
+		/// Creates a loop view on a stored loop
+		/// </summary>
+		Loop(GeometryStore^ store, size_t index)
 		{
+			this->store = store;
+			this->index = index;
+		};
 
-			List<Edge^>^ edgelist = gcnew List<Edge^>();
-			
-			size_t num_vertices;
-			SULoopGetNumVertices(loop, &num_vertices);
-			if (num_vertices > 0) {
-				std::vector<SUEdgeRef> edges(num_vertices);
-				SULoopGetEdges(loop, num_vertices, &edges[0], &num_vertices);
-				for (size_t i = 0; i < num_vertices; i++) {
-					SUEdgeRef edge = edges[i];
-					edgelist->Add(Edge::FromSU(edge));
-				}
-			}
-
-			Loop^ v = gcnew Loop(edgelist);
+		static Loop^ FromSU(SULoopRef loop, GeometryStore^ store)
+		{
+			Loop^ v = gcnew Loop(store, store->AddLoop(loop));
 
 			return v;
 		};
 
+	private:
+		List<Edge^>^ edges;
+		GeometryStore^ store;
+		size_t index;
 
 	};
 
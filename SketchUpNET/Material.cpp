@@ -89,10 +89,9 @@ namespace SketchUpNET
 
 		static Material^ FromSU(SUMaterialRef material)
 		{
-			SUStringRef name = SU_INVALID;
-			SUStringCreate(&name);
-			SUMaterialGetName(material, &name);
-			String^ n = SketchUpNET::Utilities::GetString(name);
+			Utilities::StringRef name;
+			SUMaterialGetName(material, &name.Ref);
+			String^ n = name.Value();
 
 
 			bool useopacity = false;
@@ -139,6 +138,62 @@ namespace SketchUpNET
 			return v;
 		}
 
+		/// <summary>
+		/// Shared material of a material ref, decoded once per ref and load.
+		/// Materials of the model are matched by name, all others are converted on first use.
+		/// </summary>
+		static Material^ FromSU(SUMaterialRef material, LoadContext^ context)
+		{
+			Material^ v = nullptr;
+			if (context->MaterialRefs->TryGetValue(IntPtr(material.ptr), v))
+				return v;
+
+			Utilities::StringRef name;
+			SUMaterialGetName(material, &name.Ref);
+			String^ n = name.Value();
+
+			if (!context->Materials->TryGetValue(n, v))
+				v = Material::FromSU(material);
+
+			context->MaterialRefs->Add(IntPtr(material.ptr), v);
+			return v;
+		}
+
+		static Dictionary<String^, Material^>^ GetModelMaterials(SUModelRef model)
+		{
+			Dictionary<String^, Material^>^ materiallist = gcnew Dictionary<String^, Material^>();
+
+			size_t matCount = 0;
+			SUModelGetNumMaterials(model, &matCount);
+
+			if (matCount > 0) {
+				std::vector<SUMaterialRef> materials(matCount);
+				SUModelGetMaterials(model, matCount, &materials[0], &matCount);
+
+				for (size_t i = 0; i < matCount; i++) {
+					Material^ mat = Material::FromSU(materials[i]);
+					if (!materiallist->ContainsKey(mat->Name))
+						materiallist->Add(mat->Name, mat);
+				}
+			}
+
+			return materiallist;
+		}
+
+		/// <summary>
+		/// Links the collected texture images to the textures of the materials using them
+		/// </summary>
+		static void AttachImages(Dictionary<String^, Material^>^ materials, List<TextureImage^>^ images)
+		{
+			for each (TextureImage^ image in images)
+				for each (String^ name in image->Materials)
+				{
+					Material^ material;
+					if (materials->TryGetValue(name, material) && material->MaterialTexture != nullptr)
+						material->MaterialTexture->Image = image;
+				}
+		}
+
 
 	};
 
@@ -40,6 +40,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include "vector.h"
 #include "utilities.h"
 #include "MeshFace.h"
+#include "GeometryStore.h"
 
 
 using namespace System;
@@ -52,95 +53,412 @@ namespace SketchUpNET
 	{
 	public:
 
-		List<Vertex^>^ Vertices;
-		List<Vector^>^ Normals;
-		List<MeshFace^>^ Faces;
+		property List<Vertex^>^ Vertices
+		{
+			List<Vertex^>^ get()
+			{
+				if (vertices == nullptr && store != nullptr)
+					vertices = store->GetMeshVertices(index);
+				if (vertices == nullptr && positions != nullptr)
+				{
+					vertices = gcnew List<Vertex^>(positions->Length / 3);
+					for (int i = 0; i + 2 < positions->Length; i += 3)
+						vertices->Add(gcnew Vertex(positions[i], positions[i + 1], positions[i + 2]));
+					positions = nullptr;
+				}
+				return vertices;
+			}
+			void set(List<Vertex^>^ value) { vertices = value; }
+		}
+
+		property List<Vector^>^ Normals
+		{
+			List<Vector^>^ get()
+			{
+				if (normals == nullptr && store != nullptr)
+					normals = store->GetMeshNormals(index);
+				return normals;
+			}
+			void set(List<Vector^>^ value) { normals = value; }
+		}
+
+		property List<MeshFace^>^ Faces
+		{
+			List<MeshFace^>^ get()
+			{
+				if (faces == nullptr && store != nullptr)
+					faces = store->GetMeshFaces(index);
+				if (faces == nullptr && indices != nullptr)
+				{
+					faces = gcnew List<MeshFace^>(indices->Length / 3);
+					for (int i = 0; i + 2 < indices->Length; i += 3)
+						faces->Add(gcnew MeshFace((int)indices[i], (int)indices[i + 1], (int)indices[i + 2]));
+					indices = nullptr;
+				}
+				return faces;
+			}
+			void set(List<MeshFace^>^ value) { faces = value; }
+		}
 
 		System::String^ Layer;
 
-		Mesh(List<Vertex^>^ vs, List<Vector^>^ ns, List<MeshFace^>^ faces, System::String^ layer)
+		/// <summary>
+		/// Number of mesh vertices
+		/// </summary>
+		property int VertexCount
 		{
-			this->Vertices = vs;
-			this->Normals = ns;
-			this->Faces = faces;
-			this->Layer = layer;
-		};
+			int get()
+			{
+				if (vertices == nullptr && store != nullptr)
+					return (int)store->Buffer->MeshPoints[index].Count;
+				if (vertices == nullptr && positions != nullptr)
+					return positions->Length / 3;
+				return (vertices == nullptr) ? 0 : vertices->Count;
+			}
+		}
 
-		Mesh() {};
-	internal:
+		/// <summary>
+		/// Number of mesh triangles
+		/// </summary>
+		property int TriangleCount
+		{
+			int get()
+			{
+				if (faces == nullptr && store != nullptr)
+					return (int)store->Buffer->MeshTriangles[index].Count;
+				if (faces == nullptr && indices != nullptr)
+					return indices->Length / 3;
+				return (faces == nullptr) ? 0 : faces->Count;
+			}
+		}
 
+		/// <summary>
+		/// Vertex positions as packed xyz triples
+		/// </summary>
+		array<double>^ GetPositions()
+		{
+			array<double>^ result = gcnew array<double>(3 * VertexCount);
+			CopyPositions(result, 0);
+			return result;
+		}
 
+		/// <summary>
+		/// Vertex positions as packed single precision xyz triples
+		/// </summary>
+		array<float>^ GetPositionsSingle()
+		{
+			array<float>^ result = gcnew array<float>(3 * VertexCount);
+			CopyPositions(result, 0);
+			return result;
+		}
+
+		/// <summary>
+		/// Vertex normals as packed xyz triples
+		/// </summary>
+		array<double>^ GetNormals()
+		{
+			array<double>^ result = gcnew array<double>(3 * VertexCount);
+			CopyNormals(result, 0);
+			return result;
+		}
+
+		/// <summary>
+		/// Vertex normals as packed single precision xyz triples
+		/// </summary>
+		array<float>^ GetNormalsSingle()
+		{
+			array<float>^ result = gcnew array<float>(3 * VertexCount);
+			CopyNormals(result, 0);
+			return result;
+		}
+
+		/// <summary>
+		/// Triangle corner indices, three per triangle
+		/// </summary>
+		array<unsigned int>^ GetIndices()
+		{
+			array<unsigned int>^ result = gcnew array<unsigned int>(3 * TriangleCount);
+			CopyIndices(result, 0, 0);
+			return result;
+		}
+
+		/// <summary>
+		/// Front and back texture coordinates were extracted, see LoadOptions.TextureCoordinates
+		/// </summary>
+		property bool HasTextureCoordinates
+		{
+			bool get() { return store != nullptr && store->TextureCoordinates; }
+		}
+
+		/// <summary>
+		/// Front texture coordinates as packed uv pairs, one per vertex, empty if none were extracted
+		/// </summary>
+		array<double>^ GetFrontUVs()
+		{
+			array<double>^ result = gcnew array<double>(HasTextureCoordinates ? 2 * VertexCount : 0);
+			CopyUVs(result, 0, true);
+			return result;
+		}
 
-		static Mesh^ FromSU(SUFaceRef face)
+		/// <summary>
+		/// Back texture coordinates as packed uv pairs, one per vertex, empty if none were extracted
+		/// </summary>
+		array<double>^ GetBackUVs()
 		{
-			List<Vertex^>^ vertices = gcnew List<Vertex^>();
-			List<Vector^>^ vectors = gcnew List<Vector^>();
-			List<MeshFace^>^ faces = gcnew List<MeshFace^>();
-			
-			// Layer
-			SULayerRef layer = SU_INVALID;
-			SUDrawingElementGetLayer(SUFaceToDrawingElement(face), &layer);
+			array<double>^ result = gcnew array<double>(HasTextureCoordinates ? 2 * VertexCount : 0);
+			CopyUVs(result, 0, false);
+			return result;
+		}
 
-			System::String^ layername = gcnew System::String("");
-			if (!SUIsInvalid(layer))
+		/// <summary>
+		/// Copies the front or back texture coordinates as uv pairs into a larger buffer
+		/// </summary>
+		/// <param name="target">Destination with room for 2 * VertexCount values after offset</param>
+		/// <param name="offset">First value to write</param>
+		/// <param name="front">Copy the front instead of the back coordinates</param>
+		void CopyUVs(array<double>^ target, int offset, bool front)
+		{
+			if (HasTextureCoordinates)
+				store->CopyMeshUVs(index, target, offset, front);
+		}
+
+		void CopyUVs(array<float>^ target, int offset, bool front)
+		{
+			if (HasTextureCoordinates)
+				store->CopyMeshUVs(index, target, offset, front);
+		}
+
+		/// <summary>
+		/// Copies the vertex positions as xyz triples into a larger buffer
+		/// </summary>
+		/// <param name="target">Destination with room for 3 * VertexCount values after offset</param>
+		/// <param name="offset">First value to write</param>
+		void CopyPositions(array<double>^ target, int offset)
+		{
+			if (vertices == nullptr && store != nullptr)
 			{
-				layername = Utilities::GetLayerName(layer);
+				store->CopyMeshPoints(index, target, offset);
+				return;
 			}
-			
-			SUMeshHelperRef helper = SU_INVALID;
-			SUMeshHelperCreate(&helper, face);
-
-			size_t vCount = 0;
-			SUMeshHelperGetNumVertices(helper, &vCount);
-			if (vCount > 0)
+			if (vertices == nullptr && positions != nullptr)
 			{
-				std::vector<SUPoint3D> vs(vCount);
-				SUMeshHelperGetVertices(helper,vCount, &vs[0], &vCount);
-
-				for (size_t j = 0; j < vCount; j++)
-				{
-					vertices->Add(Vertex::FromSU(vs[j]));
-				}
+				Array::Copy(positions, 0, target, offset, 3 * VertexCount);
+				return;
+			}
+			for (int i = 0; i < VertexCount; i++)
+			{
+				target[offset + 3 * i] = vertices[i]->X;
+				target[offset + 3 * i + 1] = vertices[i]->Y;
+				target[offset + 3 * i + 2] = vertices[i]->Z;
 			}
+		}
 
+		void CopyPositions(array<float>^ target, int offset)
+		{
+			if (vertices == nullptr && store != nullptr)
+			{
+				store->CopyMeshPoints(index, target, offset);
+				return;
+			}
+			if (vertices == nullptr && positions != nullptr)
+			{
+				for (int i = 0; i < 3 * VertexCount; i++)
+					target[offset + i] = (float)positions[i];
+				return;
+			}
+			for (int i = 0; i < VertexCount; i++)
+			{
+				target[offset + 3 * i] = (float)vertices[i]->X;
+				target[offset + 3 * i + 1] = (float)vertices[i]->Y;
+				target[offset + 3 * i + 2] = (float)vertices[i]->Z;
+			}
+		}
 
+		/// <summary>
+		/// Copies the vertex normals as xyz triples into a larger buffer
+		/// </summary>
+		/// <param name="target">Destination with room for 3 * VertexCount values after offset</param>
+		/// <param name="offset">First value to write</param>
+		void CopyNormals(array<double>^ target, int offset)
+		{
+			if (normals == nullptr && store != nullptr)
+			{
+				store->CopyMeshNormals(index, target, offset);
+				return;
+			}
+			int count = (normals == nullptr) ? 0 : normals->Count;
+			for (int i = 0; i < count; i++)
+			{
+				target[offset + 3 * i] = normals[i]->X;
+				target[offset + 3 * i + 1] = normals[i]->Y;
+				target[offset + 3 * i + 2] = normals[i]->Z;
+			}
+		}
 
-			size_t fCount = 0;
-			size_t ret = 0;
-			SUMeshHelperGetNumTriangles(helper, &fCount);
-			if (fCount > 0)
+		void CopyNormals(array<float>^ target, int offset)
+		{
+			if (normals == nullptr && store != nullptr)
 			{
-				
-				std::vector<size_t> fs(3 * fCount);
-				SUMeshHelperGetVertexIndices(helper, 3*fCount, &fs[0], &ret);
+				store->CopyMeshNormals(index, target, offset);
+				return;
+			}
+			int count = (normals == nullptr) ? 0 : normals->Count;
+			for (int i = 0; i < count; i++)
+			{
+				target[offset + 3 * i] = (float)normals[i]->X;
+				target[offset + 3 * i + 1] = (float)normals[i]->Y;
+				target[offset + 3 * i + 2] = (float)normals[i]->Z;
+			}
+		}
 
-				for (size_t j = 0; j < 3*fCount; j=j+3)
-				{
-					faces->Add(gcnew MeshFace(fs[j], fs[j+1], fs[j + 2]));
-				}
+		/// <summary>
+		/// Copies the triangle corner indices into a larger buffer
+		/// </summary>
+		/// <param name="target">Destination with room for 3 * TriangleCount values after offset</param>
+		/// <param name="offset">First value to write</param>
+		/// <param name="baseVertex">Value added to every index, the position of this mesh's first vertex in a merged buffer</param>
+		void CopyIndices(array<unsigned int>^ target, int offset, unsigned int baseVertex)
+		{
+			if (faces == nullptr && store != nullptr)
+			{
+				store->CopyMeshIndices(index, target, offset, baseVertex);
+				return;
 			}
+			if (faces == nullptr && indices != nullptr)
+			{
+				for (int i = 0; i < 3 * TriangleCount; i++)
+					target[offset + i] = indices[i] + baseVertex;
+				return;
+			}
+			for (int i = 0; i < TriangleCount; i++)
+			{
+				target[offset + 3 * i] = (unsigned int)faces[i]->A + baseVertex;
+				target[offset + 3 * i + 1] = (unsigned int)faces[i]->B + baseVertex;
+				target[offset + 3 * i + 2] = (unsigned int)faces[i]->C + baseVertex;
+			}
+		}
+
+		Mesh(List<Vertex^>^ vs, List<Vector^>^ ns, List<MeshFace^>^ faces, System::String^ layer)
+		{
+			this->Vertices = vs;
+			this->Normals = ns;
+			this->Faces = faces;
+			this->Layer = layer;
+		};
 
+		/// <summary>
+		/// Creates a mesh from packed buffers without creating vertex and face objects
+		/// </summary>
+		/// <param name="positions">Vertex positions as xyz triples in meters</param>
+		/// <param name="indices">Triangle corner indices, three per triangle</param>
+		/// <param name="layer">Layername</param>
+		Mesh(array<double>^ positions, array<unsigned int>^ indices, System::String^ layer)
+		{
+			if (positions == nullptr || positions->Length % 3 != 0)
+				throw gcnew ArgumentException("Positions must be xyz triples.", "positions");
+			if (indices == nullptr || indices->Length % 3 != 0)
+				throw gcnew ArgumentException("Indices must come in triples.", "indices");
+			this->positions = positions;
+			this->indices = indices;
+			this->Layer = layer;
+		};
 
-			size_t nCount = 0;
-			SUMeshHelperGetNumTriangles(helper, &nCount);
-			if (nCount > 0)
+		Mesh() {};
+	internal:
+		/// <summary>
+		/// Copies positions, normals, texture coordinates and indices into native memory.
+		/// Stored meshes are read straight from the store without managed arrays.
+		/// </summary>
+		void CopyPositions(float* target)
+		{
+			if (vertices == nullptr && store != nullptr)
+			{
+				store->CopyMeshPoints(index, target);
+				return;
+			}
+			if (vertices == nullptr && positions != nullptr)
 			{
-				std::vector<SUVector3D> norms(nCount);
-				SUMeshHelperGetNormals(helper, nCount, &norms[0], &nCount);
+				for (int i = 0; i < positions->Length; i++)
+					target[i] = (float)positions[i];
+				return;
+			}
+			for (int i = 0; i < VertexCount; i++)
+			{
+				target[3 * i] = (float)vertices[i]->X;
+				target[3 * i + 1] = (float)vertices[i]->Y;
+				target[3 * i + 2] = (float)vertices[i]->Z;
+			}
+		}
 
-				for (size_t j = 0; j < nCount; j++)
-				{
-					vectors->Add(Vector::FromSU(norms[j]));
-				}
+		void CopyNormals(float* target)
+		{
+			if (normals == nullptr && store != nullptr)
+			{
+				store->CopyMeshNormals(index, target);
+				return;
+			}
+			int count = (normals == nullptr) ? 0 : normals->Count;
+			for (int i = 0; i < count; i++)
+			{
+				target[3 * i] = (float)normals[i]->X;
+				target[3 * i + 1] = (float)normals[i]->Y;
+				target[3 * i + 2] = (float)normals[i]->Z;
 			}
+		}
 
-			SUMeshHelperRelease(&helper);
+		void CopyUVs(float* target, bool front)
+		{
+			if (HasTextureCoordinates)
+				store->CopyMeshUVs(index, target, front);
+		}
 
-			Mesh^ m = gcnew Mesh(vertices,vectors, faces, layername);
+		void CopyIndices(unsigned int* target, unsigned int baseVertex)
+		{
+			if (faces == nullptr && store != nullptr)
+			{
+				store->CopyMeshIndices(index, target, baseVertex);
+				return;
+			}
+			if (faces == nullptr && indices != nullptr)
+			{
+				for (int i = 0; i < indices->Length; i++)
+					target[i] = indices[i] + baseVertex;
+				return;
+			}
+			for (int i = 0; i < TriangleCount; i++)
+			{
+				target[3 * i] = (unsigned int)faces[i]->A + baseVertex;
+				target[3 * i + 1] = (unsigned int)faces[i]->B + baseVertex;
+				target[3 * i + 2] = (unsigned int)faces[i]->C + baseVertex;
+			}
+		}
 
-			return m;
+		/// <summary>
+		/// Index of the stored mesh viewed by this mesh, -1 for meshes created from vertices or arrays
+		/// </summary>
+		property long long StoreIndex
+		{
+			long long get() { return (store == nullptr) ? -1 : (long long)index; }
 		}
 
+		/// <summary>
+		/// Creates a mesh view on a stored mesh
+		/// </summary>
+		Mesh(GeometryStore^ store, size_t index, System::String^ layer)
+		{
+			this->store = store;
+			this->index = index;
+			this->Layer = layer;
+		};
+
+	private:
+		List<Vertex^>^ vertices;
+		List<Vector^>^ normals;
+		List<MeshFace^>^ faces;
+		array<double>^ positions;
+		array<unsigned int>^ indices;
+		GeometryStore^ store;
+		size_t index;
 
 	};
 
@@ -0,0 +1,308 @@
+/*
+
+SketchUpNET - a C++ Wrapper for the Trimble(R) SketchUp(R) C API
+Copyright(C) 2015, Autor: Maximilian Thumfart
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "Utilities.h"
+#include "Surface.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "Group.h"
+#include "Instance.h"
+#include "Component.h"
+#include "InstanceTree.h"
+
+using namespace System;
+using namespace System::Collections;
+using namespace System::Collections::Generic;
+
+namespace SketchUpNET
+{
+	/// <summary>
+	/// Key to merge face meshes by
+	/// </summary>
+	public enum class BatchGrouping
+	{
+		/// <summary>
+		/// One batch per front material in model coordinates, instances and groups are flattened
+		/// </summary>
+		Material,
+
+		/// <summary>
+		/// One batch per layer in model coordinates, instances and groups are flattened
+		/// </summary>
+		Layer,
+
+		/// <summary>
+		/// One batch per model, group and component definition in its own coordinates
+		/// </summary>
+		Definition
+	};
+
+	/// <summary>
+	/// Face meshes merged into one vertex and index buffer.
+	/// Vertices, normals and indices are packed; the triangles of Surfaces[i] start at FaceTriangles[i].
+	/// </summary>
+	public ref class MeshBatch
+	{
+	public:
+		/// <summary>
+		/// Material, layer or definition name the batch was grouped by
+		/// </summary>
+		System::String^ Key;
+
+		/// <summary>
+		/// Definition of the batch when grouped by definition: the Component, the surface list shared by the copies
+		/// of a group or the top level surface list of the model. Names are labels only, batches never merge by name.
+		/// </summary>
+		System::Object^ Definition;
+
+		/// <summary>
+		/// Material of the batch when grouped by material
+		/// </summary>
+		SketchUpNET::Material^ Material;
+
+		/// <summary>
+		/// Vertex positions as xyz triples
+		/// </summary>
+		array<double>^ Positions;
+
+		/// <summary>
+		/// Vertex normals as xyz triples
+		/// </summary>
+		array<double>^ Normals;
+
+		/// <summary>
+		/// Front texture coordinates as uv pairs, null if the model was loaded without texture coordinates
+		/// </summary>
+		array<double>^ UVs;
+
+		/// <summary>
+		/// Triangle corner indices, three per triangle
+		/// </summary>
+		array<unsigned int>^ Indices;
+
+		/// <summary>
+		/// Source surface of each face range
+		/// </summary>
+		List<Surface^>^ Surfaces;
+
+		/// <summary>
+		/// First triangle of each surface, with the total triangle count as last element
+		/// </summary>
+		array<int>^ FaceTriangles;
+
+		/// <summary>
+		/// Surface a triangle of the batch was created from
+		/// </summary>
+		/// <param name="triangle">Triangle index</param>
+		Surface^ SurfaceAt(int triangle)
+		{
+			// First face range ending after the triangle
+			int low = 1;
+			int high = FaceTriangles->Length - 1;
+			while (low < high)
+			{
+				int mid = (low + high) / 2;
+				if (FaceTriangles[mid] > triangle)
+					high = mid;
+				else
+					low = mid + 1;
+			}
+			return Surfaces[low - 1];
+		}
+
+		/// <summary>
+		/// Merges the face meshes of the given surfaces and everything below the groups and instances into batches.
+		/// The model has to be loaded with meshes.
+		/// </summary>
+		/// <param name="surfaces">Top level surfaces</param>
+		/// <param name="groups">Top level groups</param>
+		/// <param name="instances">Top level component instances</param>
+		/// <param name="components">Component definitions, only used for BatchGrouping::Definition</param>
+		/// <param name="groupBy">Batch key</param>
+		/// <param name="singleThreaded">Merge on the calling thread only</param>
+		static List<MeshBatch^>^ Build(List<Surface^>^ surfaces, List<Group^>^ groups, List<Instance^>^ instances, IEnumerable<Component^>^ components, BatchGrouping groupBy, bool singleThreaded)
+		{
+			MeshBatcher^ batcher = gcnew MeshBatcher(groupBy);
+
+			if (groupBy == BatchGrouping::Definition)
+			{
+				batcher->AddDefinition(surfaces, "Model", surfaces, groups);
+				if (components != nullptr)
+					for each (Component^ component in components)
+						batcher->AddDefinition(component, component->Name, component->Surfaces, component->Groups);
+			}
+			else
+			{
+				batcher->AddBody(surfaces, nullptr, nullptr);
+				for each (Placement^ placement in InstanceTree::Build(groups, instances)->Placements)
+					batcher->AddBody(placement->Surfaces, placement->World->Data, placement->Material);
+			}
+
+			return batcher->Merge(singleThreaded);
+		}
+
+	private:
+		int vertexCount;
+		int triangleCount;
+		bool textured;
+		List<int>^ faceTriangles;
+
+		/// <summary>
+		/// Collects the faces of each batch and merges them across the thread pool
+		/// </summary>
+		ref class MeshBatcher
+		{
+		public:
+			MeshBatcher(BatchGrouping groupBy)
+			{
+				this->groupBy = groupBy;
+				batches = gcnew Dictionary<Object^, MeshBatch^>();
+				order = gcnew List<MeshBatch^>();
+				visited = gcnew HashSet<Object^>();
+				meshes = gcnew List<Mesh^>();
+				transforms = gcnew List<array<double>^>();
+				targets = gcnew List<MeshBatch^>();
+				vertexOffsets = gcnew List<int>();
+				indexOffsets = gcnew List<int>();
+			}
+
+			void AddDefinition(Object^ definition, String^ label, List<Surface^>^ surfaces, List<Group^>^ groups)
+			{
+				if (surfaces != nullptr)
+					for each (Surface^ surface in surfaces)
+						AddFace(definition, label, surface, nullptr, nullptr);
+
+				// Group bodies are batched once per definition, their copies share the surface lists
+				if (groups != nullptr)
+					for each (Group^ group in groups)
+						if (group->Surfaces != nullptr && visited->Add(group->Surfaces))
+							AddDefinition(group->Surfaces, group->Name, group->Surfaces, group->Groups);
+			}
+
+			void AddBody(List<Surface^>^ surfaces, array<double>^ transform, SketchUpNET::Material^ inherited)
+			{
+				if (surfaces != nullptr)
+					for each (Surface^ surface in surfaces)
+					{
+						SketchUpNET::Material^ material = surface->FrontMaterial;
+						if (inherited != nullptr && (material == nullptr || String::IsNullOrEmpty(material->Name)))
+							material = inherited;
+						String^ key = (groupBy == BatchGrouping::Layer) ? surface->Layer : ((material == nullptr) ? String::Empty : material->Name);
+						AddFace(key, key, surface, transform, material);
+					}
+			}
+
+			List<MeshBatch^>^ Merge(bool singleThreaded)
+			{
+				for each (MeshBatch^ batch in order)
+				{
+					batch->Positions = gcnew array<double>(3 * batch->vertexCount);
+					batch->Normals = gcnew array<double>(3 * batch->vertexCount);
+					batch->Indices = gcnew array<unsigned int>(3 * batch->triangleCount);
+					if (batch->textured)
+						batch->UVs = gcnew array<double>(2 * batch->vertexCount);
+					batch->FaceTriangles = batch->faceTriangles->ToArray();
+					batch->faceTriangles = nullptr;
+				}
+
+				Utilities::ForRange(0, meshes->Count, 256, gcnew Action<Tuple<int, int>^>(this, &MeshBatcher::Copy), singleThreaded);
+				return order;
+			}
+
+		private:
+			BatchGrouping groupBy;
+			Dictionary<Object^, MeshBatch^>^ batches;
+			List<MeshBatch^>^ order;
+			HashSet<Object^>^ visited;
+
+			// One entry per merged face
+			List<Mesh^>^ meshes;
+			List<array<double>^>^ transforms;
+			List<MeshBatch^>^ targets;
+			List<int>^ vertexOffsets;
+			List<int>^ indexOffsets;
+
+			void AddFace(Object^ identity, String^ key, Surface^ surface, array<double>^ transform, SketchUpNET::Material^ material)
+			{
+				Mesh^ mesh = surface->FaceMesh;
+				if (mesh == nullptr) return;
+				if (key == nullptr) key = String::Empty;
+				if (identity == nullptr) identity = key;
+
+				MeshBatch^ batch;
+				if (!batches->TryGetValue(identity, batch))
+				{
+					batch = gcnew MeshBatch();
+					batch->Key = key;
+					if (groupBy == BatchGrouping::Definition)
+						batch->Definition = identity;
+					if (groupBy == BatchGrouping::Material)
+						batch->Material = material;
+					batch->Surfaces = gcnew List<Surface^>();
+					batch->faceTriangles = gcnew List<int>();
+					batch->faceTriangles->Add(0);
+					batches->Add(identity, batch);
+					order->Add(batch);
+				}
+
+				meshes->Add(mesh);
+				transforms->Add(transform);
+				targets->Add(batch);
+				vertexOffsets->Add(batch->vertexCount);
+				indexOffsets->Add(batch->triangleCount);
+
+				batch->Surfaces->Add(surface);
+				batch->vertexCount += mesh->VertexCount;
+				batch->triangleCount += mesh->TriangleCount;
+				batch->textured |= mesh->HasTextureCoordinates;
+				batch->faceTriangles->Add(batch->triangleCount);
+			}
+
+			void Copy(Tuple<int, int>^ range)
+			{
+				for (int i = range->Item1; i < range->Item2; i++)
+				{
+					Mesh^ mesh = meshes[i];
+					MeshBatch^ batch = targets[i];
+					int vertex = vertexOffsets[i];
+
+					mesh->CopyPositions(batch->Positions, 3 * vertex);
+					mesh->CopyNormals(batch->Normals, 3 * vertex);
+					mesh->CopyIndices(batch->Indices, 3 * indexOffsets[i], (unsigned int)vertex);
+					if (batch->UVs != nullptr)
+						mesh->CopyUVs(batch->UVs, 2 * vertex, true);
+
+					array<double>^ m = transforms[i];
+					if (m == nullptr || mesh->VertexCount == 0) continue;
+
+					pin_ptr<double> pm = &m[0];
+					TransformMatrix matrix(pm);
+					pin_ptr<double> p = &batch->Positions[0];
+					matrix.Points(p + 3 * vertex, mesh->VertexCount);
+					pin_ptr<double> n = &batch->Normals[0];
+					matrix.Normals(n + 3 * vertex, mesh->VertexCount);
+				}
+			}
+		};
+	};
+}
\ No newline at end of file
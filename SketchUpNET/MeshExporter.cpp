@@ -0,0 +1,562 @@
+/*
+
+SketchUpNET - a C++ Wrapper for the Trimble(R) SketchUp(R) C API
+Copyright(C) 2015, Autor: Maximilian Thumfart
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+#pragma once
+
+#include <SketchUpAPI/slapi.h>
+#include <SketchUpAPI/geometry.h>
+#include <SketchUpAPI/transformation.h>
+#include <SketchUpAPI/model/model.h>
+#include <SketchUpAPI/model/entities.h>
+#include <SketchUpAPI/model/face.h>
+#include <SketchUpAPI/model/group.h>
+#include <SketchUpAPI/model/component_definition.h>
+#include <SketchUpAPI/model/component_instance.h>
+#include <SketchUpAPI/model/drawing_element.h>
+#include <SketchUpAPI/model/layer.h>
+#include <SketchUpAPI/model/mesh_helper.h>
+#include <vcclr.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "Utilities.h"
+#include "SketchUpSession.h"
+#include "Transform.h"
+
+using namespace System;
+using namespace System::Collections;
+using namespace System::Collections::Generic;
+
+namespace SketchUpNET
+{
+	/// <summary>
+	/// Triangle mesh file formats written by MeshExporter
+	/// </summary>
+	public enum class MeshFormat
+	{
+		/// <summary>
+		/// Wavefront OBJ text, vertices of each face followed by its triangles
+		/// </summary>
+		Obj,
+
+		/// <summary>
+		/// Binary STL with facet normals
+		/// </summary>
+		Stl,
+
+		/// <summary>
+		/// Binary little endian PLY with float vertices and int triangle indices
+		/// </summary>
+		Ply
+	};
+
+#pragma managed(push, off)
+	/// <summary>
+	/// Buffered writer over a C file. Memory is the fixed buffer, whatever the size of the output.
+	/// </summary>
+	class BufferedFile
+	{
+	public:
+		explicit BufferedFile(FILE* file) : file(file), used(0), failed(false), buffer(1 << 20) {}
+
+		void Write(const void* data, size_t size)
+		{
+			if (used + size > buffer.size())
+				Flush();
+			if (size > buffer.size())
+			{
+				failed |= fwrite(data, 1, size, file) != size;
+				return;
+			}
+			memcpy(&buffer[used], data, size);
+			used += size;
+		}
+
+		void Flush()
+		{
+			if (used > 0)
+				failed |= fwrite(buffer.data(), 1, used, file) != used;
+			used = 0;
+		}
+
+		long long Position()
+		{
+			Flush();
+			return _ftelli64(file);
+		}
+
+		// Overwrites bytes written before, for counts known only at the end
+		void Patch(long long position, const void* data, size_t size)
+		{
+			Flush();
+			failed |= _fseeki64(file, position, SEEK_SET) != 0;
+			failed |= fwrite(data, 1, size, file) != size;
+			failed |= _fseeki64(file, 0, SEEK_END) != 0;
+		}
+
+		bool Failed() const { return failed; }
+
+	private:
+		FILE* file;
+		size_t used;
+		bool failed;
+		std::vector<char> buffer;
+	};
+
+	/// <summary>
+	/// Receives the triangles of one face at a time, points in meters in model coordinates
+	/// </summary>
+	class TriangleSink
+	{
+	public:
+		unsigned long long Vertices = 0;
+		unsigned long long Triangles = 0;
+
+		explicit TriangleSink(BufferedFile* out) : out(out) {}
+		virtual ~TriangleSink() {}
+		// False if the sink cannot write, nothing is walked then
+		virtual bool Begin() = 0;
+		virtual void Face(const SUPoint3D* points, size_t pointCount, const size_t* corners, size_t triangleCount) = 0;
+		virtual bool End() = 0;
+
+	protected:
+		BufferedFile* out;
+	};
+
+	class ObjSink : public TriangleSink
+	{
+	public:
+		explicit ObjSink(BufferedFile* out) : TriangleSink(out) {}
+
+		bool Begin()
+		{
+			Text("# SketchUpNET\n", 14);
+			return true;
+		}
+
+		void Face(const SUPoint3D* points, size_t pointCount, const size_t* corners, size_t triangleCount)
+		{
+			char line[128];
+			for (size_t i = 0; i < pointCount; i++)
+				Text(line, snprintf(line, sizeof(line), "v %.9g %.9g %.9g\n", points[i].x, points[i].y, points[i].z));
+
+			// OBJ indices are one based and count all vertices written before
+			unsigned long long first = Vertices + 1;
+			for (size_t i = 0; i < triangleCount; i++)
+				Text(line, snprintf(line, sizeof(line), "f %llu %llu %llu\n", first + corners[3 * i], first + corners[3 * i + 1], first + corners[3 * i + 2]));
+
+			Vertices += pointCount;
+			Triangles += triangleCount;
+		}
+
+		bool End()
+		{
+			out->Flush();
+			return !out->Failed();
+		}
+
+	private:
+		void Text(const char* text, int length)
+		{
+			if (length > 0)
+				out->Write(text, (size_t)length);
+		}
+	};
+
+	class StlSink : public TriangleSink
+	{
+	public:
+		explicit StlSink(BufferedFile* out) : TriangleSink(out) {}
+
+		bool Begin()
+		{
+			char header[84] = "SketchUpNET binary STL";
+			out->Write(header, sizeof(header));
+			return true;
+		}
+
+		void Face(const SUPoint3D* points, size_t pointCount, const size_t* corners, size_t triangleCount)
+		{
+			char facet[50];
+			memset(facet + 48, 0, 2);
+			for (size_t i = 0; i < triangleCount; i++)
+			{
+				const SUPoint3D& a = points[corners[3 * i]];
+				const SUPoint3D& b = points[corners[3 * i + 1]];
+				const SUPoint3D& c = points[corners[3 * i + 2]];
+				double ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z;
+				double vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z;
+				double nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+				double length = std::sqrt(nx * nx + ny * ny + nz * nz);
+				if (length > 0.0) { nx /= length; ny /= length; nz /= length; }
+
+				float values[12] = { (float)nx, (float)ny, (float)nz,
+					(float)a.x, (float)a.y, (float)a.z, (float)b.x, (float)b.y, (float)b.z, (float)c.x, (float)c.y, (float)c.z };
+				memcpy(facet, values, sizeof(values));
+				out->Write(facet, sizeof(facet));
+			}
+			Vertices += 3 * triangleCount;
+			Triangles += triangleCount;
+		}
+
+		bool End()
+		{
+			if (Triangles > 0xFFFFFFFFull)
+				return false;
+			unsigned int count = (unsigned int)Triangles;
+			out->Patch(80, &count, sizeof(count));
+			out->Flush();
+			return !out->Failed();
+		}
+	};
+
+	/// <summary>
+	/// Binary PLY lists all vertices before all faces, so triangles go to a temporary file
+	/// that is appended once the vertices are complete. The counts in the header are patched at the end.
+	/// </summary>
+	class PlySink : public TriangleSink
+	{
+	public:
+		explicit PlySink(BufferedFile* out) : TriangleSink(out), faceFile(tmpfile()), faces(faceFile) {}
+
+		~PlySink()
+		{
+			if (faceFile != nullptr)
+				fclose(faceFile);
+		}
+
+		bool Begin()
+		{
+			// Faces are spooled to a temporary file, without it there is nowhere to write them
+			if (faceFile == nullptr)
+				return false;
+
+			Text("ply\nformat binary_little_endian 1.0\ncomment SketchUpNET\nelement vertex ");
+			vertexCount = out->Position();
+			Text("0000000000\nproperty float x\nproperty float y\nproperty float z\nelement face ");
+			faceCount = out->Position();
+			Text("0000000000\nproperty list uchar int vertex_indices\nend_header\n");
+			return true;
+		}
+
+		void Face(const SUPoint3D* points, size_t pointCount, const size_t* corners, size_t triangleCount)
+		{
+			if (faceFile == nullptr)
+				return;
+
+			for (size_t i = 0; i < pointCount; i++)
+			{
+				float xyz[3] = { (float)points[i].x, (float)points[i].y, (float)points[i].z };
+				out->Write(xyz, sizeof(xyz));
+			}
+
+			char record[13];
+			record[0] = 3;
+			for (size_t i = 0; i < triangleCount; i++)
+			{
+				int abc[3] = { (int)(Vertices + corners[3 * i]), (int)(Vertices + corners[3 * i + 1]), (int)(Vertices + corners[3 * i + 2]) };
+				memcpy(record + 1, abc, sizeof(abc));
+				faces.Write(record, sizeof(record));
+			}
+
+			Vertices += pointCount;
+			Triangles += triangleCount;
+		}
+
+		bool End()
+		{
+			if (faceFile == nullptr || Vertices > 0x7FFFFFFFull || Triangles > 9999999999ull)
+				return false;
+
+			faces.Flush();
+			rewind(faceFile);
+			std::vector<char> chunk(1 << 20);
+			size_t read;
+			while ((read = fread(chunk.data(), 1, chunk.size(), faceFile)) > 0)
+				out->Write(chunk.data(), read);
+
+			char digits[16];
+			snprintf(digits, sizeof(digits), "%010llu", Vertices);
+			out->Patch(vertexCount, digits, 10);
+			snprintf(digits, sizeof(digits), "%010llu", Triangles);
+			out->Patch(faceCount, digits, 10);
+			out->Flush();
+			return !out->Failed() && !faces.Failed();
+		}
+
+	private:
+		FILE* faceFile;
+		BufferedFile faces;
+		long long vertexCount;
+		long long faceCount;
+
+		void Text(const char* text)
+		{
+			out->Write(text, strlen(text));
+		}
+	};
+
+	/// <summary>
+	/// Walks the entities of a model depth first and passes the triangulated faces to a sink in model coordinates.
+	/// Definitions are walked again for every instance, nothing is cached, so memory stays at one face and one entity list per level.
+	/// </summary>
+	class EntityWalker
+	{
+	public:
+		EntityWalker(TriangleSink* sink, bool includeHidden) : sink(sink), includeHidden(includeHidden) {}
+
+		void Walk(SUEntitiesRef entities, const double* world)
+		{
+			size_t count = 0;
+			SUEntitiesGetNumFaces(entities, &count);
+			if (count > 0)
+			{
+				std::vector<SUFaceRef> faces(count);
+				SUEntitiesGetFaces(entities, count, &faces[0], &count);
+				TransformMatrix matrix(world);
+				for (size_t i = 0; i < count; i++)
+					if (Accepts(SUFaceToDrawingElement(faces[i])))
+						Face(faces[i], matrix);
+			}
+
+			count = 0;
+			SUEntitiesGetNumGroups(entities, &count);
+			if (count > 0)
+			{
+				std::vector<SUGroupRef> groups(count);
+				SUEntitiesGetGroups(entities, count, &groups[0], &count);
+				for (size_t i = 0; i < count; i++)
+				{
+					if (!Accepts(SUGroupToDrawingElement(groups[i])))
+						continue;
+					SUTransformation local;
+					SUGroupGetTransform(groups[i], &local);
+					SUEntitiesRef children = SU_INVALID;
+					SUGroupGetEntities(groups[i], &children);
+					double composed[16];
+					ComposeTransforms(world, local.values, composed);
+					Walk(children, composed);
+				}
+			}
+
+			count = 0;
+			SUEntitiesGetNumInstances(entities, &count);
+			if (count > 0)
+			{
+				std::vector<SUComponentInstanceRef> instances(count);
+				SUEntitiesGetInstances(entities, count, &instances[0], &count);
+				for (size_t i = 0; i < count; i++)
+				{
+					if (!Accepts(SUComponentInstanceToDrawingElement(instances[i])))
+						continue;
+					SUTransformation local;
+					SUComponentInstanceGetTransform(instances[i], &local);
+					SUComponentDefinitionRef definition = SU_INVALID;
+					SUComponentInstanceGetDefinition(instances[i], &definition);
+					SUEntitiesRef children = SU_INVALID;
+					SUComponentDefinitionGetEntities(definition, &children);
+					double composed[16];
+					ComposeTransforms(world, local.values, composed);
+					Walk(children, composed);
+				}
+			}
+		}
+
+	private:
+		TriangleSink* sink;
+		bool includeHidden;
+
+		// Reused for every face
+		std::vector<SUPoint3D> points;
+		std::vector<size_t> corners;
+
+		bool Accepts(SUDrawingElementRef element)
+		{
+			if (includeHidden)
+				return true;
+
+			bool hidden = false;
+			SUDrawingElementGetHidden(element, &hidden);
+			if (hidden)
+				return false;
+
+			SULayerRef layer = SU_INVALID;
+			bool visible = true;
+			if (SUDrawingElementGetLayer(element, &layer) == SU_ERROR_NONE && !SUIsInvalid(layer))
+				SULayerGetVisibility(layer, &visible);
+			return visible;
+		}
+
+		void Face(SUFaceRef face, const TransformMatrix& matrix)
+		{
+			SUMeshHelperRef helper = SU_INVALID;
+			if (SUMeshHelperCreate(&helper, face) != SU_ERROR_NONE)
+				return;
+
+			size_t vertexCount = 0, triangleCount = 0;
+			SUMeshHelperGetNumVertices(helper, &vertexCount);
+			SUMeshHelperGetNumTriangles(helper, &triangleCount);
+			if (vertexCount > 0 && triangleCount > 0)
+			{
+				points.resize(vertexCount);
+				corners.resize(3 * triangleCount);
+				SUMeshHelperGetVertices(helper, vertexCount, &points[0], &vertexCount);
+				size_t cornerCount = 0;
+				SUMeshHelperGetVertexIndices(helper, 3 * triangleCount, &corners[0], &cornerCount);
+
+				// Model coordinates in meters, SUPoint3D is a packed xyz triple
+				matrix.Points(&points[0].x, vertexCount);
+				for (size_t i = 0; i < vertexCount; i++)
+				{
+					points[i].x *= 0.0254;
+					points[i].y *= 0.0254;
+					points[i].z *= 0.0254;
+				}
+
+				// Mirroring transforms flip the winding, swap two corners to keep the faces pointing outwards
+				triangleCount = cornerCount / 3;
+				if (matrix.Mirrored)
+					for (size_t i = 0; i < triangleCount; i++)
+						std::swap(corners[3 * i + 1], corners[3 * i + 2]);
+
+				sink->Face(&points[0], vertexCount, &corners[0], triangleCount);
+			}
+			SUMeshHelperRelease(&helper);
+		}
+	};
+
+	inline bool StreamTriangles(SUModelRef model, FILE* file, int format, bool includeHidden, unsigned long long* vertices, unsigned long long* triangles)
+	{
+		BufferedFile out(file);
+		std::unique_ptr<TriangleSink> sink;
+		if (format == 1)
+			sink.reset(new StlSink(&out));
+		else if (format == 2)
+			sink.reset(new PlySink(&out));
+		else
+			sink.reset(new ObjSink(&out));
+
+		SUEntitiesRef entities = SU_INVALID;
+		SUModelGetEntities(model, &entities);
+
+		const double identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+		if (!sink->Begin())
+			return false;
+		EntityWalker walker(sink.get(), includeHidden);
+		walker.Walk(entities, identity);
+		bool result = sink->End();
+
+		*vertices = sink->Vertices;
+		*triangles = sink->Triangles;
+		return result;
+	}
+#pragma managed(pop)
+
+	/// <summary>
+	/// Streams the triangulated faces of a .skp file into an OBJ, STL or PLY file without loading the model into managed objects.
+	/// Groups and component instances are walked with their world transforms applied, triangles are written
+	/// through a fixed size buffer as they are produced, so memory does not grow with the size of the model.
+	/// Coordinates are written in meters.
+	/// </summary>
+	public ref class MeshExporter
+	{
+	public:
+		/// <summary>
+		/// Export hidden entities and entities on hidden layers
+		/// </summary>
+		bool IncludeHidden;
+
+		/// <summary>
+		/// Vertices written by the last export, three per triangle for STL
+		/// </summary>
+		long long VertexCount;
+
+		/// <summary>
+		/// Triangles written by the last export
+		/// </summary>
+		long long TriangleCount;
+
+		MeshExporter()
+		{
+			this->IncludeHidden = true;
+		};
+
+		/// <summary>
+		/// Streams all faces of a .skp file into a mesh file
+		/// </summary>
+		/// <param name="filename">Path to .skp file</param>
+		/// <param name="target">Path to the mesh file to write</param>
+		/// <param name="format">Mesh file format</param>
+		/// <returns>False if the model could not be read or the mesh file not be written</returns>
+		bool Export(System::String^ filename, System::String^ target, MeshFormat format)
+		{
+			VertexCount = 0;
+			TriangleCount = 0;
+			Utilities::Utf8String path(filename);
+
+			SketchUpSession::Enter();
+			SUModelRef model = SU_INVALID;
+			SUModelLoadStatus status;
+			if (SUModelCreateFromFileWithStatus(&model, path, &status) != SU_ERROR_NONE)
+			{
+				SketchUpSession::Leave();
+				return false;
+			}
+
+			// Written next to the target and moved over it once complete, a failed export leaves no partial file
+			String^ temporary = target + "." + Guid::NewGuid().ToString("N") + ".tmp";
+			bool result = false;
+			FILE* file = nullptr;
+			try
+			{
+				pin_ptr<const wchar_t> output = PtrToStringChars(temporary);
+				if (_wfopen_s(&file, output, L"wb") != 0 || file == nullptr)
+					return false;
+
+				unsigned long long vertices = 0, triangles = 0;
+				result = StreamTriangles(model, file, (int)format, IncludeHidden, &vertices, &triangles);
+				VertexCount = (long long)vertices;
+				TriangleCount = (long long)triangles;
+
+				result = fclose(file) == 0 && result;
+				file = nullptr;
+				if (result)
+				{
+					if (IO::File::Exists(target))
+						IO::File::Delete(target);
+					IO::File::Move(temporary, target);
+				}
+			}
+			finally
+			{
+				if (file != nullptr)
+					fclose(file);
+				if (IO::File::Exists(temporary))
+					IO::File::Delete(temporary);
+				SUModelRelease(&model);
+				SketchUpSession::Leave();
+			}
+			return result;
+		}
+	};
+}
\ No newline at end of file
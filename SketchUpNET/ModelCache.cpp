@@ -0,0 +1,1223 @@
+/*
+
+SketchUpNET - a C++ Wrapper for the Trimble(R) SketchUp(R) C API
+Copyright(C) 2015, Autor: Maximilian Thumfart
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+#pragma once
+
+#include <vcclr.h>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "Utilities.h"
+#include "GeometryStore.h"
+#include "LoadOptions.h"
+#include "Vertex.h"
+#include "Vector.h"
+#include "Transform.h"
+#include "BoundingBox.h"
+#include "Color.h"
+#include "Texture.h"
+#include "Material.h"
+#include "Layer.h"
+#include "Mesh.h"
+#include "Edge.h"
+#include "Curve.h"
+#include "Surface.h"
+#include "Instance.h"
+#include "Group.h"
+#include "Component.h"
+#include "MeshExporter.h"
+
+using namespace System;
+using namespace System::Collections;
+using namespace System::Collections::Generic;
+
+namespace SketchUpNET
+{
+#pragma managed(push, off)
+	/// <summary>
+	/// Start of a .skpc file. The payload is only used when magic, version, pointer size,
+	/// load flags and source key match and both hashes verify.
+	/// </summary>
+	struct CacheHeader
+	{
+		char Magic[4];
+		unsigned int Version;
+		unsigned int Flags;
+		unsigned int PointerSize;
+		long long SourceSize;
+		long long SourceTime;
+		unsigned long long PayloadSize;
+		unsigned long long PayloadHash;
+		unsigned long long HeaderHash;
+		unsigned long long Reserved;
+	};
+
+	enum CacheFlags : unsigned int
+	{
+		CacheMeshes = 1,
+		CacheSharedTopology = 2,
+		CacheTextureCoordinates = 4
+	};
+
+	/// <summary>
+	/// 64 bit hash over four interleaved lanes of 8 byte words, fed in pieces of any size
+	/// </summary>
+	class CacheHasher
+	{
+	public:
+		CacheHasher() : pending(0), total(0)
+		{
+			lanes[0] = Prime1 + Prime2;
+			lanes[1] = Prime2;
+			lanes[2] = 0;
+			lanes[3] = 0 - Prime1;
+		}
+
+		void Update(const void* data, size_t size)
+		{
+			const unsigned char* p = (const unsigned char*)data;
+			total += size;
+			if (pending > 0)
+			{
+				size_t take = (size < 32 - pending) ? size : 32 - pending;
+				memcpy(block + pending, p, take);
+				pending += take;
+				p += take;
+				size -= take;
+				if (pending < 32)
+					return;
+				Round(block);
+				pending = 0;
+			}
+			for (; size >= 32; p += 32, size -= 32)
+				Round(p);
+			memcpy(block, p, size);
+			pending = size;
+		}
+
+		unsigned long long Final() const
+		{
+			unsigned long long h = Rotate(lanes[0], 1) + Rotate(lanes[1], 7) + Rotate(lanes[2], 12) + Rotate(lanes[3], 18) + total;
+			for (size_t i = 0; i < pending; i++)
+				h = Rotate(h ^ (block[i] * Prime5), 11) * Prime1;
+			h ^= h >> 33;
+			h *= Prime2;
+			h ^= h >> 29;
+			h *= Prime3;
+			h ^= h >> 32;
+			return h;
+		}
+
+		static unsigned long long Of(const void* data, size_t size)
+		{
+			CacheHasher hasher;
+			hasher.Update(data, size);
+			return hasher.Final();
+		}
+
+	private:
+		static const unsigned long long Prime1 = 11400714785074694791ULL;
+		static const unsigned long long Prime2 = 14029467366897019727ULL;
+		static const unsigned long long Prime3 = 1609587929392839161ULL;
+		static const unsigned long long Prime5 = 2870177450012600261ULL;
+
+		unsigned long long lanes[4];
+		unsigned char block[32];
+		size_t pending;
+		unsigned long long total;
+
+		static unsigned long long Rotate(unsigned long long value, int bits)
+		{
+			return (value << bits) | (value >> (64 - bits));
+		}
+
+		void Round(const unsigned char* p)
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				unsigned long long word;
+				memcpy(&word, p + 8 * i, 8);
+				lanes[i] = Rotate(lanes[i] + word * Prime2, 31) * Prime1;
+			}
+		}
+	};
+
+	/// <summary>
+	/// Writes the payload of a cache file behind a header placeholder, hashing everything it writes.
+	/// Every block is padded to 8 bytes so that the mapped blocks are aligned when read back.
+	/// </summary>
+	class CacheWriter
+	{
+	public:
+		explicit CacheWriter(FILE* file) : out(file), size(0)
+		{
+			CacheHeader placeholder = {};
+			out.Write(&placeholder, sizeof(placeholder));
+		}
+
+		void Put(const void* data, size_t bytes)
+		{
+			out.Write(data, bytes);
+			hasher.Update(data, bytes);
+			size += bytes;
+		}
+
+		void Count(unsigned long long count)
+		{
+			Put(&count, sizeof(count));
+		}
+
+		void Align()
+		{
+			static const unsigned char zeros[8] = {};
+			size_t padding = (size_t)((8 - size % 8) % 8);
+			if (padding > 0)
+				Put(zeros, padding);
+		}
+
+		template <typename T>
+		void Block(const std::vector<T>& values)
+		{
+			Count(values.size());
+			if (!values.empty())
+				Put(values.data(), values.size() * sizeof(T));
+			Align();
+		}
+
+		bool Finish(CacheHeader& header)
+		{
+			header.PayloadSize = size;
+			header.PayloadHash = hasher.Final();
+			header.HeaderHash = CacheHasher::Of(&header, offsetof(CacheHeader, HeaderHash));
+			out.Patch(0, &header, sizeof(header));
+			out.Flush();
+			return !out.Failed();
+		}
+
+	private:
+		BufferedFile out;
+		CacheHasher hasher;
+		unsigned long long size;
+	};
+
+	/// <summary>
+	/// Reads the blocks of a verified payload, failing instead of reading past its end
+	/// </summary>
+	class CacheReader
+	{
+	public:
+		CacheReader(const unsigned char* data, size_t size) : data(data), size(size), position(0) {}
+
+		bool Take(size_t bytes, const unsigned char*& p)
+		{
+			size_t padded = (bytes + 7) & ~(size_t)7;
+			if (padded < bytes || padded > size - position)
+				return false;
+			p = data + position;
+			position += padded;
+			return true;
+		}
+
+		bool Count(unsigned long long& count)
+		{
+			const unsigned char* p = nullptr;
+			if (!Take(sizeof(count), p))
+				return false;
+			memcpy(&count, p, sizeof(count));
+			return true;
+		}
+
+		bool Section(const unsigned char*& p, size_t& bytes)
+		{
+			unsigned long long count = 0;
+			if (!Count(count) || count > size - position)
+				return false;
+			bytes = (size_t)count;
+			return Take(bytes, p);
+		}
+
+		template <typename T>
+		bool Block(std::vector<T>& values)
+		{
+			unsigned long long count = 0;
+			const unsigned char* p = nullptr;
+			if (!Count(count) || count > (size - position) / sizeof(T) || !Take((size_t)count * sizeof(T), p))
+				return false;
+			values.assign((const T*)p, (const T*)p + count);
+			return true;
+		}
+
+		bool AtEnd() const { return position == size; }
+
+	private:
+		const unsigned char* data;
+		size_t size;
+		size_t position;
+	};
+
+	/// <summary>
+	/// All committed blocks of a geometry buffer in a fixed order. The extraction maps and the
+	/// pending texture q values are not written, they are empty once a load is converted.
+	/// </summary>
+	inline void WriteGeometry(CacheWriter& writer, const GeometryBuffer& b)
+	{
+		writer.Block(b.X);
+		writer.Block(b.Y);
+		writer.Block(b.Z);
+		writer.Block(b.EdgePoints);
+		writer.Block(b.EdgeLayers);
+		writer.Block(b.LoopEdges);
+		writer.Block(b.Loops);
+		writer.Block(b.FaceLoops);
+		writer.Block(b.FacePoints);
+		writer.Block(b.FaceVertices);
+		writer.Block(b.FaceBounds);
+		writer.Block(b.MeshX);
+		writer.Block(b.MeshY);
+		writer.Block(b.MeshZ);
+		writer.Block(b.NormalX);
+		writer.Block(b.NormalY);
+		writer.Block(b.NormalZ);
+		writer.Block(b.MeshIndices);
+		writer.Block(b.MeshPoints);
+		writer.Block(b.MeshNormals);
+		writer.Block(b.MeshTriangles);
+		writer.Block(b.FrontU);
+		writer.Block(b.FrontV);
+		writer.Block(b.BackU);
+		writer.Block(b.BackV);
+		writer.Block(b.HalfEdges);
+		writer.Block(b.EdgeHalfEdge);
+		writer.Block(b.PointHalfEdge);
+	}
+
+	inline bool ReadGeometry(CacheReader& reader, GeometryBuffer& b)
+	{
+		return reader.Block(b.X) && reader.Block(b.Y) && reader.Block(b.Z)
+			&& reader.Block(b.EdgePoints) && reader.Block(b.EdgeLayers)
+			&& reader.Block(b.LoopEdges) && reader.Block(b.Loops)
+			&& reader.Block(b.FaceLoops) && reader.Block(b.FacePoints) && reader.Block(b.FaceVertices) && reader.Block(b.FaceBounds)
+			&& reader.Block(b.MeshX) && reader.Block(b.MeshY) && reader.Block(b.MeshZ)
+			&& reader.Block(b.NormalX) && reader.Block(b.NormalY) && reader.Block(b.NormalZ)
+			&& reader.Block(b.MeshIndices) && reader.Block(b.MeshPoints) && reader.Block(b.MeshNormals) && reader.Block(b.MeshTriangles)
+			&& reader.Block(b.FrontU) && reader.Block(b.FrontV) && reader.Block(b.BackU) && reader.Block(b.BackV)
+			&& reader.Block(b.HalfEdges) && reader.Block(b.EdgeHalfEdge) && reader.Block(b.PointHalfEdge);
+	}
+#pragma managed(pop)
+
+	/// <summary>
+	/// Converted contents of a model, as held by SketchUp after a load
+	/// </summary>
+	ref class CachedModel
+	{
+	public:
+		List<Surface^>^ Surfaces;
+		List<Layer^>^ Layers;
+		List<Group^>^ Groups;
+		Dictionary<String^, Component^>^ Components;
+		Dictionary<String^, Material^>^ Materials;
+		List<Instance^>^ Instances;
+		List<Curve^>^ Curves;
+		List<Edge^>^ Edges;
+		GeometryStore^ Geometry;
+		String^ ModelGuid;
+		bool MoreRecentFileVersion;
+	};
+
+	/// <summary>
+	/// Entities of the model, a definition or a group, shared by all copies of a group
+	/// </summary>
+	ref class CacheBody
+	{
+	public:
+		List<Surface^>^ Surfaces;
+		List<Edge^>^ Edges;
+		List<Curve^>^ Curves;
+		List<Instance^>^ Instances;
+		List<Group^>^ Groups;
+
+		CacheBody()
+		{
+			this->Surfaces = gcnew List<Surface^>();
+			this->Edges = gcnew List<Edge^>();
+			this->Curves = gcnew List<Curve^>();
+			this->Instances = gcnew List<Instance^>();
+			this->Groups = gcnew List<Group^>();
+		};
+	};
+
+	/// <summary>
+	/// Writes the tables of a model. Strings, materials and definitions are written once and referenced by index,
+	/// surfaces, edges and meshes by their index in the geometry store.
+	/// </summary>
+	ref class CacheEncoder
+	{
+	public:
+		IO::MemoryStream^ Strings;
+		IO::MemoryStream^ Tables;
+
+		CacheEncoder()
+		{
+			strings = gcnew List<String^>();
+			stringIds = gcnew Dictionary<String^, int>();
+			materials = gcnew List<Material^>();
+			materialIds = gcnew Dictionary<Material^, int>();
+			components = gcnew List<Component^>();
+			componentIds = gcnew Dictionary<Component^, int>();
+			bodyIds = gcnew Dictionary<Object^, int>();
+		}
+
+		void Encode(CachedModel^ model, String^ source)
+		{
+			// Dictionary entries first so that their keys survive, materials and definitions
+			// only reachable through entities follow
+			List<String^>^ materialKeys = gcnew List<String^>();
+			if (model->Materials != nullptr)
+				for each (KeyValuePair<String^, Material^> entry in model->Materials)
+				{
+					materialKeys->Add(entry.Key);
+					materialIds->Add(entry.Value, materials->Count);
+					materials->Add(entry.Value);
+				}
+			List<String^>^ componentKeys = gcnew List<String^>();
+			if (model->Components != nullptr)
+				for each (KeyValuePair<String^, Component^> entry in model->Components)
+				{
+					componentKeys->Add(entry.Key);
+					componentIds->Add(entry.Value, components->Count);
+					components->Add(entry.Value);
+				}
+
+			IO::MemoryStream^ bodies = gcnew IO::MemoryStream();
+			writer = gcnew IO::BinaryWriter(bodies);
+			WriteBody(model->Surfaces, model->Edges, model->Curves, model->Instances, model->Groups);
+			for (int i = 0; i < components->Count; i++)
+			{
+				Component^ c = components[i];
+				WriteBody(c->Surfaces, c->Edges, c->Curves, c->Instances, c->Groups);
+			}
+			writer->Flush();
+
+			Tables = gcnew IO::MemoryStream();
+			writer = gcnew IO::BinaryWriter(Tables);
+			writer->Write(Str(source));
+			writer->Write(Str(model->ModelGuid));
+			writer->Write(model->MoreRecentFileVersion);
+
+			writer->Write(Count(model->Layers));
+			if (model->Layers != nullptr)
+				for each (Layer^ layer in model->Layers)
+					writer->Write(Str(layer->Name));
+
+			List<String^>^ layerNames = model->Geometry->LayerNames;
+			writer->Write(layerNames->Count);
+			for each (String^ name in layerNames)
+				writer->Write(Str(name));
+
+			writer->Write(materials->Count);
+			writer->Write(materialKeys->Count);
+			for (int i = 0; i < materials->Count; i++)
+			{
+				if (i < materialKeys->Count)
+					writer->Write(Str(materialKeys[i]));
+				WriteMaterial(materials[i]);
+			}
+
+			writer->Write(components->Count);
+			writer->Write(componentKeys->Count);
+			for (int i = 0; i < components->Count; i++)
+			{
+				if (i < componentKeys->Count)
+					writer->Write(Str(componentKeys[i]));
+				Component^ c = components[i];
+				writer->Write(Str(c->Name));
+				writer->Write(Str(c->Description));
+				writer->Write(Str(c->Guid));
+				WriteBounds(c->Bounds);
+			}
+			writer->Flush();
+			bodies->WriteTo(Tables);
+
+			Strings = gcnew IO::MemoryStream();
+			IO::BinaryWriter^ pool = gcnew IO::BinaryWriter(Strings);
+			pool->Write(strings->Count);
+			for each (String^ s in strings)
+				pool->Write(s);
+			pool->Flush();
+		}
+
+	private:
+		IO::BinaryWriter^ writer;
+		List<String^>^ strings;
+		Dictionary<String^, int>^ stringIds;
+		List<Material^>^ materials;
+		Dictionary<Material^, int>^ materialIds;
+		List<Component^>^ components;
+		Dictionary<Component^, int>^ componentIds;
+		Dictionary<Object^, int>^ bodyIds;
+		int bodyCount;
+
+		static int Count(ICollection^ items)
+		{
+			return (items == nullptr) ? 0 : items->Count;
+		}
+
+		int Str(String^ s)
+		{
+			if (s == nullptr)
+				return -1;
+			int id;
+			if (!stringIds->TryGetValue(s, id))
+			{
+				id = strings->Count;
+				strings->Add(s);
+				stringIds->Add(s, id);
+			}
+			return id;
+		}
+
+		int MaterialId(Material^ material)
+		{
+			if (material == nullptr)
+				return -1;
+			int id;
+			if (!materialIds->TryGetValue(material, id))
+			{
+				id = materials->Count;
+				materials->Add(material);
+				materialIds->Add(material, id);
+			}
+			return id;
+		}
+
+		int ComponentId(Component^ component)
+		{
+			int id;
+			if (!componentIds->TryGetValue(component, id))
+			{
+				id = components->Count;
+				components->Add(component);
+				componentIds->Add(component, id);
+			}
+			return id;
+		}
+
+		static long long StoreIndex(long long index)
+		{
+			if (index < 0)
+				throw gcnew NotSupportedException("Only geometry of a loaded model can be cached.");
+			return index;
+		}
+
+		void WriteColor(Color^ color)
+		{
+			writer->Write(color != nullptr);
+			if (color != nullptr)
+				writer->Write((int)((unsigned)color->A << 24 | (unsigned)color->R << 16 | (unsigned)color->G << 8 | (unsigned)color->B));
+		}
+
+		void WriteMaterial(Material^ material)
+		{
+			writer->Write(Str(material->Name));
+			WriteColor(material->Colour);
+			writer->Write(material->Opacity);
+			writer->Write(material->UseOpacity);
+			writer->Write(material->UsesColor);
+			writer->Write(material->UsesTexture);
+
+			Texture^ texture = material->MaterialTexture;
+			writer->Write(texture != nullptr);
+			if (texture == nullptr)
+				return;
+			writer->Write(Str(texture->Name));
+			WriteColor(texture->Colour);
+			writer->Write(texture->Opacity);
+			writer->Write(texture->useAlpha);
+			writer->Write(texture->Height);
+			writer->Write(texture->Width);
+			writer->Write(texture->ScaleH);
+			writer->Write(texture->ScaleW);
+		}
+
+		void WriteVector(Vector^ vector)
+		{
+			writer->Write(vector != nullptr);
+			if (vector == nullptr)
+				return;
+			writer->Write(vector->X);
+			writer->Write(vector->Y);
+			writer->Write(vector->Z);
+		}
+
+		void WriteTransform(Transform^ transform)
+		{
+			writer->Write(transform != nullptr && transform->Data != nullptr);
+			if (transform == nullptr || transform->Data == nullptr)
+				return;
+			for (int i = 0; i < 16; i++)
+				writer->Write(transform->Data[i]);
+		}
+
+		void WriteBounds(BoundingBox^ bounds)
+		{
+			writer->Write(bounds != nullptr);
+			if (bounds == nullptr)
+				return;
+			writer->Write(bounds->Min->X);
+			writer->Write(bounds->Min->Y);
+			writer->Write(bounds->Min->Z);
+			writer->Write(bounds->Max->X);
+			writer->Write(bounds->Max->Y);
+			writer->Write(bounds->Max->Z);
+		}
+
+		void WriteBody(List<Surface^>^ surfaces, List<Edge^>^ edges, List<Curve^>^ curves, List<Instance^>^ instances, List<Group^>^ groups)
+		{
+			writer->Write(Count(surfaces));
+			if (surfaces != nullptr)
+				for each (Surface^ surface in surfaces)
+				{
+					writer->Write(StoreIndex(surface->StoreIndex));
+					WriteVector(surface->Normal);
+					writer->Write(surface->Area);
+					writer->Write((surface->FaceMesh == nullptr) ? -1LL : StoreIndex(surface->FaceMesh->StoreIndex));
+					writer->Write(Str(surface->Layer));
+					writer->Write(MaterialId(surface->FrontMaterial));
+					writer->Write(MaterialId(surface->BackMaterial));
+				}
+
+			writer->Write(Count(edges));
+			if (edges != nullptr)
+				for each (Edge^ edge in edges)
+					writer->Write(StoreIndex(edge->StoreIndex));
+
+			writer->Write(Count(curves));
+			if (curves != nullptr)
+				for each (Curve^ curve in curves)
+				{
+					writer->Write(curve->isArc);
+					writer->Write(Count(curve->Edges));
+					if (curve->Edges != nullptr)
+						for each (Edge^ edge in curve->Edges)
+							writer->Write(StoreIndex(edge->StoreIndex));
+				}
+
+			writer->Write(Count(instances));
+			if (instances != nullptr)
+				for each (Instance^ instance in instances)
+				{
+					writer->Write(Str(instance->Name));
+					writer->Write(Str(instance->Guid));
+					writer->Write(Str(instance->ParentID));
+					writer->Write(Str(instance->Layer));
+					writer->Write(MaterialId(instance->Material));
+					WriteTransform(instance->Transformation);
+					WriteBounds(instance->Bounds);
+					Component^ parent = dynamic_cast<Component^>(instance->Parent);
+					writer->Write((parent == nullptr) ? -1 : ComponentId(parent));
+				}
+
+			writer->Write(Count(groups));
+			if (groups != nullptr)
+				for each (Group^ group in groups)
+				{
+					writer->Write(Str(group->Name));
+					writer->Write(Str(group->Guid));
+					writer->Write(Str(group->Layer));
+					writer->Write(MaterialId(group->Material));
+					WriteTransform(group->Transformation);
+					WriteBounds(group->Bounds);
+
+					// Copies of a group share their entity lists, the body is written with the first copy
+					int id;
+					if (group->Surfaces != nullptr && bodyIds->TryGetValue(group->Surfaces, id))
+					{
+						writer->Write(id);
+						continue;
+					}
+					id = bodyCount++;
+					if (group->Surfaces != nullptr)
+						bodyIds->Add(group->Surfaces, id);
+					writer->Write(id);
+					WriteBody(group->Surfaces, group->Edges, group->Curves, group->Instances, group->Groups);
+				}
+		}
+	};
+
+	/// <summary>
+	/// Reads the tables written by CacheEncoder into views on a restored geometry store
+	/// </summary>
+	ref class CacheDecoder
+	{
+	public:
+		CacheDecoder(GeometryStore^ store, IO::BinaryReader^ pool)
+		{
+			this->store = store;
+			int count = pool->ReadInt32();
+			if (count < 0 || count > pool->BaseStream->Length)
+				throw gcnew IO::InvalidDataException();
+			strings = gcnew List<String^>(count);
+			for (int i = 0; i < count; i++)
+				strings->Add(pool->ReadString());
+			bodies = gcnew List<CacheBody^>();
+		}
+
+		/// <summary>
+		/// Model read from the tables, null if they belong to another source file
+		/// </summary>
+		CachedModel^ Decode(IO::BinaryReader^ tables, String^ source)
+		{
+			reader = tables;
+			if (!String::Equals(Str(), source, StringComparison::OrdinalIgnoreCase))
+				return nullptr;
+
+			CachedModel^ model = gcnew CachedModel();
+			model->Geometry = store;
+			model->ModelGuid = Str();
+			model->MoreRecentFileVersion = reader->ReadBoolean();
+
+			int count = Count();
+			model->Layers = gcnew List<Layer^>(count);
+			for (int i = 0; i < count; i++)
+				model->Layers->Add(gcnew Layer(Str()));
+
+			count = Count();
+			for (int i = 0; i < count; i++)
+				store->LayerNames->Add(Str());
+
+			count = Count();
+			int keyed = Count();
+			materials = gcnew List<Material^>(count);
+			model->Materials = gcnew Dictionary<String^, Material^>();
+			for (int i = 0; i < count; i++)
+			{
+				String^ key = (i < keyed) ? Str() : nullptr;
+				Material^ material = ReadMaterial();
+				materials->Add(material);
+				if (key != nullptr)
+					model->Materials->Add(key, material);
+			}
+
+			count = Count();
+			keyed = Count();
+			components = gcnew List<Component^>(count);
+			model->Components = gcnew Dictionary<String^, Component^>();
+			for (int i = 0; i < count; i++)
+			{
+				String^ key = (i < keyed) ? Str() : nullptr;
+				String^ name = Str();
+				String^ description = Str();
+				Component^ component = gcnew Component(name, Str(), nullptr, nullptr, nullptr, nullptr, description, nullptr);
+				component->Bounds = ReadBounds();
+				components->Add(component);
+				if (key != nullptr)
+					model->Components->Add(key, component);
+			}
+
+			CacheBody^ top = ReadBody(gcnew CacheBody());
+			model->Surfaces = top->Surfaces;
+			model->Edges = top->Edges;
+			model->Curves = top->Curves;
+			model->Instances = top->Instances;
+			model->Groups = top->Groups;
+
+			for each (Component^ component in components)
+			{
+				CacheBody^ body = ReadBody(gcnew CacheBody());
+				component->Surfaces = body->Surfaces;
+				component->Edges = body->Edges;
+				component->Curves = body->Curves;
+				component->Instances = body->Instances;
+				component->Groups = body->Groups;
+			}
+
+			if (reader->BaseStream->Position != reader->BaseStream->Length)
+				throw gcnew IO::InvalidDataException();
+			return model;
+		}
+
+	private:
+		IO::BinaryReader^ reader;
+		GeometryStore^ store;
+		List<String^>^ strings;
+		List<Material^>^ materials;
+		List<Component^>^ components;
+		List<CacheBody^>^ bodies;
+
+		int Count()
+		{
+			int count = reader->ReadInt32();
+			if (count < 0 || count > reader->BaseStream->Length)
+				throw gcnew IO::InvalidDataException();
+			return count;
+		}
+
+		String^ Str()
+		{
+			int id = reader->ReadInt32();
+			return (id < 0) ? nullptr : strings[id];
+		}
+
+		Material^ MaterialRef()
+		{
+			int id = reader->ReadInt32();
+			return (id < 0) ? nullptr : materials[id];
+		}
+
+		size_t StoreIndex(int count)
+		{
+			long long index = reader->ReadInt64();
+			if (index < 0 || index >= count)
+				throw gcnew IO::InvalidDataException();
+			return (size_t)index;
+		}
+
+		Color^ ReadColor()
+		{
+			if (!reader->ReadBoolean())
+				return nullptr;
+			unsigned argb = (unsigned)reader->ReadInt32();
+			return gcnew Color((byte)(argb >> 24), (byte)(argb >> 16), (byte)(argb >> 8), (byte)argb);
+		}
+
+		Material^ ReadMaterial()
+		{
+			String^ name = Str();
+			Color^ colour = ReadColor();
+			double opacity = reader->ReadDouble();
+			bool useOpacity = reader->ReadBoolean();
+			bool usesColor = reader->ReadBoolean();
+			bool usesTexture = reader->ReadBoolean();
+
+			Texture^ texture = nullptr;
+			if (reader->ReadBoolean())
+			{
+				String^ textureName = Str();
+				Color^ textureColour = ReadColor();
+				double textureOpacity = reader->ReadDouble();
+				bool useAlpha = reader->ReadBoolean();
+				int height = reader->ReadInt32();
+				int width = reader->ReadInt32();
+				double scaleH = reader->ReadDouble();
+				double scaleW = reader->ReadDouble();
+				texture = gcnew Texture(textureName, textureColour, useAlpha, height, width, scaleH, scaleW);
+				texture->Opacity = textureOpacity;
+			}
+			return gcnew Material(name, colour, useOpacity, opacity, usesColor, usesTexture, texture);
+		}
+
+		Vector^ ReadVector()
+		{
+			if (!reader->ReadBoolean())
+				return nullptr;
+			double x = reader->ReadDouble();
+			double y = reader->ReadDouble();
+			return gcnew Vector(x, y, reader->ReadDouble());
+		}
+
+		Transform^ ReadTransform()
+		{
+			if (!reader->ReadBoolean())
+				return nullptr;
+			array<double>^ data = gcnew array<double>(16);
+			for (int i = 0; i < 16; i++)
+				data[i] = reader->ReadDouble();
+			return gcnew Transform(data);
+		}
+
+		BoundingBox^ ReadBounds()
+		{
+			if (!reader->ReadBoolean())
+				return nullptr;
+			array<double>^ box = gcnew array<double>(6);
+			for (int i = 0; i < 6; i++)
+				box[i] = reader->ReadDouble();
+			return gcnew BoundingBox(gcnew Vertex(box[0], box[1], box[2]), gcnew Vertex(box[3], box[4], box[5]));
+		}
+
+		CacheBody^ ReadBody(CacheBody^ body)
+		{
+			int count = Count();
+			for (int i = 0; i < count; i++)
+			{
+				size_t face = StoreIndex(store->FaceCount);
+				Vector^ normal = ReadVector();
+				double area = reader->ReadDouble();
+				long long mesh = reader->ReadInt64();
+				if (mesh >= store->MeshCount)
+					throw gcnew IO::InvalidDataException();
+				String^ layer = Str();
+				Material^ front = MaterialRef();
+				Material^ back = MaterialRef();
+				Mesh^ m = (mesh < 0) ? nullptr : gcnew Mesh(store, (size_t)mesh, layer);
+				body->Surfaces->Add(gcnew Surface(store, face, normal, area, m, layer, back, front));
+			}
+
+			count = Count();
+			for (int i = 0; i < count; i++)
+				body->Edges->Add(gcnew Edge(store, StoreIndex(store->EdgeCount)));
+
+			count = Count();
+			for (int i = 0; i < count; i++)
+			{
+				bool isArc = reader->ReadBoolean();
+				int edgeCount = Count();
+				List<Edge^>^ edges = gcnew List<Edge^>(edgeCount);
+				for (int e = 0; e < edgeCount; e++)
+					edges->Add(gcnew Edge(store, StoreIndex(store->EdgeCount)));
+				body->Curves->Add(gcnew Curve(edges, isArc));
+			}
+
+			count = Count();
+			for (int i = 0; i < count; i++)
+			{
+				String^ name = Str();
+				String^ guid = Str();
+				String^ parentId = Str();
+				String^ layer = Str();
+				Material^ material = MaterialRef();
+				Transform^ transform = ReadTransform();
+				Instance^ instance = gcnew Instance(name, guid, parentId, transform, layer, material);
+				instance->Bounds = ReadBounds();
+				int parent = reader->ReadInt32();
+				instance->Parent = (parent < 0) ? nullptr : components[parent];
+				body->Instances->Add(instance);
+			}
+
+			count = Count();
+			for (int i = 0; i < count; i++)
+			{
+				String^ name = Str();
+				String^ guid = Str();
+				String^ layer = Str();
+				Material^ material = MaterialRef();
+				Transform^ transform = ReadTransform();
+				BoundingBox^ bounds = ReadBounds();
+
+				int id = Count();
+				CacheBody^ shared;
+				if (id < bodies->Count)
+					shared = bodies[id];
+				else if (id == bodies->Count)
+				{
+					// Registered before its contents so that nested bodies get the ids the encoder gave them
+					shared = gcnew CacheBody();
+					bodies->Add(shared);
+					ReadBody(shared);
+				}
+				else
+					throw gcnew IO::InvalidDataException();
+
+				Group^ group = gcnew Group(name, shared->Surfaces, shared->Curves, shared->Edges, shared->Instances, shared->Groups, transform, layer, material, guid);
+				group->Bounds = bounds;
+				body->Groups->Add(group);
+			}
+			return body;
+		}
+	};
+
+	/// <summary>
+	/// Binary cache of converted models. A .skpc file holds the geometry store blocks and the entity, definition,
+	/// material and layer tables of a loaded model, keyed by the full path, size and modification time of the .skp file.
+	/// A hit is read from a memory-mapped view without starting the SketchUp API.
+	/// </summary>
+	public ref class ModelCache
+	{
+	public:
+		/// <summary>
+		/// Version of the cache format, files of other versions are rebuilt
+		/// </summary>
+		literal int FormatVersion = 1;
+
+		/// <summary>
+		/// Directory of the .skpc files
+		/// </summary>
+		System::String^ Directory;
+
+		/// <summary>
+		/// The last load was read from the cache
+		/// </summary>
+		bool Hit;
+
+		/// <summary>
+		/// Size of the cache file read or written by the last load
+		/// </summary>
+		long long ByteCount;
+
+		ModelCache(System::String^ directory)
+		{
+			this->Directory = directory;
+		};
+
+		/// <summary>
+		/// Path of the cache file of a model, named after the file and a hash of its full path
+		/// </summary>
+		/// <param name="filename">Path to .skp file</param>
+		System::String^ GetCachePath(System::String^ filename)
+		{
+			String^ full = IO::Path::GetFullPath(filename);
+			String^ key = full->ToUpperInvariant();
+			pin_ptr<const wchar_t> chars = PtrToStringChars(key);
+			unsigned long long hash = CacheHasher::Of(chars, key->Length * sizeof(wchar_t));
+			return IO::Path::Combine(Directory, String::Format("{0}-{1:x16}.skpc", IO::Path::GetFileNameWithoutExtension(full), hash));
+		}
+
+		/// <summary>
+		/// Deletes the cache file of a model
+		/// </summary>
+		/// <param name="filename">Path to .skp file</param>
+		void Invalidate(System::String^ filename)
+		{
+			String^ path = GetCachePath(filename);
+			if (IO::File::Exists(path))
+				IO::File::Delete(path);
+		}
+
+	internal:
+		/// <summary>
+		/// Filtered loads and texture pixels are not cached
+		/// </summary>
+		static bool Supports(LoadOptions^ options)
+		{
+			return options == nullptr || (!options->Filters && !options->TextureImages);
+		}
+
+		/// <summary>
+		/// Reads the cached model of a source file, null if there is no valid cache file for it.
+		/// Reading the key fills the FileInfo, so a later Write stores the key as it was before the load.
+		/// </summary>
+		CachedModel^ Read(IO::FileInfo^ source, bool includeMeshes, LoadOptions^ options, bool singleThreaded)
+		{
+			using namespace System::IO::MemoryMappedFiles;
+
+			Hit = false;
+			ByteCount = 0;
+			if (!Supports(options) || !source->Exists)
+				return nullptr;
+
+			String^ path = GetCachePath(source->FullName);
+			IO::FileInfo^ cache = gcnew IO::FileInfo(path);
+			if (!cache->Exists || cache->Length < (long long)sizeof(CacheHeader))
+				return nullptr;
+
+			try
+			{
+				MemoryMappedFile^ file = MemoryMappedFile::CreateFromFile(path, IO::FileMode::Open, nullptr, 0, MemoryMappedFileAccess::Read);
+				try
+				{
+					MemoryMappedViewAccessor^ view = file->CreateViewAccessor(0, 0, MemoryMappedFileAccess::Read);
+					try
+					{
+						Byte* data = nullptr;
+						view->SafeMemoryMappedViewHandle->AcquirePointer(data);
+						try
+						{
+							// The view capacity is rounded up to pages, the file length is the payload end
+							CachedModel^ model = Decode(data + view->PointerOffset, (size_t)cache->Length, source, Flags(includeMeshes, options), singleThreaded);
+							if (model != nullptr)
+							{
+								Hit = true;
+								ByteCount = cache->Length;
+							}
+							return model;
+						}
+						finally
+						{
+							view->SafeMemoryMappedViewHandle->ReleasePointer();
+						}
+					}
+					finally
+					{
+						delete view;
+					}
+				}
+				finally
+				{
+					delete file;
+				}
+			}
+			catch (IO::InvalidDataException^)
+			{
+				// Tables that do not fit the geometry they were written with
+				return nullptr;
+			}
+			catch (IO::EndOfStreamException^)
+			{
+				return nullptr;
+			}
+			catch (IO::IOException^)
+			{
+				return nullptr;
+			}
+			catch (UnauthorizedAccessException^)
+			{
+				return nullptr;
+			}
+			catch (ArgumentException^)
+			{
+				return nullptr;
+			}
+		}
+
+		/// <summary>
+		/// Writes the cache file of a loaded model through a temporary file.
+		/// Returns false if the model cannot be cached or the file not be written, the load itself is not affected.
+		/// </summary>
+		bool Write(IO::FileInfo^ source, bool includeMeshes, LoadOptions^ options, CachedModel^ model)
+		{
+			if (!Supports(options) || !source->Exists || model->Geometry == nullptr)
+				return false;
+
+			CacheEncoder^ encoder = gcnew CacheEncoder();
+			try
+			{
+				encoder->Encode(model, source->FullName);
+			}
+			catch (NotSupportedException^)
+			{
+				return false;
+			}
+
+			CacheHeader header = {};
+			memcpy(header.Magic, "SKPC", 4);
+			header.Version = FormatVersion;
+			header.Flags = Flags(includeMeshes, options);
+			header.PointerSize = sizeof(size_t);
+			header.SourceSize = source->Length;
+			header.SourceTime = source->LastWriteTimeUtc.Ticks;
+
+			String^ path = GetCachePath(source->FullName);
+			String^ temporary = path + "." + Guid::NewGuid().ToString("N") + ".tmp";
+			try
+			{
+				IO::Directory::CreateDirectory(Directory);
+
+				FILE* file = nullptr;
+				pin_ptr<const wchar_t> output = PtrToStringChars(temporary);
+				if (_wfopen_s(&file, output, L"wb") != 0 || file == nullptr)
+					return false;
+
+				bool written = false;
+				try
+				{
+					CacheWriter writer(file);
+					Put(writer, encoder->Strings);
+					Put(writer, encoder->Tables);
+					WriteGeometry(writer, *model->Geometry->Buffer);
+					written = writer.Finish(header);
+				}
+				finally
+				{
+					fclose(file);
+				}
+
+				if (!written)
+				{
+					IO::File::Delete(temporary);
+					return false;
+				}
+
+				if (IO::File::Exists(path))
+					IO::File::Delete(path);
+				IO::File::Move(temporary, path);
+				ByteCount = (long long)(sizeof(CacheHeader) + header.PayloadSize);
+				return true;
+			}
+			catch (IO::IOException^)
+			{
+			}
+			catch (UnauthorizedAccessException^)
+			{
+			}
+			if (IO::File::Exists(temporary))
+				IO::File::Delete(temporary);
+			return false;
+		}
+
+	private:
+		static unsigned int Flags(bool includeMeshes, LoadOptions^ options)
+		{
+			unsigned int flags = includeMeshes ? CacheMeshes : 0;
+			if (options != nullptr && options->SharedTopology)
+				flags |= CacheSharedTopology;
+			if (options != nullptr && options->TextureCoordinates)
+				flags |= CacheTextureCoordinates;
+			return flags;
+		}
+
+		static void Put(CacheWriter& writer, IO::MemoryStream^ section)
+		{
+			writer.Count((unsigned long long)section->Length);
+			if (section->Length > 0)
+			{
+				array<Byte>^ bytes = section->GetBuffer();
+				pin_ptr<Byte> p = &bytes[0];
+				writer.Put(p, (size_t)section->Length);
+			}
+			writer.Align();
+		}
+
+		static IO::BinaryReader^ Open(const unsigned char* data, size_t size)
+		{
+			return gcnew IO::BinaryReader(gcnew IO::UnmanagedMemoryStream(const_cast<unsigned char*>(data), (long long)size));
+		}
+
+		static CachedModel^ Decode(const unsigned char* data, size_t size, IO::FileInfo^ source, unsigned int flags, bool singleThreaded)
+		{
+			CacheHeader header;
+			memcpy(&header, data, sizeof(header));
+			if (memcmp(header.Magic, "SKPC", 4) != 0 || header.Version != (unsigned int)FormatVersion || header.PointerSize != sizeof(size_t)
+				|| header.HeaderHash != CacheHasher::Of(&header, offsetof(CacheHeader, HeaderHash)))
+				return nullptr;
+			if (header.Flags != flags || header.SourceSize != source->Length || header.SourceTime != source->LastWriteTimeUtc.Ticks)
+				return nullptr;
+			if (header.PayloadSize != size - sizeof(CacheHeader))
+				return nullptr;
+
+			const unsigned char* payload = data + sizeof(CacheHeader);
+			if (CacheHasher::Of(payload, (size_t)header.PayloadSize) != header.PayloadHash)
+				return nullptr;
+
+			CacheReader reader(payload, (size_t)header.PayloadSize);
+			const unsigned char* strings = nullptr;
+			const unsigned char* tables = nullptr;
+			size_t stringsSize = 0, tablesSize = 0;
+			if (!reader.Section(strings, stringsSize) || !reader.Section(tables, tablesSize))
+				return nullptr;
+
+			GeometryStore^ store = gcnew GeometryStore();
+			GeometryBuffer* b = store->Buffer;
+			b->Shared = (flags & CacheSharedTopology) != 0;
+			b->TextureCoordinates = (flags & CacheTextureCoordinates) != 0;
+			if (!ReadGeometry(reader, *b) || !reader.AtEnd())
+				return nullptr;
+
+			// Blocks are stored converted, committing only sizes the shared points and the memory pressure
+			b->CommittedPoints = b->X.size();
+			b->CommittedMeshPoints = b->MeshX.size();
+			b->CommittedFaces = b->FaceVertices.size();
+			store->Commit(singleThreaded);
+
+			CacheDecoder^ decoder = gcnew CacheDecoder(store, Open(strings, stringsSize));
+			return decoder->Decode(Open(tables, tablesSize), source->FullName);
+		}
+	};
+}
\ No newline at end of file
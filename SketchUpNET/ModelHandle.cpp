@@ -0,0 +1,300 @@
+/*
+
+SketchUpNET - a C++ Wrapper for the Trimble(R) SketchUp(R) C API
+Copyright(C) 2015, Autor: Maximilian Thumfart
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <SketchUpAPI/slapi.h>
+#include <SketchUpAPI/initialize.h>
+#include <SketchUpAPI/model/model.h>
+#include <SketchUpAPI/model/entities.h>
+#include <SketchUpAPI/model/component_definition.h>
+#include <vector>
+#include "Utilities.h"
+#include "GeometryStore.h"
+#include "LoadContext.h"
+#include "Surface.h"
+#include "Edge.h"
+#include "Curve.h"
+#include "Layer.h"
+#include "Group.h"
+#include "Instance.h"
+#include "Component.h"
+#include "LoadOptions.h"
+#include "SketchUpSession.h"
+
+using namespace System;
+using namespace System::Collections;
+using namespace System::Collections::Generic;
+
+namespace SketchUpNET
+{
+	/// <summary>
+	/// Open SketchUp Model that converts its entities on first access.
+	/// Layers, Materials and Component metadata and bounds are read when the model is opened,
+	/// top level geometry is converted per collection on its first access and component bodies per definition,
+	/// both are then cached for the lifetime of the handle.
+	/// The handle is not thread-safe and has to be disposed to release the model.
+	/// </summary>
+	public ref class ModelHandle
+	{
+	public:
+		/// <summary>
+		/// Opens a SketchUp Model from filepath without loading Meshes.
+		/// </summary>
+		/// <param name="filename">Path to .skp file</param>
+		ModelHandle(System::String^ filename) : ModelHandle(filename, false) {}
+
+		/// <summary>
+		/// Opens a SketchUp Model from filepath. Optionally load meshed geometries.
+		/// </summary>
+		/// <param name="filename">Path to .skp file</param>
+		/// <param name="includeMeshes">Load model including meshed geometries</param>
+		ModelHandle(System::String^ filename, bool includeMeshes) : ModelHandle(filename, includeMeshes, nullptr) {}
+
+		/// <summary>
+		/// Opens a SketchUp Model from filepath. Only top level entities passing the given filters are converted.
+		/// </summary>
+		/// <param name="filename">Path to .skp file</param>
+		/// <param name="includeMeshes">Load model including meshed geometries</param>
+		/// <param name="options">Layer, kind, visibility and region filters, null loads everything</param>
+		ModelHandle(System::String^ filename, bool includeMeshes, LoadOptions^ options)
+		{
+			Utilities::Utf8String path(filename);
+
+			SketchUpSession::Enter();
+
+			model = new SUModelRef();
+			SUSetInvalid(*model);
+			SUModelLoadStatus status;
+			if (SUModelCreateFromFileWithStatus(model, path, &status) != SU_ERROR_NONE)
+			{
+				delete model;
+				model = nullptr;
+				SketchUpSession::Leave();
+				throw gcnew System::IO::IOException("Could not open SketchUp Model " + filename);
+			}
+
+			MoreRecentFileVersion = (status == SUModelLoadStatus_Success_MoreRecent);
+
+			try
+			{
+				Materials = Material::GetModelMaterials(*model);
+				Layers = Layer::GetModelLayers(*model);
+				if (options != nullptr && options->TextureImages)
+				{
+					TextureImages = TextureImage::Collect(*model, false);
+					Material::AttachImages(Materials, TextureImages);
+				}
+				Geometry = gcnew GeometryStore(options);
+
+				context = gcnew LoadContext(includeMeshes, Materials, Geometry);
+				context->Lazy = true;
+				context->SetFilter(*model, options);
+
+				// Component metadata is needed to resolve the parents of instances
+				components = gcnew Dictionary<String^, Component^>();
+				size_t compCount = 0;
+				SUModelGetNumComponentDefinitions(*model, &compCount);
+
+				if (compCount > 0) {
+					std::vector<SUComponentDefinitionRef> comps(compCount);
+					SUModelGetComponentDefinitions(*model, compCount, &comps[0], &compCount);
+
+					for (size_t i = 0; i < compCount; i++) {
+						Component^ component = Component::FromSU(comps[i], context);
+						components->Add(component->Guid, component);
+					}
+				}
+			}
+			catch (Exception^)
+			{
+				// The destructor does not run for a throwing constructor
+				delete context;
+				delete Geometry;
+				context = nullptr;
+				Geometry = nullptr;
+				SUModelRelease(model);
+				delete model;
+				model = nullptr;
+				SketchUpSession::Leave();
+				throw;
+			}
+		}
+
+		/// <summary>
+		/// Releases the model. There is no finalizer: the SDK is single-threaded and must not be called
+		/// from the finalizer thread, so a handle that is never disposed keeps its model until the process exits.
+		/// </summary>
+		~ModelHandle()
+		{
+			if (model == nullptr)
+				return;
+
+			context->CloseModel();
+			SUModelRelease(model);
+			delete model;
+			model = nullptr;
+			SketchUpSession::Leave();
+		}
+
+		/// <summary>
+		/// Model Layers
+		/// </summary>
+		List<Layer^>^ Layers;
+
+		/// <summary>
+		/// Model Material Definitions
+		/// </summary>
+		Dictionary<String^, Material^>^ Materials;
+
+		/// <summary>
+		/// Distinct images of the material textures, null unless opened with LoadOptions.TextureImages
+		/// </summary>
+		List<TextureImage^>^ TextureImages;
+
+		/// <summary>
+		/// Native geometry of everything converted so far
+		/// </summary>
+		GeometryStore^ Geometry;
+
+		/// <summary>
+		/// Version of the loaded file is more recent than the SketchUp API
+		/// </summary>
+		bool MoreRecentFileVersion;
+
+		/// <summary>
+		/// Convert geometry on the calling thread only
+		/// </summary>
+		property bool SingleThreaded
+		{
+			bool get() { return context->SingleThreaded; }
+			void set(bool value) { context->SingleThreaded = value; }
+		}
+
+		/// <summary>
+		/// Model Component Definitions. The body of each component is converted on first access.
+		/// </summary>
+		property Dictionary<String^, Component^>^ Components
+		{
+			Dictionary<String^, Component^>^ get() { return components; }
+		}
+
+		/// <summary>
+		/// Top level Surfaces of the model
+		/// </summary>
+		property List<Surface^>^ Surfaces
+		{
+			List<Surface^>^ get()
+			{
+				if (surfaces == nullptr)
+				{
+					surfaces = Surface::GetEntitySurfaces(Entities(), context);
+					Component::Convert(context);
+				}
+				return surfaces;
+			}
+		}
+
+		/// <summary>
+		/// Top level Edges (Lines) of the model
+		/// </summary>
+		property List<Edge^>^ Edges
+		{
+			List<Edge^>^ get()
+			{
+				if (edges == nullptr)
+				{
+					edges = Edge::GetEntityEdges(Entities(), context);
+					Component::Convert(context);
+				}
+				return edges;
+			}
+		}
+
+		/// <summary>
+		/// Top level Curves (Arcs) of the model
+		/// </summary>
+		property List<Curve^>^ Curves
+		{
+			List<Curve^>^ get()
+			{
+				if (curves == nullptr)
+				{
+					curves = Curve::GetEntityCurves(Entities(), context);
+					Component::Convert(context);
+				}
+				return curves;
+			}
+		}
+
+		/// <summary>
+		/// Top level Groups of the model including their contents
+		/// </summary>
+		property List<Group^>^ Groups
+		{
+			List<Group^>^ get()
+			{
+				if (groups == nullptr)
+				{
+					groups = Group::GetEntityGroups(Entities(), context);
+					Component::Convert(context);
+				}
+				return groups;
+			}
+		}
+
+		/// <summary>
+		/// Top level Component Instances of the model
+		/// </summary>
+		property List<Instance^>^ Instances
+		{
+			List<Instance^>^ get()
+			{
+				if (instances == nullptr)
+				{
+					instances = Instance::GetEntityInstances(Entities(), context);
+					Component::Convert(context);
+				}
+				return instances;
+			}
+		}
+
+	private:
+		SUModelRef* model;
+		LoadContext^ context;
+		Dictionary<String^, Component^>^ components;
+		List<Surface^>^ surfaces;
+		List<Edge^>^ edges;
+		List<Curve^>^ curves;
+		List<Group^>^ groups;
+		List<Instance^>^ instances;
+
+		SUEntitiesRef Entities()
+		{
+			if (model == nullptr)
+				throw gcnew ObjectDisposedException("ModelHandle");
+
+			SUEntitiesRef entities = SU_INVALID;
+			SUModelGetEntities(*model, &entities);
+			return entities;
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,939 @@
+/*
+
+SketchUpNET - a C++ Wrapper for the Trimble(R) SketchUp(R) C API
+Copyright(C) 2015, Autor: Maximilian Thumfart
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+#pragma once
+
+#include <SketchUpAPI/slapi.h>
+#include <SketchUpAPI/geometry.h>
+#include <SketchUpAPI/model/model.h>
+#include <SketchUpAPI/model/entities.h>
+#include <SketchUpAPI/model/geometry_input.h>
+#include <SketchUpAPI/model/layer.h>
+#include <SketchUpAPI/model/material.h>
+#include <SketchUpAPI/model/group.h>
+#include <SketchUpAPI/model/component_definition.h>
+#include <SketchUpAPI/model/component_instance.h>
+#include <SketchUpAPI/model/drawing_element.h>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "Utilities.h"
+#include "Vertex.h"
+#include "Edge.h"
+#include "Loop.h"
+#include "Curve.h"
+#include "Surface.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "GeometryStore.h"
+#include "Transform.h"
+#include "Group.h"
+#include "Component.h"
+#include "Instance.h"
+#include "InstanceSet.h"
+
+using namespace System;
+using namespace System::Collections;
+using namespace System::Collections::Generic;
+
+namespace SketchUpNET
+{
+#pragma managed(push, off)
+	/// <summary>
+	/// Creates and adds one instance of a definition per row major 3x4 transform in meters.
+	/// Stops at the first failing instance and returns its error.
+	/// </summary>
+	inline SUResult PlaceInstances(SUComponentDefinitionRef definition, SUEntitiesRef entities, const double* transforms, size_t count,
+		SULayerRef layer, SUMaterialRef material, size_t* placed)
+	{
+		*placed = 0;
+		SUTransformation transformation;
+		for (size_t i = 0; i < count; i++)
+		{
+			const double* t = transforms + 12 * i;
+			double* v = transformation.values;
+			v[0] = t[0]; v[1] = t[4]; v[2] = t[8]; v[3] = 0.0;
+			v[4] = t[1]; v[5] = t[5]; v[6] = t[9]; v[7] = 0.0;
+			v[8] = t[2]; v[9] = t[6]; v[10] = t[10]; v[11] = 0.0;
+			v[12] = t[3] * 39.3701; v[13] = t[7] * 39.3701; v[14] = t[11] * 39.3701; v[15] = 1.0;
+
+			SUComponentInstanceRef instance = SU_INVALID;
+			SUResult result = SUComponentDefinitionCreateInstance(definition, &instance);
+			if (result != SU_ERROR_NONE)
+				return result;
+			SUComponentInstanceSetTransform(instance, &transformation);
+
+			result = SUEntitiesAddInstance(entities, instance, nullptr);
+			if (result != SU_ERROR_NONE)
+			{
+				SUComponentInstanceRelease(&instance);
+				return result;
+			}
+
+			SUDrawingElementRef element = SUComponentInstanceToDrawingElement(instance);
+			if (!SUIsInvalid(layer))
+				SUDrawingElementSetLayer(element, layer);
+			if (!SUIsInvalid(material))
+				SUDrawingElementSetMaterial(element, material);
+			(*placed)++;
+		}
+		return SU_ERROR_NONE;
+	}
+#pragma managed(pop)
+
+	/// <summary>
+	/// Face collected for a geometry input: loops of vertex indices, outer loop first
+	/// </summary>
+	struct WriterFace
+	{
+		GeometryRange Loops;
+		// Edges of the outer loop marked soft and smooth, bit i for the edge leaving vertex i
+		unsigned int SoftEdges;
+		SUMaterialRef Front;
+		SUMaterialRef Back;
+		SULayerRef Layer;
+	};
+
+	/// <summary>
+	/// Loose edge collected for a geometry input
+	/// </summary>
+	struct WriterEdge
+	{
+		size_t Start;
+		size_t End;
+		SULayerRef Layer;
+	};
+
+	/// <summary>
+	/// Geometry collected for one SUGeometryInput. Points are deduplicated by their exact coordinates,
+	/// or welded within Tolerance through a spatial hash, so faces of a batch share their vertices
+	/// and SketchUp does not have to merge them one by one.
+	/// </summary>
+	class WriterBatch
+	{
+	public:
+		// Weld distance in inches, zero shares exactly equal points only
+		double Tolerance = 0.0;
+
+		std::vector<SUPoint3D> Points;
+		std::vector<size_t> LoopVertices;
+		std::vector<GeometryRange> Loops;
+		std::vector<WriterFace> Faces;
+		std::vector<WriterEdge> Edges;
+		// Edges of each curve as indices into Edges
+		std::vector<GeometryRange> Curves;
+
+		size_t AddPoint(const SUPoint3D& point)
+		{
+			if (Tolerance > 0.0)
+				return WeldPoint(point);
+
+			// Adding zero folds negative zero into zero so both hash alike
+			PointKey key = { point.x + 0.0, point.y + 0.0, point.z + 0.0 };
+			auto found = indices.find(key);
+			if (found != indices.end())
+				return found->second;
+			Points.push_back(point);
+			indices.emplace(key, Points.size() - 1);
+			return Points.size() - 1;
+		}
+
+		// Appends a loop without repeated points, loops with less than three distinct points are dropped
+		bool AddLoop(const std::vector<size_t>& vertices)
+		{
+			size_t start = LoopVertices.size();
+			for (size_t i = 0; i < vertices.size(); i++)
+				if (LoopVertices.size() == start || LoopVertices.back() != vertices[i])
+					LoopVertices.push_back(vertices[i]);
+			if (LoopVertices.size() - start > 1 && LoopVertices.back() == LoopVertices[start])
+				LoopVertices.pop_back();
+
+			if (LoopVertices.size() - start < 3)
+			{
+				LoopVertices.resize(start);
+				return false;
+			}
+			GeometryRange loop = { start, LoopVertices.size() - start };
+			Loops.push_back(loop);
+			return true;
+		}
+
+		size_t Size() const
+		{
+			return Points.size();
+		}
+
+		// Fills the collected geometry into the entities with a single SUEntitiesFill and starts a new batch
+		SUResult Fill(SUEntitiesRef entities)
+		{
+			if (Faces.empty() && Edges.empty())
+			{
+				Clear();
+				return SU_ERROR_NONE;
+			}
+
+			SUGeometryInputRef input = SU_INVALID;
+			SUResult result = SUGeometryInputCreate(&input);
+			if (result != SU_ERROR_NONE)
+				return result;
+
+			SUGeometryInputSetVertices(input, Points.size(), Points.data());
+
+			for (size_t f = 0; f < Faces.size(); f++)
+			{
+				const WriterFace& face = Faces[f];
+				size_t index = 0;
+				for (size_t l = face.Loops.Start; l < face.Loops.Start + face.Loops.Count; l++)
+				{
+					SULoopInputRef loop = SU_INVALID;
+					SULoopInputCreate(&loop);
+					for (size_t v = Loops[l].Start; v < Loops[l].Start + Loops[l].Count; v++)
+						SULoopInputAddVertexIndex(loop, LoopVertices[v]);
+
+					if (l == face.Loops.Start && face.SoftEdges != 0)
+						for (size_t e = 0; e < Loops[l].Count && e < 32; e++)
+							if (face.SoftEdges & (1u << e))
+							{
+								SULoopInputEdgeSetSoft(loop, e, true);
+								SULoopInputEdgeSetSmooth(loop, e, true);
+							}
+
+					// The input takes ownership of the loops
+					if (l == face.Loops.Start)
+						SUGeometryInputAddFace(input, &loop, &index);
+					else
+						SUGeometryInputFaceAddInnerLoop(input, index, &loop);
+				}
+
+				if (SUIsValid(face.Front))
+				{
+					SUMaterialInput material = Material(face.Front);
+					SUGeometryInputFaceSetFrontMaterial(input, index, &material);
+				}
+				if (SUIsValid(face.Back))
+				{
+					SUMaterialInput material = Material(face.Back);
+					SUGeometryInputFaceSetBackMaterial(input, index, &material);
+				}
+				if (SUIsValid(face.Layer))
+					SUGeometryInputFaceSetLayer(input, index, face.Layer);
+			}
+
+			std::vector<size_t> edgeIndices(Edges.size());
+			for (size_t e = 0; e < Edges.size(); e++)
+			{
+				SUGeometryInputAddEdge(input, Edges[e].Start, Edges[e].End, &edgeIndices[e]);
+				if (SUIsValid(Edges[e].Layer))
+					SUGeometryInputEdgeSetLayer(input, edgeIndices[e], Edges[e].Layer);
+			}
+
+			for (size_t c = 0; c < Curves.size(); c++)
+			{
+				std::vector<size_t> curve(Curves[c].Count);
+				for (size_t e = 0; e < Curves[c].Count; e++)
+					curve[e] = edgeIndices[Curves[c].Start + e];
+				size_t index = 0;
+				SUGeometryInputAddCurve(input, curve.size(), curve.data(), &index);
+			}
+
+			result = SUEntitiesFill(entities, input, true);
+			SUGeometryInputRelease(&input);
+			Clear();
+			return result;
+		}
+
+	private:
+		struct PointKey
+		{
+			double X;
+			double Y;
+			double Z;
+
+			bool operator==(const PointKey& other) const
+			{
+				return X == other.X && Y == other.Y && Z == other.Z;
+			}
+		};
+
+		struct PointHash
+		{
+			size_t operator()(const PointKey& key) const
+			{
+				std::hash<double> hash;
+				size_t h = hash(key.X);
+				h ^= hash(key.Y) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+				h ^= hash(key.Z) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+				return h;
+			}
+		};
+
+		std::unordered_map<PointKey, size_t, PointHash> indices;
+
+		struct CellKey
+		{
+			long long X;
+			long long Y;
+			long long Z;
+
+			bool operator==(const CellKey& other) const
+			{
+				return X == other.X && Y == other.Y && Z == other.Z;
+			}
+		};
+
+		struct CellHash
+		{
+			size_t operator()(const CellKey& key) const
+			{
+				return (size_t)(key.X * 73856093LL ^ key.Y * 19349663LL ^ key.Z * 83492791LL);
+			}
+		};
+
+		// Last point added to each cell of the weld grid, earlier points of a cell are chained through Chain
+		std::unordered_map<CellKey, size_t, CellHash> cells;
+		std::vector<size_t> Chain;
+
+		// Returns an earlier point within Tolerance or adds the point. Cells are Tolerance wide,
+		// so every candidate lies in the cell of the point or one of its 26 neighbours.
+		size_t WeldPoint(const SUPoint3D& point)
+		{
+			CellKey cell = { (long long)std::floor(point.x / Tolerance), (long long)std::floor(point.y / Tolerance), (long long)std::floor(point.z / Tolerance) };
+			double t2 = Tolerance * Tolerance;
+
+			for (int i = 0; i < 27; i++)
+			{
+				// Own cell first, it holds the match in almost all cases
+				int n = (i + 13) % 27;
+				CellKey neighbour = { cell.X + n % 3 - 1, cell.Y + (n / 3) % 3 - 1, cell.Z + n / 9 - 1 };
+				auto found = cells.find(neighbour);
+				if (found == cells.end()) continue;
+
+				for (size_t p = found->second; p != SIZE_MAX; p = Chain[p])
+				{
+					double dx = Points[p].x - point.x, dy = Points[p].y - point.y, dz = Points[p].z - point.z;
+					if (dx * dx + dy * dy + dz * dz <= t2)
+						return p;
+				}
+			}
+
+			Points.push_back(point);
+			size_t index = Points.size() - 1;
+			auto head = cells.find(cell);
+			Chain.push_back((head == cells.end()) ? SIZE_MAX : head->second);
+			cells[cell] = index;
+			return index;
+		}
+
+		static SUMaterialInput Material(SUMaterialRef material)
+		{
+			SUMaterialInput input;
+			std::memset(&input, 0, sizeof(input));
+			input.material = material;
+			return input;
+		}
+
+		void Clear()
+		{
+			Points.clear();
+			LoopVertices.clear();
+			Loops.clear();
+			Faces.clear();
+			Edges.clear();
+			Curves.clear();
+			indices.clear();
+			cells.clear();
+			Chain.clear();
+		}
+	};
+
+	/// <summary>
+	/// Writes surfaces, meshes, edges and curves into a model through SUGeometryInput.
+	/// Geometry is collected natively with shared vertices and committed with one SUEntitiesFill per batch,
+	/// so SketchUp merges each batch once instead of once per face.
+	/// Materials and layers are matched by name and created if the model does not have them.
+	/// </summary>
+	public ref class ModelWriter
+	{
+	public:
+		/// <summary>
+		/// Number of distinct vertices collected before a batch is filled into the model.
+		/// Bounds the memory of the native batch and of the geometry input.
+		/// </summary>
+		int BatchSize;
+
+		/// <summary>
+		/// Distance in meters within which vertices are welded into one, applied to all geometry of a write.
+		/// Zero, the default, welds exactly equal vertices only; set it to weld the displaced corners of meshes.
+		/// </summary>
+		double WeldTolerance;
+
+		/// <summary>
+		/// Mark mesh edges shared by two triangles soft and smooth, so the mesh shows as one smooth surface
+		/// </summary>
+		bool SoftenInteriorEdges;
+
+		/// <summary>
+		/// Component definitions created by the last write
+		/// </summary>
+		int DefinitionCount;
+
+		/// <summary>
+		/// Groups and component instances placed by the last write
+		/// </summary>
+		int PlacementCount;
+
+		/// <summary>
+		/// Faces written by the last write
+		/// </summary>
+		int FaceCount;
+
+		/// <summary>
+		/// Edges written by the last write, curve edges included
+		/// </summary>
+		int EdgeCount;
+
+		/// <summary>
+		/// Batches filled by the last write
+		/// </summary>
+		int BatchCount;
+
+		ModelWriter()
+		{
+			this->BatchSize = 1 << 18;
+		};
+
+	internal:
+		/// <summary>
+		/// Writes geometry into entities of a model
+		/// </summary>
+		/// <returns>The first error returned by SUEntitiesFill</returns>
+		SUResult Write(SUModelRef model, SUEntitiesRef entities, List<Surface^>^ surfaces, List<Mesh^>^ meshes, List<Edge^>^ edges, List<Curve^>^ curves)
+		{
+			return Write(model, entities, surfaces, meshes, edges, curves, nullptr, nullptr, nullptr, nullptr);
+		}
+
+		/// <summary>
+		/// Writes geometry, groups and component instances into entities of a model.
+		/// Every component is created as one definition shared by all of its instances.
+		/// </summary>
+		/// <param name="components">Definitions to create, instances of other components add theirs on first use</param>
+		/// <param name="sets">Instances placed in bulk from packed transforms</param>
+		/// <returns>The first error returned while writing</returns>
+		SUResult Write(SUModelRef model, SUEntitiesRef entities, List<Surface^>^ surfaces, List<Mesh^>^ meshes, List<Edge^>^ edges, List<Curve^>^ curves,
+			List<Group^>^ groups, List<Instance^>^ instances, IEnumerable<Component^>^ components, List<InstanceSet^>^ sets)
+		{
+			// End frees the native batch even when a conversion throws halfway through
+			SUResult result = SU_ERROR_NONE;
+			try
+			{
+				Begin(model);
+
+				if (components != nullptr)
+					for each (Component^ component in components)
+						if (component != nullptr && !String::IsNullOrEmpty(component->Guid))
+							byGuid[component->Guid] = component;
+
+				if (components != nullptr)
+					for each (Component^ component in components)
+						if (component != nullptr)
+							result = Definition(component, result);
+
+				if (sets != nullptr)
+					for each (InstanceSet^ set in sets)
+						if (set != nullptr)
+							result = AddInstances(entities, set, result);
+
+				result = WriteEntities(entities, surfaces, meshes, edges, curves, groups, instances, result);
+			}
+			finally
+			{
+				End();
+			}
+			return result;
+		}
+
+	private:
+		WriterBatch* batch;
+		SUModelRef* model;
+		Dictionary<String^, IntPtr>^ materials;
+		Dictionary<String^, IntPtr>^ layers;
+		Dictionary<Component^, IntPtr>^ definitions;
+		Dictionary<String^, Component^>^ byGuid;
+
+		// Groups and instances are written before the geometry of their entities,
+		// so the batch is empty whenever the writer descends into nested entities
+		SUResult WriteEntities(SUEntitiesRef entities, List<Surface^>^ surfaces, List<Mesh^>^ meshes, List<Edge^>^ edges, List<Curve^>^ curves,
+			List<Group^>^ groups, List<Instance^>^ instances, SUResult result)
+		{
+			if (groups != nullptr)
+				for each (Group^ group in groups)
+					if (group != nullptr)
+						result = AddGroup(entities, group, result);
+
+			if (instances != nullptr)
+				for each (Instance^ instance in instances)
+					if (instance != nullptr)
+						result = AddInstance(entities, instance, result);
+
+			// A mesh is welded within one batch, so its interior edges are found and stay connected
+			if (meshes != nullptr)
+				for each (Mesh^ mesh in meshes)
+				{
+					if (mesh == nullptr) continue;
+					if (batch->Size() > 0 && batch->Size() + (size_t)mesh->VertexCount > (size_t)BatchSize)
+						result = Flush(entities, result);
+					AddMesh(mesh);
+				}
+
+			if (surfaces != nullptr)
+				for each (Surface^ surface in surfaces)
+				{
+					if (batch->Size() >= (size_t)BatchSize)
+						result = Flush(entities, result);
+					AddSurface(surface);
+				}
+
+			if (edges != nullptr)
+				for each (Edge^ edge in edges)
+				{
+					if (batch->Size() >= (size_t)BatchSize)
+						result = Flush(entities, result);
+					AddEdge(edge);
+				}
+
+			if (curves != nullptr)
+				for each (Curve^ curve in curves)
+				{
+					if (curve->Edges == nullptr || curve->Edges->Count == 0)
+						continue;
+					if (batch->Size() >= (size_t)BatchSize)
+						result = Flush(entities, result);
+
+					GeometryRange range = { batch->Edges.size(), 0 };
+					for each (Edge^ edge in curve->Edges)
+						AddEdge(edge);
+					range.Count = batch->Edges.size() - range.Start;
+					batch->Curves.push_back(range);
+				}
+
+			return Flush(entities, result);
+		}
+
+		SUResult AddGroup(SUEntitiesRef entities, Group^ group, SUResult result)
+		{
+			SUGroupRef ref = SU_INVALID;
+			SUGroupCreate(&ref);
+			SUResult added = SUEntitiesAddGroup(entities, ref);
+			if (added != SU_ERROR_NONE)
+			{
+				SUGroupRelease(&ref);
+				return (result != SU_ERROR_NONE) ? result : added;
+			}
+
+			if (!String::IsNullOrEmpty(group->Name))
+				SUGroupSetName(ref, Utilities::Utf8String(group->Name));
+			SetElement(SUGroupToDrawingElement(ref), group->Layer, group->Material);
+
+			SUEntitiesRef contents = SU_INVALID;
+			SUGroupGetEntities(ref, &contents);
+			result = WriteEntities(contents, group->Surfaces, nullptr, group->Edges, group->Curves, group->Groups, group->Instances, result);
+
+			// The transform is set last, SketchUp keeps it relative to the filled contents
+			if (group->Transformation != nullptr)
+			{
+				SUTransformation transformation = group->Transformation->ToSU();
+				SUGroupSetTransform(ref, &transformation);
+			}
+			PlacementCount++;
+			return result;
+		}
+
+		SUResult AddInstance(SUEntitiesRef entities, Instance^ instance, SUResult result)
+		{
+			Component^ component = dynamic_cast<Component^>(instance->Parent);
+			if (component == nullptr && instance->ParentID != nullptr)
+				byGuid->TryGetValue(instance->ParentID, component);
+			if (component == nullptr)
+				return result;
+
+			result = Definition(component, result);
+			IntPtr found;
+			if (!definitions->TryGetValue(component, found) || found == IntPtr::Zero)
+				return result;
+
+			SUComponentDefinitionRef definition = { found.ToPointer() };
+			SUComponentInstanceRef ref = SU_INVALID;
+			SUResult created = SUComponentDefinitionCreateInstance(definition, &ref);
+			if (created != SU_ERROR_NONE)
+				return (result != SU_ERROR_NONE) ? result : created;
+
+			if (!String::IsNullOrEmpty(instance->Name))
+				SUComponentInstanceSetName(ref, Utilities::Utf8String(instance->Name));
+			if (instance->Transformation != nullptr)
+			{
+				SUTransformation transformation = instance->Transformation->ToSU();
+				SUComponentInstanceSetTransform(ref, &transformation);
+			}
+
+			SUResult added = SUEntitiesAddInstance(entities, ref, nullptr);
+			if (added != SU_ERROR_NONE)
+			{
+				SUComponentInstanceRelease(&ref);
+				return (result != SU_ERROR_NONE) ? result : added;
+			}
+			SetElement(SUComponentInstanceToDrawingElement(ref), instance->Layer, instance->Material);
+			PlacementCount++;
+			return result;
+		}
+
+		SUResult AddInstances(SUEntitiesRef entities, InstanceSet^ set, SUResult result)
+		{
+			if (set->Definition == nullptr || set->Count == 0)
+				return result;
+
+			result = Definition(set->Definition, result);
+			IntPtr found;
+			if (!definitions->TryGetValue(set->Definition, found) || found == IntPtr::Zero)
+				return result;
+
+			SUComponentDefinitionRef definition = { found.ToPointer() };
+			SULayerRef layer = LayerRef(set->Layer);
+			SUMaterialRef material = MaterialRef(set->Material);
+
+			size_t placed = 0;
+			pin_ptr<double> transforms = &set->Transforms[0];
+			SUResult placing = PlaceInstances(definition, entities, transforms, (size_t)set->Count, layer, material, &placed);
+			PlacementCount += (int)placed;
+			return (result != SU_ERROR_NONE) ? result : placing;
+		}
+
+		// Creates the definition of a component once and fills its entities.
+		// A definition being filled is registered as zero, so instances of a component inside itself are skipped.
+		SUResult Definition(Component^ component, SUResult result)
+		{
+			if (definitions->ContainsKey(component))
+				return result;
+			definitions->Add(component, IntPtr::Zero);
+
+			SUComponentDefinitionRef ref = SU_INVALID;
+			SUComponentDefinitionCreate(&ref);
+			if (!String::IsNullOrEmpty(component->Name))
+				SUComponentDefinitionSetName(ref, Utilities::Utf8String(component->Name));
+			if (!String::IsNullOrEmpty(component->Description))
+				SUComponentDefinitionSetDescription(ref, Utilities::Utf8String(component->Description));
+
+			SUResult added = SUModelAddComponentDefinitions(*model, 1, &ref);
+			if (added != SU_ERROR_NONE)
+			{
+				SUComponentDefinitionRelease(&ref);
+				return (result != SU_ERROR_NONE) ? result : added;
+			}
+			DefinitionCount++;
+
+			SUEntitiesRef contents = SU_INVALID;
+			SUComponentDefinitionGetEntities(ref, &contents);
+			result = WriteEntities(contents, component->Surfaces, nullptr, component->Edges, component->Curves, component->Groups, component->Instances, result);
+			definitions[component] = IntPtr(ref.ptr);
+			return result;
+		}
+
+		void SetElement(SUDrawingElementRef element, String^ layer, SketchUpNET::Material^ material)
+		{
+			SULayerRef layerRef = LayerRef(layer);
+			if (!SUIsInvalid(layerRef))
+				SUDrawingElementSetLayer(element, layerRef);
+			SUMaterialRef materialRef = MaterialRef(material);
+			if (!SUIsInvalid(materialRef))
+				SUDrawingElementSetMaterial(element, materialRef);
+		}
+
+		void Begin(SUModelRef model)
+		{
+			FaceCount = 0;
+			EdgeCount = 0;
+			BatchCount = 0;
+			DefinitionCount = 0;
+			PlacementCount = 0;
+			definitions = gcnew Dictionary<Component^, IntPtr>();
+			byGuid = gcnew Dictionary<String^, Component^>();
+			batch = new WriterBatch();
+			batch->Tolerance = WeldTolerance * 39.3701;
+			this->model = new SUModelRef(model);
+			materials = gcnew Dictionary<String^, IntPtr>();
+			layers = gcnew Dictionary<String^, IntPtr>();
+
+			size_t count = 0;
+			SUModelGetNumMaterials(model, &count);
+			if (count > 0)
+			{
+				std::vector<SUMaterialRef> existing(count);
+				SUModelGetMaterials(model, count, &existing[0], &count);
+				for (size_t i = 0; i < count; i++)
+				{
+					Utilities::StringRef name;
+					SUMaterialGetName(existing[i], &name.Ref);
+					materials[name.Value()] = IntPtr(existing[i].ptr);
+				}
+			}
+
+			count = 0;
+			SUModelGetNumLayers(model, &count);
+			if (count > 0)
+			{
+				std::vector<SULayerRef> existing(count);
+				SUModelGetLayers(model, count, &existing[0], &count);
+				for (size_t i = 0; i < count; i++)
+					layers[Utilities::GetLayerName(existing[i])] = IntPtr(existing[i].ptr);
+			}
+		}
+
+		void End()
+		{
+			delete batch;
+			batch = nullptr;
+			delete model;
+			model = nullptr;
+			materials = nullptr;
+			layers = nullptr;
+			definitions = nullptr;
+			byGuid = nullptr;
+		}
+
+		SUResult Flush(SUEntitiesRef entities, SUResult previous)
+		{
+			bool filled = !batch->Faces.empty() || !batch->Edges.empty();
+			SUResult result = batch->Fill(entities);
+			if (filled)
+				BatchCount++;
+			return (previous != SU_ERROR_NONE) ? previous : result;
+		}
+
+		void AddSurface(Surface^ surface)
+		{
+			GeometryRange loops = { batch->Loops.size(), 0 };
+
+			if (surface->OuterEdges != nullptr && surface->OuterEdges->Edges != nullptr && surface->OuterEdges->Edges->Count > 0)
+			{
+				if (!batch->AddLoop(LoopPoints(surface->OuterEdges->Edges)))
+					return;
+			}
+			else
+			{
+				// Surfaces built from outer vertices only
+				std::vector<size_t> outer;
+				if (surface->Vertices != nullptr)
+					for each (Vertex^ vertex in surface->Vertices)
+						outer.push_back(batch->AddPoint(vertex->ToSU()));
+				if (!batch->AddLoop(outer))
+					return;
+			}
+
+			if (surface->InnerEdges != nullptr)
+				for each (Loop^ inner in surface->InnerEdges)
+					if (inner->Edges != nullptr && inner->Edges->Count > 0)
+						batch->AddLoop(LoopPoints(inner->Edges));
+
+			loops.Count = batch->Loops.size() - loops.Start;
+
+			WriterFace face;
+			face.Loops = loops;
+			face.SoftEdges = 0;
+			face.Front = MaterialRef(surface->FrontMaterial);
+			face.Back = MaterialRef(surface->BackMaterial);
+			face.Layer = LayerRef(surface->Layer);
+			batch->Faces.push_back(face);
+			FaceCount++;
+		}
+
+		void AddMesh(Mesh^ mesh)
+		{
+			int vertexCount = mesh->VertexCount;
+			int triangleCount = mesh->TriangleCount;
+			if (vertexCount == 0 || triangleCount == 0)
+				return;
+
+			array<double>^ positions = gcnew array<double>(3 * vertexCount);
+			array<unsigned int>^ indices = gcnew array<unsigned int>(3 * triangleCount);
+			mesh->CopyPositions(positions, 0);
+			mesh->CopyIndices(indices, 0, 0);
+
+			std::vector<size_t> welded(vertexCount);
+			{
+				pin_ptr<double> p = &positions[0];
+				for (int i = 0; i < vertexCount; i++)
+				{
+					SUPoint3D point = { p[3 * i] * 39.3701, p[3 * i + 1] * 39.3701, p[3 * i + 2] * 39.3701 };
+					welded[i] = batch->AddPoint(point);
+				}
+			}
+
+			pin_ptr<unsigned int> n = &indices[0];
+			std::vector<size_t> corners(3 * triangleCount);
+			for (int i = 0; i < 3 * triangleCount; i++)
+				corners[i] = (n[i] < (unsigned int)vertexCount) ? welded[n[i]] : SIZE_MAX;
+
+			// Uses of each welded edge by the triangles of this mesh
+			std::unordered_map<unsigned long long, int> uses;
+			if (SoftenInteriorEdges)
+				for (int t = 0; t < triangleCount; t++)
+					for (int e = 0; e < 3; e++)
+						uses[EdgeKey(corners[3 * t + e], corners[3 * t + (e + 1) % 3])]++;
+
+			SULayerRef layer = LayerRef(mesh->Layer);
+			SUMaterialRef none = SU_INVALID;
+			std::vector<size_t> loop(3);
+			for (int t = 0; t < triangleCount; t++)
+			{
+				size_t a = corners[3 * t], b = corners[3 * t + 1], c = corners[3 * t + 2];
+				if (a == SIZE_MAX || b == SIZE_MAX || c == SIZE_MAX || a == b || b == c || a == c)
+					continue;
+
+				loop[0] = a; loop[1] = b; loop[2] = c;
+				WriterFace face;
+				face.Loops.Start = batch->Loops.size();
+				face.Loops.Count = 1;
+				if (!batch->AddLoop(loop))
+					continue;
+
+				face.SoftEdges = 0;
+				if (SoftenInteriorEdges)
+					for (int e = 0; e < 3; e++)
+						if (uses[EdgeKey(loop[e], loop[(e + 1) % 3])] > 1)
+							face.SoftEdges |= 1u << e;
+				face.Front = none;
+				face.Back = none;
+				face.Layer = layer;
+				batch->Faces.push_back(face);
+				FaceCount++;
+			}
+		}
+
+		static unsigned long long EdgeKey(size_t a, size_t b)
+		{
+			return (a < b) ? ((unsigned long long)a << 32 | b) : ((unsigned long long)b << 32 | a);
+		}
+
+		void AddEdge(Edge^ edge)
+		{
+			WriterEdge e;
+			e.Start = batch->AddPoint(edge->Start->ToSU());
+			e.End = batch->AddPoint(edge->End->ToSU());
+			e.Layer = LayerRef(edge->Layer);
+			if (e.Start == e.End)
+				return;
+			batch->Edges.push_back(e);
+			EdgeCount++;
+		}
+
+		/// <summary>
+		/// Vertex indices along a loop. Stored edges keep their own direction, so each edge is followed
+		/// from the end it shares with the previous one.
+		/// </summary>
+		std::vector<size_t> LoopPoints(List<Edge^>^ edges)
+		{
+			int count = edges->Count;
+			std::vector<size_t> starts(count), ends(count);
+			for (int i = 0; i < count; i++)
+			{
+				starts[i] = batch->AddPoint(edges[i]->Start->ToSU());
+				ends[i] = batch->AddPoint(edges[i]->End->ToSU());
+			}
+
+			std::vector<size_t> points;
+			points.reserve(count);
+			size_t current = starts[0];
+			if (count > 1 && (ends[0] != starts[1] && ends[0] != ends[1]))
+				current = ends[0];
+
+			for (int i = 0; i < count; i++)
+			{
+				if (current == starts[i])
+				{
+					points.push_back(starts[i]);
+					current = ends[i];
+				}
+				else if (current == ends[i])
+				{
+					points.push_back(ends[i]);
+					current = starts[i];
+				}
+				else
+				{
+					// Not connected, keep the edge directions as given
+					points.push_back(starts[i]);
+					current = ends[i];
+				}
+			}
+			return points;
+		}
+
+		SUMaterialRef MaterialRef(SketchUpNET::Material^ material)
+		{
+			SUMaterialRef ref = SU_INVALID;
+			if (material == nullptr || String::IsNullOrEmpty(material->Name))
+				return ref;
+
+			IntPtr found;
+			if (!materials->TryGetValue(material->Name, found))
+			{
+				SUMaterialCreate(&ref);
+				SUMaterialSetName(ref, Utilities::Utf8String(material->Name));
+				if (material->Colour != nullptr)
+				{
+					SUColor color = material->Colour->ToSU();
+					SUMaterialSetColor(ref, &color);
+				}
+				if (material->UseOpacity)
+				{
+					SUMaterialSetUseOpacity(ref, true);
+					SUMaterialSetOpacity(ref, material->Opacity);
+				}
+				SUModelAddMaterials(*model, 1, &ref);
+				found = IntPtr(ref.ptr);
+				materials->Add(material->Name, found);
+			}
+			ref.ptr = found.ToPointer();
+			return ref;
+		}
+
+		SULayerRef LayerRef(String^ name)
+		{
+			SULayerRef ref = SU_INVALID;
+			if (String::IsNullOrEmpty(name))
+				return ref;
+
+			IntPtr found;
+			if (!layers->TryGetValue(name, found))
+			{
+				SULayerCreate(&ref);
+				SULayerSetName(ref, Utilities::Utf8String(name));
+				SUModelAddLayers(*model, 1, &ref);
+				found = IntPtr(ref.ptr);
+				layers->Add(name, found);
+			}
+			ref.ptr = found.ToPointer();
+			return ref;
+		}
+	};
+
+
+}
\ No newline at end of file
@@ -0,0 +1,903 @@
+/*
+
+SketchUpNET - a C++ Wrapper for the Trimble(R) SketchUp(R) C API
+Copyright(C) 2015, Autor: Maximilian Thumfart
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+#pragma once
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+#include <vector>
+#include "Utilities.h"
+#include "Vertex.h"
+#include "Vector.h"
+#include "Transform.h"
+#include "Surface.h"
+#include "Mesh.h"
+#include "InstanceTree.h"
+#include "BoundingVolumeHierarchy.h"
+
+using namespace System;
+using namespace System::Collections;
+using namespace System::Collections::Generic;
+
+namespace SketchUpNET
+{
+#pragma managed(push, off)
+	/// <summary>
+	/// Triangles of one list of surfaces in its own coordinates with their hierarchy
+	/// </summary>
+	struct RayBody
+	{
+		std::vector<double> Points;
+		std::vector<unsigned int> Indices;
+		// Surface of each triangle, index into the surface list of the body
+		std::vector<int> TriangleSurface;
+		// First triangle of each surface
+		std::vector<int> SurfaceTriangle;
+		Bvh Tree;
+
+		void SetBoxes()
+		{
+			size_t count = Indices.size() / 3;
+			Tree.Boxes.resize(6 * count);
+			for (size_t t = 0; t < count; t++)
+			{
+				double* box = &Tree.Boxes[6 * t];
+				const double* a = &Points[3 * Indices[3 * t]];
+				for (int k = 0; k < 3; k++)
+					box[k] = box[3 + k] = a[k];
+				for (int c = 1; c < 3; c++)
+				{
+					const double* p = &Points[3 * Indices[3 * t + c]];
+					for (int k = 0; k < 3; k++)
+					{
+						box[k] = (p[k] < box[k]) ? p[k] : box[k];
+						box[3 + k] = (p[k] > box[3 + k]) ? p[k] : box[3 + k];
+					}
+				}
+			}
+		}
+	};
+
+	/// <summary>
+	/// Placement of a body in the model
+	/// </summary>
+	struct RayInstance
+	{
+		int Body;
+		bool Identity;
+		// Affine model transformation and its inverse, four values per column
+		double World[16];
+		double Inverse[16];
+		// Lower bound of the model length of a unit length in body coordinates
+		double Scale;
+	};
+
+	/// <summary>
+	/// Closest hit of a ray or nearest point, Instance is -1 if nothing was found.
+	/// T is the ray distance or the distance to the query point.
+	/// </summary>
+	struct RayResult
+	{
+		double T;
+		double U;
+		double V;
+		int Instance;
+		int Triangle;
+		double Point[3];
+	};
+
+	/// <summary>
+	/// Pending node of a traversal with its entry distance
+	/// </summary>
+	struct RayEntry
+	{
+		int Node;
+		double T;
+	};
+
+	inline void AffinePoint(const double* m, const double* p, double* r)
+	{
+		for (int k = 0; k < 3; k++)
+			r[k] = m[k] * p[0] + m[4 + k] * p[1] + m[8 + k] * p[2] + m[12 + k];
+	}
+
+	inline void AffineVector(const double* m, const double* v, double* r)
+	{
+		for (int k = 0; k < 3; k++)
+			r[k] = m[k] * v[0] + m[4 + k] * v[1] + m[8 + k] * v[2];
+	}
+
+	// Entry distances of a ray into two boxes, tested together in the two lanes of an SSE2 register.
+	// DBL_MAX marks a miss.
+	inline void RayBoxes(const BvhNode& a, const BvhNode& b, const double* origin, const double* inverse, double tMax, double* t)
+	{
+		__m128d enter = _mm_setzero_pd();
+		__m128d leave = _mm_set1_pd(tMax);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			__m128d o = _mm_set1_pd(origin[axis]);
+			__m128d inv = _mm_set1_pd(inverse[axis]);
+			__m128d t0 = _mm_mul_pd(_mm_sub_pd(_mm_set_pd(b.Min[axis], a.Min[axis]), o), inv);
+			__m128d t1 = _mm_mul_pd(_mm_sub_pd(_mm_set_pd(b.Max[axis], a.Max[axis]), o), inv);
+			enter = _mm_max_pd(enter, _mm_min_pd(t0, t1));
+			leave = _mm_min_pd(leave, _mm_max_pd(t0, t1));
+		}
+		int hit = _mm_movemask_pd(_mm_cmple_pd(enter, leave));
+		double lanes[2];
+		_mm_storeu_pd(lanes, enter);
+		t[0] = (hit & 1) ? lanes[0] : DBL_MAX;
+		t[1] = (hit & 2) ? lanes[1] : DBL_MAX;
+	}
+
+	inline double BoxDistance2(const double* min, const double* max, const double* p)
+	{
+		double d2 = 0.0;
+		for (int k = 0; k < 3; k++)
+		{
+			double d = (p[k] < min[k]) ? min[k] - p[k] : ((p[k] > max[k]) ? p[k] - max[k] : 0.0);
+			d2 += d * d;
+		}
+		return d2;
+	}
+
+	// Moeller-Trumbore test of both sides of a triangle, u and v weight b and c
+	inline bool IntersectTriangle(const double* o, const double* d, const double* a, const double* b, const double* c, double& t, double& u, double& v)
+	{
+		double e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		double e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		double p[3] = { d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0] };
+		double det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+		if (det == 0.0) return false;
+
+		double inv = 1.0 / det;
+		double s[3] = { o[0] - a[0], o[1] - a[1], o[2] - a[2] };
+		u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inv;
+		if (u < 0.0 || u > 1.0) return false;
+
+		double q[3] = { s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0] };
+		v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * inv;
+		if (v < 0.0 || u + v > 1.0) return false;
+
+		t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv;
+		return true;
+	}
+
+	inline double Dot(const double* a, const double* b)
+	{
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	inline double Ratio(double n, double d)
+	{
+		return (d != 0.0) ? n / d : 0.0;
+	}
+
+	// Closest point of a triangle to p as weights u of b and v of c, after Ericson's region tests
+	inline void ClosestOnTriangle(const double* p, const double* a, const double* b, const double* c, double& u, double& v)
+	{
+		double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		double ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		double ap[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+		double d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+		if (d1 <= 0.0 && d2 <= 0.0) { u = 0.0; v = 0.0; return; }
+
+		double bp[3] = { p[0] - b[0], p[1] - b[1], p[2] - b[2] };
+		double d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+		if (d3 >= 0.0 && d4 <= d3) { u = 1.0; v = 0.0; return; }
+
+		double vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) { u = Ratio(d1, d1 - d3); v = 0.0; return; }
+
+		double cp[3] = { p[0] - c[0], p[1] - c[1], p[2] - c[2] };
+		double d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+		if (d6 >= 0.0 && d5 <= d6) { u = 0.0; v = 1.0; return; }
+
+		double vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) { u = 0.0; v = Ratio(d2, d2 - d6); return; }
+
+		double va = d3 * d6 - d5 * d4;
+		if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0)
+		{
+			double w = Ratio(d4 - d3, (d4 - d3) + (d5 - d6));
+			u = 1.0 - w;
+			v = w;
+			return;
+		}
+
+		double sum = va + vb + vc;
+		u = Ratio(vb, sum);
+		v = Ratio(vc, sum);
+	}
+
+	// Visits the leaf items of a hierarchy hit by a ray, nearest nodes first.
+	// The leaf may lower tMax, which prunes the remaining nodes.
+	template <typename Leaf>
+	inline void TraceBvh(const Bvh& tree, const double* origin, const double* inverse, const double& tMax, std::vector<RayEntry>& stack, Leaf leaf)
+	{
+		if (tree.Nodes.empty()) return;
+
+		double t[2];
+		RayBoxes(tree.Nodes[0], tree.Nodes[0], origin, inverse, tMax, t);
+		if (t[0] == DBL_MAX) return;
+
+		size_t base = stack.size();
+		RayEntry root = { 0, t[0] };
+		stack.push_back(root);
+		while (stack.size() > base)
+		{
+			RayEntry entry = stack.back();
+			stack.pop_back();
+			if (entry.T > tMax) continue;
+
+			const BvhNode& node = tree.Nodes[entry.Node];
+			if (node.Left < 0)
+			{
+				for (int i = node.Start; i < node.Start + node.Count; i++)
+					leaf(tree.Order[i]);
+				continue;
+			}
+
+			RayBoxes(tree.Nodes[node.Left], tree.Nodes[node.Right], origin, inverse, tMax, t);
+			RayEntry left = { node.Left, t[0] };
+			RayEntry right = { node.Right, t[1] };
+			bool leftFirst = t[0] <= t[1];
+			if (t[leftFirst ? 1 : 0] != DBL_MAX) stack.push_back(leftFirst ? right : left);
+			if (t[leftFirst ? 0 : 1] != DBL_MAX) stack.push_back(leftFirst ? left : right);
+		}
+	}
+
+	// Visits the leaf items of a hierarchy closer to p than the current best squared distance, nearest nodes first.
+	// Node distances are multiplied by scale to bound the distance in model coordinates.
+	template <typename Leaf>
+	inline void NearBvh(const Bvh& tree, const double* p, double scale, const double& best, std::vector<RayEntry>& stack, Leaf leaf)
+	{
+		if (tree.Nodes.empty()) return;
+
+		double s2 = scale * scale;
+		size_t base = stack.size();
+		RayEntry root = { 0, BoxDistance2(tree.Nodes[0].Min, tree.Nodes[0].Max, p) * s2 };
+		stack.push_back(root);
+		while (stack.size() > base)
+		{
+			RayEntry entry = stack.back();
+			stack.pop_back();
+			if (entry.T >= best) continue;
+
+			const BvhNode& node = tree.Nodes[entry.Node];
+			if (node.Left < 0)
+			{
+				for (int i = node.Start; i < node.Start + node.Count; i++)
+					leaf(tree.Order[i]);
+				continue;
+			}
+
+			const BvhNode& l = tree.Nodes[node.Left];
+			const BvhNode& r = tree.Nodes[node.Right];
+			RayEntry left = { node.Left, BoxDistance2(l.Min, l.Max, p) * s2 };
+			RayEntry right = { node.Right, BoxDistance2(r.Min, r.Max, p) * s2 };
+			if (left.T <= right.T) { stack.push_back(right); stack.push_back(left); }
+			else { stack.push_back(left); stack.push_back(right); }
+		}
+	}
+
+	/// <summary>
+	/// Instanced triangle hierarchies: one per body, one over the model bounds of all instances
+	/// </summary>
+	class RayScene
+	{
+	public:
+		std::vector<RayBody> Bodies;
+		std::vector<RayInstance> Instances;
+		Bvh Top;
+
+		// Sets the model bounds of the instances from the roots of their bodies
+		void SetBoxes()
+		{
+			Top.Boxes.resize(6 * Instances.size());
+			for (size_t i = 0; i < Instances.size(); i++)
+			{
+				double* box = &Top.Boxes[6 * i];
+				const RayInstance& instance = Instances[i];
+				const Bvh& tree = Bodies[instance.Body].Tree;
+				if (tree.Nodes.empty())
+				{
+					box[0] = box[1] = box[2] = 1.0;
+					box[3] = box[4] = box[5] = -1.0;
+					continue;
+				}
+
+				const BvhNode& root = tree.Nodes[0];
+				for (int c = 0; c < 8; c++)
+				{
+					double corner[3] = { (c & 1) ? root.Max[0] : root.Min[0], (c & 2) ? root.Max[1] : root.Min[1], (c & 4) ? root.Max[2] : root.Min[2] };
+					double p[3];
+					if (instance.Identity)
+						std::memcpy(p, corner, sizeof(p));
+					else
+						AffinePoint(instance.World, corner, p);
+					for (int k = 0; k < 3; k++)
+					{
+						box[k] = (c == 0 || p[k] < box[k]) ? p[k] : box[k];
+						box[3 + k] = (c == 0 || p[k] > box[3 + k]) ? p[k] : box[3 + k];
+					}
+				}
+			}
+		}
+
+		// Closest hit of a ray with a unit direction in (0, tMax]
+		bool Intersect(const double* origin, const double* direction, double tMax, RayResult& hit, std::vector<RayEntry>& stack) const
+		{
+			hit.T = tMax;
+			hit.Instance = -1;
+			hit.Triangle = -1;
+
+			double inverse[3] = { 1.0 / direction[0], 1.0 / direction[1], 1.0 / direction[2] };
+			TraceBvh(Top, origin, inverse, hit.T, stack, [&](int item)
+			{
+				const RayInstance& instance = Instances[item];
+				const RayBody& body = Bodies[instance.Body];
+
+				// The direction is not normalized in body coordinates, so distances along the ray stay in model units
+				double o[3], d[3];
+				if (instance.Identity)
+				{
+					std::memcpy(o, origin, sizeof(o));
+					std::memcpy(d, direction, sizeof(d));
+				}
+				else
+				{
+					AffinePoint(instance.Inverse, origin, o);
+					AffineVector(instance.Inverse, direction, d);
+				}
+				double inv[3] = { 1.0 / d[0], 1.0 / d[1], 1.0 / d[2] };
+
+				TraceBvh(body.Tree, o, inv, hit.T, stack, [&](int triangle)
+				{
+					const unsigned int* corners = &body.Indices[3 * triangle];
+					double t, u, v;
+					if (IntersectTriangle(o, d, &body.Points[3 * corners[0]], &body.Points[3 * corners[1]], &body.Points[3 * corners[2]], t, u, v)
+						&& t > 0.0 && t < hit.T)
+					{
+						hit.T = t;
+						hit.U = u;
+						hit.V = v;
+						hit.Instance = item;
+						hit.Triangle = triangle;
+					}
+				});
+			});
+
+			if (hit.Instance < 0) return false;
+			for (int k = 0; k < 3; k++)
+				hit.Point[k] = origin[k] + hit.T * direction[k];
+			return true;
+		}
+
+		// Closest point of the model within maxDistance of p
+		bool Nearest(const double* p, double maxDistance, RayResult& hit, std::vector<RayEntry>& stack) const
+		{
+			double best = (maxDistance < DBL_MAX) ? maxDistance * maxDistance : DBL_MAX;
+			hit.Instance = -1;
+			hit.Triangle = -1;
+
+			NearBvh(Top, p, 1.0, best, stack, [&](int item)
+			{
+				const RayInstance& instance = Instances[item];
+				const RayBody& body = Bodies[instance.Body];
+
+				double local[3];
+				if (instance.Identity)
+					std::memcpy(local, p, sizeof(local));
+				else
+					AffinePoint(instance.Inverse, p, local);
+
+				// Triangles are measured in model coordinates, which keeps the result exact under non uniform scaling
+				NearBvh(body.Tree, local, instance.Scale, best, stack, [&](int triangle)
+				{
+					double corners[9];
+					Corners(instance, body, triangle, corners);
+
+					double u, v;
+					ClosestOnTriangle(p, corners, corners + 3, corners + 6, u, v);
+					double q[3];
+					for (int k = 0; k < 3; k++)
+						q[k] = corners[k] + u * (corners[3 + k] - corners[k]) + v * (corners[6 + k] - corners[k]);
+					double d2 = (q[0] - p[0]) * (q[0] - p[0]) + (q[1] - p[1]) * (q[1] - p[1]) + (q[2] - p[2]) * (q[2] - p[2]);
+					if (d2 < best || (hit.Instance < 0 && d2 <= best))
+					{
+						best = d2;
+						hit.U = u;
+						hit.V = v;
+						hit.Instance = item;
+						hit.Triangle = triangle;
+						std::memcpy(hit.Point, q, sizeof(q));
+					}
+				});
+			});
+
+			if (hit.Instance < 0) return false;
+			hit.T = std::sqrt(best);
+			return true;
+		}
+
+		// Corners of a triangle in model coordinates
+		void Corners(const RayInstance& instance, const RayBody& body, int triangle, double* corners) const
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				const double* local = &body.Points[3 * body.Indices[3 * triangle + c]];
+				if (instance.Identity)
+					std::memcpy(corners + 3 * c, local, 3 * sizeof(double));
+				else
+					AffinePoint(instance.World, local, corners + 3 * c);
+			}
+		}
+
+		// Unit normal of a triangle in model coordinates following its winding
+		void Normal(int instance, int triangle, double* normal) const
+		{
+			const RayInstance& placed = Instances[instance];
+			double c[9];
+			Corners(placed, Bodies[placed.Body], triangle, c);
+			double e1[3] = { c[3] - c[0], c[4] - c[1], c[5] - c[2] };
+			double e2[3] = { c[6] - c[0], c[7] - c[1], c[8] - c[2] };
+			normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+			normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+			normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+			double length = std::sqrt(Dot(normal, normal));
+			if (length > 0.0)
+				for (int k = 0; k < 3; k++)
+					normal[k] /= length;
+		}
+	};
+#pragma managed(pop)
+
+	/// <summary>
+	/// Triangle of the model found by a ray or a nearest point query
+	/// </summary>
+	public ref class RayHit
+	{
+	public:
+		/// <summary>
+		/// Surface the triangle belongs to
+		/// </summary>
+		SketchUpNET::Surface^ Surface;
+
+		/// <summary>
+		/// Innermost group or component placement containing the surface, null for top level surfaces
+		/// </summary>
+		SketchUpNET::Placement^ Placement;
+
+		/// <summary>
+		/// Triangle of the surface mesh
+		/// </summary>
+		int Triangle;
+
+		/// <summary>
+		/// Barycentric weight of the second triangle corner
+		/// </summary>
+		double U;
+
+		/// <summary>
+		/// Barycentric weight of the third triangle corner, the first has 1 - U - V
+		/// </summary>
+		double V;
+
+		/// <summary>
+		/// Distance from the ray origin or the query point in meters
+		/// </summary>
+		double Distance;
+
+		/// <summary>
+		/// Point on the triangle in model coordinates
+		/// </summary>
+		Vertex^ Point;
+
+		/// <summary>
+		/// Unit normal of the triangle in model coordinates
+		/// </summary>
+		Vector^ Normal;
+
+		/// <summary>
+		/// Placements from the top level of the model down to Placement, empty for top level surfaces
+		/// </summary>
+		property List<SketchUpNET::Placement^>^ Path
+		{
+			List<SketchUpNET::Placement^>^ get()
+			{
+				List<SketchUpNET::Placement^>^ path = gcnew List<SketchUpNET::Placement^>();
+				for (SketchUpNET::Placement^ p = Placement; p != nullptr; p = (p->Parent < 0) ? nullptr : tree->Placements[p->Parent])
+					path->Insert(0, p);
+				return path;
+			}
+		}
+
+	internal:
+		InstanceTree^ tree;
+	};
+
+	/// <summary>
+	/// Ray casts and nearest point queries against the triangulated surfaces of a model.
+	/// Each distinct list of surfaces gets one triangle hierarchy in its own coordinates,
+	/// placements reference it with their world transformation like instances reference a definition.
+	/// Requires the model to be loaded with meshes.
+	/// </summary>
+	public ref class RayCaster
+	{
+	public:
+		/// <summary>
+		/// Number of distinct triangle hierarchies
+		/// </summary>
+		property int BodyCount { int get() { return (int)Scene->Bodies.size(); } }
+
+		/// <summary>
+		/// Number of placed bodies, the top level surfaces count as one
+		/// </summary>
+		property int InstanceCount { int get() { return (int)Scene->Instances.size(); } }
+
+		/// <summary>
+		/// Number of triangles in model coordinates, instanced triangles are counted per placement
+		/// </summary>
+		property long long TriangleCount
+		{
+			long long get()
+			{
+				long long count = 0;
+				for (size_t i = 0; i < Scene->Instances.size(); i++)
+					count += Scene->Bodies[Scene->Instances[i].Body].Indices.size() / 3;
+				return count;
+			}
+		}
+
+		/// <summary>
+		/// Builds the hierarchies of the top level surfaces and of every placement of an instance tree
+		/// </summary>
+		/// <param name="surfaces">Top level surfaces, may be null</param>
+		/// <param name="tree">Groups and instances, may be null</param>
+		/// <param name="singleThreaded">Build on the calling thread only</param>
+		static RayCaster^ Build(List<SketchUpNET::Surface^>^ surfaces, InstanceTree^ tree, bool singleThreaded)
+		{
+			RayCaster^ caster = gcnew RayCaster(tree);
+			if (surfaces != nullptr && surfaces->Count > 0)
+				caster->AddInstance(surfaces, nullptr);
+
+			if (tree != nullptr)
+				for each (SketchUpNET::Placement^ placement in tree->Placements)
+				{
+					List<SketchUpNET::Surface^>^ placed = placement->Surfaces;
+					if (placed != nullptr && placed->Count > 0)
+						caster->AddInstance(placed, placement);
+				}
+
+			// Small bodies are built one per task, large ones afterwards with their subtrees across the pool
+			caster->Scene->Bodies.resize(caster->bodies->Count);
+			BodyWorker^ worker = gcnew BodyWorker(caster);
+			Utilities::ForRange(0, caster->bodies->Count, 1, gcnew Action<Tuple<int, int>^>(worker, &BodyWorker::Fill), singleThreaded);
+			for (int i = 0; i < caster->bodies->Count; i++)
+			{
+				RayBody& body = caster->Scene->Bodies[i];
+				if (body.Tree.Nodes.empty() && !body.Indices.empty())
+					BoundingVolumeHierarchy::BvhBuilder::Run(&body.Tree, singleThreaded);
+			}
+
+			caster->Scene->SetBoxes();
+			BoundingVolumeHierarchy::BvhBuilder::Run(&caster->Scene->Top, singleThreaded);
+			return caster;
+		}
+
+		/// <summary>
+		/// Closest triangle hit by a ray
+		/// </summary>
+		/// <param name="origin">Ray origin in meters</param>
+		/// <param name="direction">Ray direction, does not need to be normalized</param>
+		/// <param name="maxDistance">Largest distance to report in meters</param>
+		/// <returns>The hit or null if the ray misses the model</returns>
+		RayHit^ Cast(Vertex^ origin, Vector^ direction, double maxDistance)
+		{
+			double o[3] = { origin->X, origin->Y, origin->Z };
+			double d[3] = { direction->X, direction->Y, direction->Z };
+			if (!Normalize(d))
+				throw gcnew ArgumentException("The direction must not be zero.", "direction");
+
+			std::vector<RayEntry> stack;
+			RayResult result;
+			if (!Scene->Intersect(o, d, maxDistance, result, stack))
+				return nullptr;
+			return ToHit(result);
+		}
+
+		RayHit^ Cast(Vertex^ origin, Vector^ direction)
+		{
+			return Cast(origin, direction, Double::MaxValue);
+		}
+
+		/// <summary>
+		/// Closest hits of a batch of rays, cast across the thread pool
+		/// </summary>
+		/// <param name="origins">Ray origins as packed xyz triples</param>
+		/// <param name="directions">Ray directions as packed xyz triples, rays with a zero direction miss</param>
+		/// <param name="maxDistance">Largest distance to report in meters</param>
+		/// <param name="singleThreaded">Cast on the calling thread only</param>
+		/// <returns>One hit per ray, null where the ray misses</returns>
+		array<RayHit^>^ Cast(array<double>^ origins, array<double>^ directions, double maxDistance, bool singleThreaded)
+		{
+			if (origins == nullptr || directions == nullptr || origins->Length != directions->Length || origins->Length % 3 != 0)
+				throw gcnew ArgumentException("Origins and directions must be xyz triples of the same length.");
+
+			array<RayHit^>^ hits = gcnew array<RayHit^>(origins->Length / 3);
+			QueryWorker^ worker = gcnew QueryWorker(this, origins, directions, maxDistance, hits);
+			Utilities::ForRange(0, hits->Length, 1024, gcnew Action<Tuple<int, int>^>(worker, &QueryWorker::Run), singleThreaded);
+			return hits;
+		}
+
+		/// <summary>
+		/// Closest point of the model
+		/// </summary>
+		/// <param name="point">Query point in meters</param>
+		/// <param name="maxDistance">Largest distance to report in meters</param>
+		/// <returns>The closest point or null if no triangle is within maxDistance</returns>
+		RayHit^ Nearest(Vertex^ point, double maxDistance)
+		{
+			double p[3] = { point->X, point->Y, point->Z };
+			std::vector<RayEntry> stack;
+			RayResult result;
+			if (!Scene->Nearest(p, maxDistance, result, stack))
+				return nullptr;
+			return ToHit(result);
+		}
+
+		RayHit^ Nearest(Vertex^ point)
+		{
+			return Nearest(point, Double::MaxValue);
+		}
+
+		/// <summary>
+		/// Closest points of the model to a batch of points, queried across the thread pool
+		/// </summary>
+		/// <param name="points">Query points as packed xyz triples</param>
+		/// <param name="maxDistance">Largest distance to report in meters</param>
+		/// <param name="singleThreaded">Query on the calling thread only</param>
+		/// <returns>One result per point, null where no triangle is within maxDistance</returns>
+		array<RayHit^>^ Nearest(array<double>^ points, double maxDistance, bool singleThreaded)
+		{
+			if (points == nullptr || points->Length % 3 != 0)
+				throw gcnew ArgumentException("Points must be xyz triples.", "points");
+
+			array<RayHit^>^ hits = gcnew array<RayHit^>(points->Length / 3);
+			QueryWorker^ worker = gcnew QueryWorker(this, points, nullptr, maxDistance, hits);
+			Utilities::ForRange(0, hits->Length, 256, gcnew Action<Tuple<int, int>^>(worker, &QueryWorker::Run), singleThreaded);
+			return hits;
+		}
+
+	internal:
+		RayScene* Scene;
+
+		RayCaster(InstanceTree^ tree)
+		{
+			Scene = new RayScene();
+			this->tree = tree;
+			bodies = gcnew List<List<SketchUpNET::Surface^>^>();
+			bodyIndices = gcnew Dictionary<List<SketchUpNET::Surface^>^, int>();
+			placements = gcnew List<SketchUpNET::Placement^>();
+		}
+
+		!RayCaster()
+		{
+			delete Scene;
+			Scene = nullptr;
+		}
+
+		static bool Normalize(double* d)
+		{
+			double length = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+			if (!(length > 0.0)) return false;
+			for (int k = 0; k < 3; k++)
+				d[k] /= length;
+			return true;
+		}
+
+		RayHit^ ToHit(const RayResult& result)
+		{
+			const RayInstance& instance = Scene->Instances[result.Instance];
+			const RayBody& body = Scene->Bodies[instance.Body];
+			int surface = body.TriangleSurface[result.Triangle];
+
+			double normal[3];
+			Scene->Normal(result.Instance, result.Triangle, normal);
+
+			RayHit^ hit = gcnew RayHit();
+			hit->tree = tree;
+			hit->Surface = bodies[instance.Body][surface];
+			hit->Placement = placements[result.Instance];
+			hit->Triangle = result.Triangle - body.SurfaceTriangle[surface];
+			hit->U = result.U;
+			hit->V = result.V;
+			hit->Distance = result.T;
+			hit->Point = gcnew Vertex(result.Point[0], result.Point[1], result.Point[2]);
+			hit->Normal = gcnew Vector(normal[0], normal[1], normal[2]);
+			return hit;
+		}
+
+	private:
+		InstanceTree^ tree;
+		List<List<SketchUpNET::Surface^>^>^ bodies;
+		Dictionary<List<SketchUpNET::Surface^>^, int>^ bodyIndices;
+		List<SketchUpNET::Placement^>^ placements;
+
+		void AddInstance(List<SketchUpNET::Surface^>^ surfaces, SketchUpNET::Placement^ placement)
+		{
+			RayInstance instance;
+			instance.Identity = true;
+			instance.Scale = 1.0;
+
+			if (placement != nullptr)
+			{
+				pin_ptr<double> m = &placement->World->Data[0];
+				double inverse[16];
+				if (!InvertTransform(m, inverse))
+					return;
+
+				TransformMatrix world(m);
+				TransformMatrix back(inverse);
+				std::memcpy(instance.World, world.Affine, sizeof(instance.World));
+				std::memcpy(instance.Inverse, back.Affine, sizeof(instance.Inverse));
+				instance.Identity = false;
+
+				// The spectral norm of the inverse is at most the root of its 1-norm times its infinity norm
+				double columns = 0.0, rows = 0.0;
+				for (int k = 0; k < 3; k++)
+				{
+					double column = 0.0, row = 0.0;
+					for (int j = 0; j < 3; j++)
+					{
+						column += Math::Abs(back.Affine[4 * k + j]);
+						row += Math::Abs(back.Affine[4 * j + k]);
+					}
+					columns = Math::Max(columns, column);
+					rows = Math::Max(rows, row);
+				}
+				instance.Scale = (columns * rows > 0.0) ? 1.0 / Math::Sqrt(columns * rows) : 0.0;
+			}
+
+			int body;
+			if (!bodyIndices->TryGetValue(surfaces, body))
+			{
+				body = bodies->Count;
+				bodies->Add(surfaces);
+				bodyIndices->Add(surfaces, body);
+			}
+			instance.Body = body;
+			Scene->Instances.push_back(instance);
+			placements->Add(placement);
+		}
+
+		/// <summary>
+		/// Copies the meshes of a range of bodies into their native triangles and builds the smaller hierarchies
+		/// </summary>
+		ref class BodyWorker
+		{
+		public:
+			BodyWorker(RayCaster^ caster)
+			{
+				this->caster = caster;
+			}
+
+			void Fill(Tuple<int, int>^ range)
+			{
+				for (int i = range->Item1; i < range->Item2; i++)
+				{
+					RayBody& body = caster->Scene->Bodies[i];
+					List<SketchUpNET::Surface^>^ surfaces = caster->bodies[i];
+
+					int vertices = 0, triangles = 0;
+					for each (SketchUpNET::Surface^ surface in surfaces)
+						if (surface->FaceMesh != nullptr)
+						{
+							vertices += surface->FaceMesh->VertexCount;
+							triangles += surface->FaceMesh->TriangleCount;
+						}
+
+					array<double>^ points = gcnew array<double>(3 * vertices);
+					array<unsigned int>^ indices = gcnew array<unsigned int>(3 * triangles);
+					body.SurfaceTriangle.resize(surfaces->Count);
+					body.TriangleSurface.resize(triangles);
+
+					int v = 0, t = 0;
+					for (int s = 0; s < surfaces->Count; s++)
+					{
+						body.SurfaceTriangle[s] = t;
+						Mesh^ mesh = surfaces[s]->FaceMesh;
+						if (mesh == nullptr) continue;
+
+						mesh->CopyPositions(points, 3 * v);
+						mesh->CopyIndices(indices, 3 * t, (unsigned int)v);
+						for (int k = 0; k < mesh->TriangleCount; k++)
+							body.TriangleSurface[t + k] = s;
+						v += mesh->VertexCount;
+						t += mesh->TriangleCount;
+					}
+
+					if (triangles == 0) continue;
+
+					pin_ptr<double> p = &points[0];
+					pin_ptr<unsigned int> n = &indices[0];
+					body.Points.assign(p, p + points->Length);
+					body.Indices.assign(n, n + indices->Length);
+					body.SetBoxes();
+
+					if (triangles < (1 << 16))
+						BoundingVolumeHierarchy::BvhBuilder::Run(&body.Tree, true);
+				}
+			}
+
+		private:
+			RayCaster^ caster;
+		};
+
+		/// <summary>
+		/// Runs the ray casts or, without directions, the nearest point queries of a range of a batch
+		/// </summary>
+		ref class QueryWorker
+		{
+		public:
+			QueryWorker(RayCaster^ caster, array<double>^ origins, array<double>^ directions, double maxDistance, array<RayHit^>^ hits)
+			{
+				this->caster = caster;
+				this->origins = origins;
+				this->directions = directions;
+				this->maxDistance = maxDistance;
+				this->hits = hits;
+			}
+
+			void Run(Tuple<int, int>^ range)
+			{
+				std::vector<RayEntry> stack;
+				stack.reserve(128);
+				RayResult result;
+
+				for (int i = range->Item1; i < range->Item2; i++)
+				{
+					double o[3] = { origins[3 * i], origins[3 * i + 1], origins[3 * i + 2] };
+					bool found;
+					if (directions == nullptr)
+						found = caster->Scene->Nearest(o, maxDistance, result, stack);
+					else
+					{
+						double d[3] = { directions[3 * i], directions[3 * i + 1], directions[3 * i + 2] };
+						found = Normalize(d) && caster->Scene->Intersect(o, d, maxDistance, result, stack);
+					}
+					if (found)
+						hits[i] = caster->ToHit(result);
+				}
+			}
+
+		private:
+			RayCaster^ caster;
+			array<double>^ origins;
+			array<double>^ directions;
+			double maxDistance;
+			array<RayHit^>^ hits;
+		};
+	};
+
+
+}
\ No newline at end of file
@@ -33,6 +33,8 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include <msclr/marshal.h>
 #include <vector>
 #include "Utilities.h"
+#include "GeometryStore.h"
+#include "LoadContext.h"
 #include "Surface.h"
 #include "Edge.h"
 #include "Curve.h"
@@ -40,6 +42,16 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include "Group.h"
 #include "Instance.h"
 #include "Component.h"
+#include "LoadOptions.h"
+#include "SketchUpSession.h"
+#include "MeshBatch.h"
+#include "InstanceTree.h"
+#include "BoundingVolumeHierarchy.h"
+#include "RayCaster.h"
+#include "ModelWriter.h"
+#include "InstanceSet.h"
+#include "GltfExporter.h"
+#include "ModelCache.h"
 
 using namespace System;
 using namespace System::Collections;
@@ -93,6 +105,11 @@ namespace SketchUpNET
 		/// </summary>
 		System::Collections::Generic::Dictionary<String^, Material^>^ Materials;
 
+		/// <summary>
+		/// Distinct images of the material textures, null unless loaded with LoadOptions.TextureImages
+		/// </summary>
+		System::Collections::Generic::List<TextureImage^>^ TextureImages;
+
 		/// <summary>
 		/// Containing Model Component Instances
 		/// </summary>
@@ -108,11 +125,48 @@ namespace SketchUpNET
 		/// </summary>
 		System::Collections::Generic::List<Edge^>^ Edges;
 
+		/// <summary>
+		/// Meshes written as welded polygon meshes by WriteNewModel and AppendToModel, not filled by LoadModel
+		/// </summary>
+		System::Collections::Generic::List<Mesh^>^ Meshes;
+
+		/// <summary>
+		/// Instances placed in bulk by PlaceInstances, written by WriteNewModel and AppendToModel
+		/// </summary>
+		System::Collections::Generic::List<InstanceSet^>^ InstanceSets;
+
+		/// <summary>
+		/// Native geometry of the loaded model, shared by all Surfaces, Edges and Meshes
+		/// </summary>
+		GeometryStore^ Geometry;
+
 		/// <summary>
 		/// Version of the loaded file is more recent than the SketchUp API
 		/// </summary>
 		bool MoreRecentFileVersion;
 
+		/// <summary>
+		/// GUID of the loaded model
+		/// </summary>
+		System::String^ ModelGuid;
+
+		/// <summary>
+		/// Convert loaded geometry on the calling thread only.
+		/// Use this for deterministic comparisons or when the thread pool is not available.
+		/// </summary>
+		bool SingleThreaded;
+
+		/// <summary>
+		/// Writer used by WriteNewModel and AppendToModel.
+		/// Set to null to add each face separately with SUEntitiesAddFaces.
+		/// </summary>
+		ModelWriter^ Writer;
+
+		SketchUp()
+		{
+			this->Writer = gcnew ModelWriter();
+		};
+
 		/// <summary>
 		/// Loads a SketchUp Model from filepath without loading Meshes.
 		/// Use this if you don't need meshed geometries.
@@ -130,119 +184,251 @@ namespace SketchUpNET
 		/// <param name="includeMeshes">Load model including meshed geometries</param>
 		bool LoadModel(System::String^ filename, bool includeMeshes)
 		{
-			const char* path = Utilities::ToString(filename);
+			return LoadModel(filename, includeMeshes, nullptr);
+		}
+
+		/// <summary>
+		/// Loads the parts of a SketchUp Model from filepath that pass the given filters.
+		/// Filtered entities are skipped before they are converted.
+		/// </summary>
+		/// <param name="filename">Path to .skp file</param>
+		/// <param name="includeMeshes">Load model including meshed geometries</param>
+		/// <param name="options">Layer, kind, visibility and region filters, null loads everything</param>
+		bool LoadModel(System::String^ filename, bool includeMeshes, LoadOptions^ options)
+		{
+			Utilities::Utf8String path(filename);
 
-			SUInitialize();
+			SketchUpSession::Enter();
 
 
 			SUModelRef model = SU_INVALID;
 			SUModelLoadStatus status;
-			SUModelCreateFromFileWithStatus(&model, path, &status);
-			
+			SUResult res = SUModelCreateFromFileWithStatus(&model, path, &status);
 
-			if (status == SUModelLoadStatus_Success_MoreRecent)
-				MoreRecentFileVersion = true;
-			else
-				MoreRecentFileVersion = false;
+			return Load(res, model, status, includeMeshes, options);
+		};
 
+		/// <summary>
+		/// Loads a SketchUp Model from the contents of a .skp file without loading Meshes.
+		/// </summary>
+		/// <param name="buffer">Contents of a .skp file</param>
+		bool LoadModel(array<Byte>^ buffer)
+		{
+			return LoadModel(buffer, false, nullptr);
+		}
 
-			Layers = gcnew System::Collections::Generic::List<Layer^>();
-			Groups = gcnew System::Collections::Generic::List<Group^>();
-			Components = gcnew System::Collections::Generic::Dictionary<String^,Component^>();
-			Materials = gcnew System::Collections::Generic::Dictionary<String^, Material^>();
+		/// <summary>
+		/// Loads a SketchUp Model from the contents of a .skp file. Optionally load meshed geometries.
+		/// </summary>
+		/// <param name="buffer">Contents of a .skp file</param>
+		/// <param name="includeMeshes">Load model including meshed geometries</param>
+		bool LoadModel(array<Byte>^ buffer, bool includeMeshes)
+		{
+			return LoadModel(buffer, includeMeshes, nullptr);
+		}
 
-			SUEntitiesRef entities = SU_INVALID;
-			SUModelGetEntities(model, &entities);
+		/// <summary>
+		/// Loads the parts of a SketchUp Model from the contents of a .skp file that pass the given filters.
+		/// Use this to load models received over the network without writing them to disk.
+		/// </summary>
+		/// <param name="buffer">Contents of a .skp file</param>
+		/// <param name="includeMeshes">Load model including meshed geometries</param>
+		/// <param name="options">Layer, kind, visibility and region filters, null loads everything</param>
+		bool LoadModel(array<Byte>^ buffer, bool includeMeshes, LoadOptions^ options)
+		{
+			if (buffer == nullptr || buffer->Length == 0) return false;
 
-			//Get All Materials
-			size_t matCount = 0;
-			SUModelGetNumMaterials(model, &matCount);
+			pin_ptr<Byte> data = &buffer[0];
+			return LoadBuffer(data, buffer->Length, includeMeshes, options);
+		}
 
-			if (matCount > 0) {
-				std::vector<SUMaterialRef> materials(matCount);
-				SUModelGetMaterials(model, matCount, &materials[0], &matCount);
+		/// <summary>
+		/// Loads the parts of a SketchUp Model from a memory-mapped view of a .skp file that pass the given filters.
+		/// Use this to keep frequently loaded files in the page cache.
+		/// </summary>
+		/// <param name="view">View starting at the contents of a .skp file</param>
+		/// <param name="length">Length of the .skp file, the view capacity is rounded up to whole pages</param>
+		/// <param name="includeMeshes">Load model including meshed geometries</param>
+		/// <param name="options">Layer, kind, visibility and region filters, null loads everything</param>
+		bool LoadModel(System::IO::MemoryMappedFiles::MemoryMappedViewAccessor^ view, long long length, bool includeMeshes, LoadOptions^ options)
+		{
+			if (view == nullptr || length <= 0 || length > view->Capacity) return false;
 
-				for (size_t i = 0; i < matCount; i++) {
-					Material^ mat = Material::FromSU(materials[i]);
-					if (!Materials->ContainsKey(mat->Name))
-						Materials->Add(mat->Name, mat);
-				}
+			Byte* data = nullptr;
+			view->SafeMemoryMappedViewHandle->AcquirePointer(data);
+			try
+			{
+				return LoadBuffer(data + view->PointerOffset, (size_t)length, includeMeshes, options);
 			}
-			
-			//Get All Layers
-			size_t layerCount = 0;
-			SUModelGetNumLayers(model, &layerCount);
+			finally
+			{
+				view->SafeMemoryMappedViewHandle->ReleasePointer();
+			}
+		}
 
-			if (layerCount > 0) {
-				std::vector<SULayerRef> layers(layerCount);
-				SUModelGetLayers(model, layerCount, &layers[0], &layerCount);
+		/// <summary>
+		/// Loads a SketchUp Model from filepath by mapping the file into memory instead of reading it.
+		/// </summary>
+		/// <param name="filename">Path to .skp file</param>
+		/// <param name="includeMeshes">Load model including meshed geometries</param>
+		bool LoadModelMapped(System::String^ filename, bool includeMeshes)
+		{
+			using namespace System::IO::MemoryMappedFiles;
 
-				for (size_t i = 0; i < layerCount; i++) {
-					Layer^ layer = Layer::FromSU(layers[i]);
-					Layers->Add(layer);
+			MemoryMappedFile^ file = MemoryMappedFile::CreateFromFile(filename, System::IO::FileMode::Open, nullptr, 0, MemoryMappedFileAccess::Read);
+			try
+			{
+				MemoryMappedViewAccessor^ view = file->CreateViewAccessor(0, 0, MemoryMappedFileAccess::Read);
+				try
+				{
+					return LoadModel(view, (gcnew System::IO::FileInfo(filename))->Length, includeMeshes, nullptr);
+				}
+				finally
+				{
+					delete view;
 				}
 			}
+			finally
+			{
+				delete file;
+			}
+		}
 
-			//Get All Groups	
-			size_t groupCount = 0;
-			SUEntitiesGetNumGroups(entities, &groupCount);
-
-			if (groupCount > 0) {
-				std::vector<SUGroupRef> groups(groupCount);
-				SUEntitiesGetGroups(entities, groupCount, &groups[0], &groupCount);
+		/// <summary>
+		/// Loads a SketchUp Model from filepath through a binary cache without loading Meshes.
+		/// </summary>
+		/// <param name="filename">Path to .skp file</param>
+		/// <param name="cache">Cache to read and write</param>
+		bool LoadModelCached(System::String^ filename, ModelCache^ cache)
+		{
+			return LoadModelCached(filename, false, nullptr, cache);
+		}
 
-				for (size_t i = 0; i < groupCount; i++) {
-					Group^ group = Group::FromSU(groups[i], includeMeshes, Materials);
-					Groups->Add(group);
-				}
+		/// <summary>
+		/// Loads a SketchUp Model from filepath through a binary cache. Optionally load meshed geometries.
+		/// </summary>
+		/// <param name="filename">Path to .skp file</param>
+		/// <param name="includeMeshes">Load model including meshed geometries</param>
+		/// <param name="cache">Cache to read and write</param>
+		bool LoadModelCached(System::String^ filename, bool includeMeshes, ModelCache^ cache)
+		{
+			return LoadModelCached(filename, includeMeshes, nullptr, cache);
+		}
 
+		/// <summary>
+		/// Loads a SketchUp Model from filepath through a binary cache. A cache file matching the path, size and
+		/// modification time of the .skp file is read without the SketchUp API, otherwise the model is loaded and
+		/// its cache file written. Loads with filters or texture images bypass the cache.
+		/// </summary>
+		/// <param name="filename">Path to .skp file</param>
+		/// <param name="includeMeshes">Load model including meshed geometries</param>
+		/// <param name="options">Load options, SharedTopology and TextureCoordinates are part of the cache key</param>
+		/// <param name="cache">Cache to read and write, Hit tells whether the model came from the cache</param>
+		bool LoadModelCached(System::String^ filename, bool includeMeshes, LoadOptions^ options, ModelCache^ cache)
+		{
+			System::IO::FileInfo^ source = gcnew System::IO::FileInfo(filename);
+			CachedModel^ cached = cache->Read(source, includeMeshes, options, SingleThreaded);
+			if (cached != nullptr)
+			{
+				Surfaces = cached->Surfaces;
+				Layers = cached->Layers;
+				Groups = cached->Groups;
+				Components = cached->Components;
+				Materials = cached->Materials;
+				TextureImages = nullptr;
+				Instances = cached->Instances;
+				Curves = cached->Curves;
+				Edges = cached->Edges;
+				Geometry = cached->Geometry;
+				ModelGuid = cached->ModelGuid;
+				MoreRecentFileVersion = cached->MoreRecentFileVersion;
+				return true;
 			}
 
+			if (!LoadModel(filename, includeMeshes, options))
+				return false;
+
+			CachedModel^ loaded = gcnew CachedModel();
+			loaded->Surfaces = Surfaces;
+			loaded->Layers = Layers;
+			loaded->Groups = Groups;
+			loaded->Components = Components;
+			loaded->Materials = Materials;
+			loaded->Instances = Instances;
+			loaded->Curves = Curves;
+			loaded->Edges = Edges;
+			loaded->Geometry = Geometry;
+			loaded->ModelGuid = ModelGuid;
+			loaded->MoreRecentFileVersion = MoreRecentFileVersion;
+			cache->Write(source, includeMeshes, options, loaded);
+			return true;
+		}
 
-			// Get all Components
-			size_t compCount = 0;
-			SUModelGetNumComponentDefinitions(model, &compCount);
-
-			if (compCount > 0) {
-				std::vector<SUComponentDefinitionRef> comps(compCount);
-				SUModelGetComponentDefinitions(model, compCount, &comps[0], &compCount);
+		/// <summary>
+		/// Merges the face meshes of the loaded model into one vertex and index buffer per material, layer or definition.
+		/// The model has to be loaded with meshes.
+		/// </summary>
+		/// <param name="groupBy">Batch key</param>
+		List<MeshBatch^>^ GetBatchedMeshes(BatchGrouping groupBy)
+		{
+			IEnumerable<Component^>^ components = (Components == nullptr) ? nullptr : Components->Values;
+			return MeshBatch::Build(Surfaces, Groups, Instances, components, groupBy, SingleThreaded);
+		}
 
-				for (size_t i = 0; i < compCount; i++) {
-					Component^ component = Component::FromSU(comps[i], includeMeshes, Materials);
-					Components->Add(component->Guid, component);
-				}
-			}
+		/// <summary>
+		/// Every group and component instance of the loaded model with its world transformation,
+		/// composed along the full nesting path
+		/// </summary>
+		InstanceTree^ GetInstanceTree()
+		{
+			return InstanceTree::Build(Groups, Instances);
+		}
 
-			Surfaces = Surface::GetEntitySurfaces(entities, includeMeshes, Materials);
-			Curves = Curve::GetEntityCurves(entities);
-			Edges = Edge::GetEntityEdges(entities);
-			Instances = Instance::GetEntityInstances(entities, Materials);
+		/// <summary>
+		/// Bounding volume hierarchy over the top level surfaces and every placement of the instance tree
+		/// in model coordinates. Items are the Surface and Placement objects.
+		/// </summary>
+		BoundingVolumeHierarchy^ GetBoundingVolumeHierarchy()
+		{
+			List<Object^>^ items = gcnew List<Object^>();
+			List<BoundingBox^>^ boxes = gcnew List<BoundingBox^>();
 
-			for each (Instance^ var in Instances)
-			{
-				if (Components->ContainsKey(var->ParentID))
+			if (Surfaces != nullptr)
+				for each (Surface^ surface in Surfaces)
 				{
-					System::Object^ o = Components[var->ParentID];
-					var->Parent = o;
+					items->Add(surface);
+					boxes->Add(surface->Bounds);
 				}
-			}
-
-			for each (KeyValuePair<String^, Component^>^ cmp in Components)
-			{
-				FixRefs(cmp->Value);
-			}
 
-			for each (Group^ var in Groups)
+			for each (Placement^ placement in GetInstanceTree()->Placements)
 			{
-				FixRefs(var);
+				items->Add(placement);
+				boxes->Add(placement->Bounds);
 			}
 
+			return BoundingVolumeHierarchy::Build(items, boxes, SingleThreaded);
+		}
 
-			SUModelRelease(&model);
-			SUTerminate();
-			return true;
+		/// <summary>
+		/// Ray casts and nearest point queries against the triangulated model.
+		/// Requires the model to be loaded with meshes; surfaces without a mesh are not hit.
+		/// </summary>
+		RayCaster^ GetRayCaster()
+		{
+			return RayCaster::Build(Surfaces, GetInstanceTree(), SingleThreaded);
+		}
 
-		};
+		/// <summary>
+		/// Exports the loaded model as binary glTF 2.0. Requires the model to be loaded with meshes.
+		/// </summary>
+		/// <param name="path">Path to .glb file</param>
+		/// <returns>The exporter with the statistics of the export</returns>
+		GltfExporter^ ExportGlb(System::String^ path)
+		{
+			GltfExporter^ exporter = gcnew GltfExporter();
+			exporter->Write(path, Surfaces, Groups, Instances);
+			return exporter;
+		}
 
 		/// <summary>
 		/// Saves a SketchUp Model from filepath to a new file.
@@ -253,8 +439,8 @@ namespace SketchUpNET
 		/// <param name="newFilename">Path to new .skp file</param>
 		bool SaveAs(System::String^ filename, SKPVersion version, System::String^ newFilename)
 		{
-			const char* path = Utilities::ToString(filename);
-			SUInitialize();
+			Utilities::Utf8String path(filename);
+			SketchUpSession::Enter();
 
 			SUModelRef model = SU_INVALID;
 			SUModelLoadStatus status;
@@ -267,10 +453,10 @@ namespace SketchUpNET
 
 			SUModelVersion saveversion = ToSUVersion(version);
 
-			SUModelSaveToFileWithVersion(model, Utilities::ToString(newFilename), saveversion);
+			SUModelSaveToFileWithVersion(model, Utilities::Utf8String(newFilename), saveversion);
 
 			SUModelRelease(&model);
-			SUTerminate();
+			SketchUpSession::Leave();
 			return true;
 		}
 
@@ -280,9 +466,9 @@ namespace SketchUpNET
 		/// <param name="filename">Path to .skp file</param>
 		bool AppendToModel(System::String^ filename)
 		{
-			const char* path = Utilities::ToString(filename);
+			Utilities::Utf8String path(filename);
 
-			SUInitialize();
+			SketchUpSession::Enter();
 
 
 			SUModelRef model = SU_INVALID;
@@ -299,18 +485,34 @@ namespace SketchUpNET
 			SUEntitiesRef entities = SU_INVALID;
 			SUModelGetEntities(model, &entities);
 
-			SUEntitiesAddFaces(entities, Surfaces->Count, Surface::ListToSU(Surfaces));
-			SUEntitiesAddEdges(entities, Edges->Count, Edge::ListToSU(Edges));
-			SUEntitiesAddCurves(entities, Curves->Count, Curve::ListToSU(Curves));
+			AddGeometry(model, entities);
 
-			SUModelSaveToFile(model, Utilities::ToString(filename));
+			SUModelSaveToFile(model, path);
 			
 			SUModelRelease(&model);
-			SUTerminate();
+			SketchUpSession::Leave();
 			return true;
 
 		};
 
+		/// <summary>
+		/// Places instances of a definition from packed transforms, written with the model by WriteNewModel and AppendToModel.
+		/// The transforms are converted to SketchUp units in one native loop, without an Instance per placement.
+		/// </summary>
+		/// <param name="definition">Definition to place, created in the written model on first use</param>
+		/// <param name="transforms">Row major 3x4 transforms in meters, twelve values per instance. The array is read when the model is written.</param>
+		/// <param name="layer">Layername</param>
+		/// <param name="material">Material of the instances or null</param>
+		/// <returns>The placed set</returns>
+		InstanceSet^ PlaceInstances(Component^ definition, array<double>^ transforms, System::String^ layer, SketchUpNET::Material^ material)
+		{
+			InstanceSet^ set = gcnew InstanceSet(definition, transforms, layer, material);
+			if (InstanceSets == nullptr)
+				InstanceSets = gcnew System::Collections::Generic::List<InstanceSet^>();
+			InstanceSets->Add(set);
+			return set;
+		}
+
 		/// <summary>
 		/// Write current SketchUp Model to a new SketchUp file using the latest version.
 		/// </summary>
@@ -329,30 +531,160 @@ namespace SketchUpNET
 		/// <returns></returns>
 		bool WriteNewModel(System::String^ filename, SketchUpNET::SKPVersion version)
 		{
-			SUInitialize();
+			SketchUpSession::Enter();
 			SUModelRef model = SU_INVALID;
 			SUResult res = SUModelCreate(&model);
 
-			if (res != SU_ERROR_NONE) return false;
+			if (res != SU_ERROR_NONE)
+			{
+				SketchUpSession::Leave();
+				return false;
+			}
 
 
 			SUEntitiesRef entities = SU_INVALID;
 			SUModelGetEntities(model, &entities);
 
-			SUEntitiesAddFaces(entities, Surfaces->Count, Surface::ListToSU(Surfaces));
-			SUEntitiesAddEdges(entities, Edges->Count, Edge::ListToSU(Edges));
-			SUEntitiesAddCurves(entities, Curves->Count, Curve::ListToSU(Curves));
+			AddGeometry(model, entities);
 			
 			SUModelVersion v = ToSUVersion(version);
-			SUModelSaveToFileWithVersion(model, Utilities::ToString(filename), v);
+			SUModelSaveToFileWithVersion(model, Utilities::Utf8String(filename), v);
 			SUModelRelease(&model);
-			SUTerminate();
+			SketchUpSession::Leave();
 
 			return true;
 		}
 
 		private:
 
+			void AddGeometry(SUModelRef model, SUEntitiesRef entities)
+			{
+				IEnumerable<Component^>^ components = (Components == nullptr) ? nullptr : Components->Values;
+				if (Writer != nullptr)
+				{
+					Writer->Write(model, entities, Surfaces, Meshes, Edges, Curves, Groups, Instances, components, InstanceSets);
+					return;
+				}
+
+				SUEntitiesAddFaces(entities, Surfaces->Count, Surface::ListToSU(Surfaces));
+				SUEntitiesAddEdges(entities, Edges->Count, Edge::ListToSU(Edges));
+				SUEntitiesAddCurves(entities, Curves->Count, Curve::ListToSU(Curves));
+
+				// Meshes, groups and components have no entity by entity path
+				(gcnew ModelWriter())->Write(model, entities, nullptr, Meshes, nullptr, nullptr, Groups, Instances, components, InstanceSets);
+			}
+
+			bool LoadBuffer(const unsigned char* data, size_t size, bool includeMeshes, LoadOptions^ options)
+			{
+				SketchUpSession::Enter();
+
+				SUModelRef model = SU_INVALID;
+				SUModelLoadStatus status;
+				SUResult res = SUModelCreateFromBufferWithStatus(&model, data, size, &status);
+
+				return Load(res, model, status, includeMeshes, options);
+			}
+
+			/// <summary>
+			/// Shared load path of all sources: extracts the opened model, releases it and converts the extracted data
+			/// </summary>
+			bool Load(SUResult created, SUModelRef model, SUModelLoadStatus status, bool includeMeshes, LoadOptions^ options)
+			{
+				if (created != SU_ERROR_NONE)
+				{
+					SketchUpSession::Leave();
+					return false;
+				}
+
+				if (status == SUModelLoadStatus_Success_MoreRecent)
+					MoreRecentFileVersion = true;
+				else
+					MoreRecentFileVersion = false;
+
+				LoadContext^ context = nullptr;
+				try
+				{
+					{
+						Utilities::StringRef guid;
+						SUModelGetGuid(model, &guid.Ref);
+						ModelGuid = guid.Value();
+					}
+
+					Components = gcnew System::Collections::Generic::Dictionary<String^,Component^>();
+					Materials = Material::GetModelMaterials(model);
+					Layers = Layer::GetModelLayers(model);
+					TextureImages = nullptr;
+					if (options != nullptr && options->TextureImages)
+					{
+						TextureImages = TextureImage::Collect(model, SingleThreaded);
+						Material::AttachImages(Materials, TextureImages);
+					}
+					Geometry = gcnew GeometryStore(options);
+					context = gcnew LoadContext(includeMeshes, Materials, Geometry);
+					context->SingleThreaded = SingleThreaded;
+					context->SetFilter(model, options);
+
+					SUEntitiesRef entities = SU_INVALID;
+					SUModelGetEntities(model, &entities);
+
+					//Get All Groups	
+					Groups = Group::GetEntityGroups(entities, context);
+
+
+					// Get all Components
+					size_t compCount = 0;
+					if (options == nullptr || (options->Kinds & EntityKinds::Components) != EntityKinds::None)
+						SUModelGetNumComponentDefinitions(model, &compCount);
+
+					if (compCount > 0) {
+						std::vector<SUComponentDefinitionRef> comps(compCount);
+						SUModelGetComponentDefinitions(model, compCount, &comps[0], &compCount);
+
+						for (size_t i = 0; i < compCount; i++) {
+							Component^ component = Component::FromSU(comps[i], context);
+							Components->Add(component->Guid, component);
+						}
+					}
+
+					Surfaces = Surface::GetEntitySurfaces(entities, context);
+					Curves = Curve::GetEntityCurves(entities, context);
+					Edges = Edge::GetEntityEdges(entities, context);
+					Instances = Instance::GetEntityInstances(entities, context);
+
+					// Definitions left out of Components by the kind filter are still converted for the instances placing them,
+					// including instances inside the definitions converted here
+					for (int i = 0; i < context->Instances->Count; i++)
+					{
+						IntPtr key = context->Instances[i]->Definition;
+						if (!context->Definitions->ContainsKey(key))
+						{
+							SUComponentDefinitionRef definition = { key.ToPointer() };
+							Component::FromSU(definition, context);
+						}
+					}
+				}
+				finally
+				{
+					// The model is released and the session left even if the extraction throws
+					if (context != nullptr)
+						context->CloseModel();
+					SUModelRelease(&model);
+					SketchUpSession::Leave();
+				}
+
+				// Everything below works on extracted data only and may run in parallel
+				try
+				{
+					Component::Convert(context);
+				}
+				finally
+				{
+					delete context;
+				}
+
+				return true;
+			}
+
 			SUModelVersion ToSUVersion(SketchUpNET::SKPVersion version) {
 				switch (version) {
 				case SketchUpNET::SKPVersion::V2013:
@@ -378,35 +710,6 @@ namespace SketchUpNET
 				}
 			}
 
-			void FixRefs(Component^ comp)
-			{
-				for each (Instance^ var in comp->Instances)
-				{
-					if (Components->ContainsKey(var->ParentID))
-					{
-						System::Object^ o = Components[var->ParentID];
-						var->Parent = o;
-
-						FixRefs(Components[var->ParentID]);
-					}
-				}
-			}
-
-			void FixRefs(Group^ comp)
-			{
-				for each (Instance^ var in comp->Instances)
-				{
-					if (Components->ContainsKey(var->ParentID))
-					{
-						System::Object^ o = Components[var->ParentID];
-						var->Parent = o;
-
-						FixRefs(Components[var->ParentID]);
-					}
-				}
-			}
-
-
 	};
 
 
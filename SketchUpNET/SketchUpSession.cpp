@@ -0,0 +1,104 @@
+/*
+
+SketchUpNET - a C++ Wrapper for the Trimble(R) SketchUp(R) C API
+Copyright(C) 2015, Autor: Maximilian Thumfart
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <SketchUpAPI/slapi.h>
+#include <SketchUpAPI/initialize.h>
+
+using namespace System;
+using namespace System::Threading;
+
+namespace SketchUpNET
+{
+	/// <summary>
+	/// Keeps the SketchUp API initialized while it is open.
+	/// Every load and save initializes and terminates the API unless a session is open,
+	/// a session keeps it initialized across all operations of a batch job:
+	/// <code>using (new SketchUpSession()) { ... }</code>
+	/// Sessions are reference counted per process and may be opened from any thread.
+	/// </summary>
+	public ref class SketchUpSession sealed
+	{
+	public:
+		SketchUpSession()
+		{
+			Enter();
+			open = true;
+		}
+
+		~SketchUpSession()
+		{
+			if (!open) return;
+			open = false;
+			Leave();
+		}
+
+		/// <summary>
+		/// The SketchUp API is currently initialized by an open session or a running operation
+		/// </summary>
+		static property bool IsActive
+		{
+			bool get() { return count > 0; }
+		}
+
+	internal:
+		/// <summary>
+		/// Initializes the SketchUp API for the first user in the process
+		/// </summary>
+		static void Enter()
+		{
+			Monitor::Enter(sync);
+			try
+			{
+				if (count++ == 0)
+					SUInitialize();
+			}
+			finally
+			{
+				Monitor::Exit(sync);
+			}
+		}
+
+		/// <summary>
+		/// Terminates the SketchUp API when its last user leaves
+		/// </summary>
+		static void Leave()
+		{
+			Monitor::Enter(sync);
+			try
+			{
+				if (count > 0 && --count == 0)
+					SUTerminate();
+			}
+			finally
+			{
+				Monitor::Exit(sync);
+			}
+		}
+
+	private:
+		bool open;
+
+		static Object^ sync = gcnew Object();
+		static int count = 0;
+	};
+}
\ No newline at end of file
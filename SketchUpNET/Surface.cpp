@@ -34,12 +34,16 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include <SketchUpAPI/model/mesh_helper.h>
 #include <msclr/marshal.h>
 #include <vector>
+#include <cstdint>
 #include "loop.h"
 #include "vertex.h"
 #include "vector.h"
 #include "utilities.h"
 #include "Mesh.h"
 #include "Material.h"
+#include "GeometryStore.h"
+#include "BoundingBox.h"
+#include "LoadContext.h"
 
 using namespace System;
 using namespace System::Collections;
@@ -53,17 +57,76 @@ namespace SketchUpNET
 		/// <summary>
 		/// The outer edges of the surface in a closed loop
 		/// </summary>
-		Loop^ OuterEdges;
+		property Loop^ OuterEdges
+		{
+			Loop^ get()
+			{
+				if (outerEdges == nullptr && store != nullptr)
+					outerEdges = gcnew Loop(store, store->Buffer->FaceLoops[index].Start);
+				return outerEdges;
+			}
+			void set(Loop^ value) { outerEdges = value; }
+		}
 
 		/// <summary>
 		/// List of closed inner loops, representing holes
 		/// </summary>
-		List<Loop^>^ InnerEdges;
+		property List<Loop^>^ InnerEdges
+		{
+			List<Loop^>^ get()
+			{
+				if (innerEdges == nullptr && store != nullptr)
+				{
+					GeometryRange range = store->Buffer->FaceLoops[index];
+					innerEdges = gcnew List<Loop^>((int)range.Count - 1);
+					for (size_t i = range.Start + 1; i < range.Start + range.Count; i++)
+						innerEdges->Add(gcnew Loop(store, i));
+				}
+				return innerEdges;
+			}
+			void set(List<Loop^>^ value) { innerEdges = value; }
+		}
 
 		/// <summary>
 		/// All vertices of the surfaces are stored here
 		/// </summary>
-		List<Vertex^>^ Vertices;
+		property List<Vertex^>^ Vertices
+		{
+			List<Vertex^>^ get()
+			{
+				if (vertices == nullptr && store != nullptr)
+					vertices = store->GetFaceVertices(index);
+				return vertices;
+			}
+			void set(List<Vertex^>^ value) { vertices = value; }
+		}
+
+		/// <summary>
+		/// Axis aligned bounds of the surface, captured when the model is loaded
+		/// </summary>
+		property BoundingBox^ Bounds
+		{
+			BoundingBox^ get()
+			{
+				if (bounds == nullptr)
+				{
+					if (store != nullptr && vertices == nullptr)
+						bounds = store->GetFaceBounds(index);
+					else if (Vertices != nullptr && Vertices->Count > 0)
+						bounds = BoundingBox::FromPoints(Vertices);
+					else if (OuterEdges != nullptr)
+					{
+						List<Vertex^>^ corners = gcnew List<Vertex^>();
+						for each (Edge^ edge in OuterEdges->Edges)
+							corners->Add(edge->Start);
+						bounds = BoundingBox::FromPoints(corners);
+					}
+					else
+						bounds = gcnew BoundingBox();
+				}
+				return bounds;
+			}
+		}
 
 		/// <summary>
 		/// Meshed surface if read meshes has been activated when opening the model
@@ -135,6 +198,44 @@ namespace SketchUpNET
 
 	internal:
 
+		/// <summary>
+		/// Index of the stored face viewed by this surface, -1 for surfaces created from edges
+		/// </summary>
+		property long long StoreIndex
+		{
+			long long get() { return (store == nullptr) ? -1 : (long long)index; }
+		}
+
+		/// <summary>
+		/// Writes min xyz and max xyz without creating vertices
+		/// </summary>
+		void CopyBounds(double* target)
+		{
+			if (bounds == nullptr && store != nullptr && vertices == nullptr)
+			{
+				const double* box = store->Buffer->FaceBounds.data() + 6 * index;
+				for (int i = 0; i < 6; i++)
+					target[i] = box[i];
+				return;
+			}
+			Bounds->CopyTo(target);
+		}
+
+		/// <summary>
+		/// Creates a surface view on a stored face
+		/// </summary>
+		Surface(GeometryStore^ store, size_t index, Vector^ normal, double area, Mesh^ m, System::String^ layername, Material^ backmat, Material^ frontmat)
+		{
+			this->store = store;
+			this->index = index;
+			this->Normal = normal;
+			this->FaceMesh = m;
+			this->BackMaterial = backmat;
+			this->FrontMaterial = frontmat;
+			this->Area = area;
+			this->Layer = layername;
+		};
+
 		static Vertex^ GetCentroid(List<Vertex^>^ vertices, int vertexCount)
 		{
 			Vertex^ centroid = gcnew Vertex(0, 0, vertices[0]->Z);
@@ -232,109 +333,150 @@ namespace SketchUpNET
 			return result;
 		}
 
-		static Surface^ FromSU(SUFaceRef face, bool includeMeshes, System::Collections::Generic::Dictionary<String^, Material^>^ materials)
+		/// <summary>
+		/// Copies a face from the SketchUp API into the load context.
+		/// The Surface is created in the conversion phase by SurfaceBuilder.
+		/// </summary>
+		static void Extract(SUFaceRef face, LoadContext^ context)
 		{
-			List<Loop^>^ inner = gcnew List<Loop^>();
-			
-			SULoopRef outer = SU_INVALID;
-			SUFaceGetOuterLoop(face, &outer);
-			
-			size_t edgeCount = 0;
-			SUFaceGetNumInnerLoops(face, &edgeCount);
-			if (edgeCount > 0)
-			{
-				std::vector<SULoopRef> loops(edgeCount);
-				SUFaceGetInnerLoops(face, edgeCount, &loops[0], &edgeCount);
-			
-				for (size_t j = 0; j < edgeCount; j++)
-				{
-					inner->Add(Loop::FromSU(loops[j]));
-				}
-			}
+			GeometryStore^ store = context->Store;
 
+			SurfaceRecord record;
+			record.Face = store->AddFace(face);
+			record.Mesh = (context->IncludeMeshes) ? store->AddMesh(face, context->TextureWriter) : SIZE_MAX;
 
 			SUVector3D vector = SU_INVALID;
 			SUFaceGetNormal(face, &vector);
-			Vector^ normal = Vector::FromSU(vector);
+			record.Normal = vector;
 
 			double area = 0;
 			SUFaceGetArea(face, &area);
+			record.Area = area;
 
 			// Layer
 			SULayerRef layer = SU_INVALID;
 			SUDrawingElementGetLayer(SUFaceToDrawingElement(face),&layer);
-			
-			System::String^ layername = gcnew System::String("");
-			if (!SUIsInvalid(layer))
-			{
-				layername = Utilities::GetLayerName(layer);
-			}
-				
-			
-			List<Vertex^>^ vertices = gcnew List<Vertex^>();
-
-			size_t verticesCount = 0;
-			SUFaceGetNumVertices(face, &verticesCount);
-			if (verticesCount > 0)
-			{
-				std::vector<SUVertexRef> vs(verticesCount);
-				SUFaceGetVertices(face, verticesCount, &vs[0], &verticesCount);
-				
-				for (size_t j = 0; j < verticesCount; j++)
-				{
-					SUPoint3D pt = SU_INVALID;
-					SUVertexGetPosition(vs[j], &pt);
-					vertices->Add(Vertex::FromSU(pt));
-				}
-			}
-
-			Mesh^ m = (includeMeshes)? Mesh::FromSU(face) : nullptr;
+			record.Layer = store->InternLayer(layer);
 
 			SUMaterialRef mback = SU_INVALID;
 			SUFaceGetBackMaterial(face, &mback);
-			SUStringRef mbackNameRef = SU_INVALID;
-			SUStringCreate(&mbackNameRef);
-			SUMaterialGetName(mback, &mbackNameRef);
-			System::String^ mbackName = SketchUpNET::Utilities::GetString(mbackNameRef);
+			Material^ backMat = Material::FromSU(mback, context);
 
 			SUMaterialRef minner = SU_INVALID;
 			SUFaceGetFrontMaterial(face, &minner);
-			SUStringRef minnerNameRef = SU_INVALID;
-			SUStringCreate(&minnerNameRef);
-			SUMaterialGetName(minner, &minnerNameRef);
-			
-			System::String^ minnerName = SketchUpNET::Utilities::GetString(minnerNameRef);
+			Material^ frontMat = Material::FromSU(minner, context);
+
+			context->Surfaces->push_back(record);
+			context->BackMaterials->Add(backMat);
+			context->FrontMaterials->Add(frontMat);
+		}
+
+		/// <summary>
+		/// Creates the Surface of an extracted face record.
+		/// Does not call the SketchUp API and is safe to run in parallel.
+		/// </summary>
+		static Surface^ FromRecord(LoadContext^ context, int i)
+		{
+			SurfaceRecord& record = (*context->Surfaces)[i];
+			System::String^ layername = context->Store->LayerNames[record.Layer];
 
-			Material^ backMat = (materials->ContainsKey(mbackName)) ? materials[mbackName] : Material::FromSU(mback);
-			Material^ frontMat = (materials->ContainsKey(minnerName)) ? materials[minnerName] : Material::FromSU(minner);
+			Mesh^ m = (record.Mesh != SIZE_MAX) ? gcnew Mesh(context->Store, record.Mesh, layername) : nullptr;
 
-			Surface^ v = gcnew Surface(Loop::FromSU(outer), inner, normal, area, vertices,m, layername, backMat, frontMat);
+			Surface^ v = gcnew Surface(context->Store, record.Face, Vector::FromSU(record.Normal), record.Area, m, layername, context->BackMaterials[i], context->FrontMaterials[i]);
 
 			return v;
 		}
 
-
-		static List<Surface^>^ GetEntitySurfaces(SUEntitiesRef entities, bool includeMeshes, System::Collections::Generic::Dictionary<String^, Material^>^ materials)
+		/// <summary>
+		/// Extracts all faces of an entities collection.
+		/// The returned list is filled in the conversion phase by SurfaceBuilder.
+		/// </summary>
+		static List<Surface^>^ GetEntitySurfaces(SUEntitiesRef entities, LoadContext^ context)
 		{
 			List<Surface^>^ surfaces = gcnew List<Surface^>();
 
 			size_t faceCount = 0;
 			SUEntitiesGetNumFaces(entities, &faceCount);
 
+			const EntityFilter* filter = context->FilterFor(entities);
+			if (filter != nullptr && !filter->Includes(EntityKinds::Surfaces))
+				return surfaces;
+
+			GeometryRange range = { context->Surfaces->size(), 0 };
+
 			if (faceCount > 0) {
 				std::vector<SUFaceRef> faces(faceCount);
 				SUEntitiesGetFaces(entities, faceCount, &faces[0], &faceCount);
 
 
 				for (size_t i = 0; i < faceCount; i++) {
-					Surface^ surface = Surface::FromSU(faces[i], includeMeshes, materials);
-					surfaces->Add(surface);
+					if (filter != nullptr && !filter->Accepts(SUFaceToDrawingElement(faces[i])))
+						continue;
+					Surface::Extract(faces[i], context);
 				}
+				range.Count = context->Surfaces->size() - range.Start;
 			}
 
+			context->SurfaceLists->Add(surfaces);
+			context->SurfaceListRanges->push_back(range);
+
 			return surfaces;
 		}
 
+	private:
+		Loop^ outerEdges;
+		List<Loop^>^ innerEdges;
+		List<Vertex^>^ vertices;
+		BoundingBox^ bounds;
+		GeometryStore^ store;
+		size_t index;
+
+	};
+
+	/// <summary>
+	/// Conversion phase of a model load: creates all surfaces extracted since the last run
+	/// across the thread pool and fills the surface lists handed out during extraction.
+	/// </summary>
+	ref class SurfaceBuilder
+	{
+	public:
+		static void Run(LoadContext^ context)
+		{
+			int first = context->BuiltSurfaces;
+			int count = (int)context->Surfaces->size() - first;
+			SurfaceBuilder^ builder = gcnew SurfaceBuilder(context, first, gcnew array<Surface^>(count));
+			Utilities::ForRange(0, count, 1024, gcnew Action<Tuple<int, int>^>(builder, &SurfaceBuilder::Build), context->SingleThreaded);
+
+			for (int i = context->FilledSurfaceLists; i < context->SurfaceLists->Count; i++)
+			{
+				GeometryRange range = (*context->SurfaceListRanges)[i];
+				List<Surface^>^ list = context->SurfaceLists[i];
+				list->Capacity = (int)range.Count;
+				for (size_t j = range.Start; j < range.Start + range.Count; j++)
+					list->Add(builder->result[(int)j - first]);
+			}
+
+			context->BuiltSurfaces = first + count;
+			context->FilledSurfaceLists = context->SurfaceLists->Count;
+		}
+
+	private:
+		SurfaceBuilder(LoadContext^ context, int first, array<Surface^>^ result)
+		{
+			this->context = context;
+			this->first = first;
+			this->result = result;
+		}
+
+		void Build(Tuple<int, int>^ range)
+		{
+			for (int i = range->Item1; i < range->Item2; i++)
+				result[i] = Surface::FromRecord(context, first + i);
+		}
+
+		LoadContext^ context;
+		int first;
+		array<Surface^>^ result;
 	};
 
 
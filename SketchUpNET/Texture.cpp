@@ -39,6 +39,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include "vector.h"
 #include "utilities.h"
 #include "Color.h"
+#include "TextureImage.h"
 
 
 using namespace System;
@@ -60,6 +61,11 @@ namespace SketchUpNET
 		double ScaleH;
 		double ScaleW;
 
+		/// <summary>
+		/// Pixels of the texture, set when the model is loaded with LoadOptions.TextureImages
+		/// </summary>
+		TextureImage^ Image;
+
 		Texture(System::String^ name, Color^ color, bool useAlpha, int height, int width, double scaleH, double scaleW)
 		{
 			this->Colour = color;
@@ -88,10 +94,9 @@ namespace SketchUpNET
 
 		static Texture^ FromSU(SUTextureRef texture)
 		{
-			SUStringRef name = SU_INVALID;
-			SUStringCreate(&name);
-			SUTextureGetFileName(texture, &name);
-			String^ n = SketchUpNET::Utilities::GetString(name);
+			Utilities::StringRef name;
+			SUTextureGetFileName(texture, &name.Ref);
+			String^ n = name.Value();
 
 
 			bool usealphachannel = false;
@@ -0,0 +1,351 @@
+/*
+
+SketchUpNET - a C++ Wrapper for the Trimble(R) SketchUp(R) C API
+Copyright(C) 2015, Autor: Maximilian Thumfart
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+#pragma once
+
+#include <SketchUpAPI/slapi.h>
+#include <SketchUpAPI/model/model.h>
+#include <SketchUpAPI/model/material.h>
+#include <SketchUpAPI/model/texture.h>
+#include <SketchUpAPI/model/image_rep.h>
+#include <cstring>
+#include <vector>
+#include "Utilities.h"
+
+using namespace System;
+using namespace System::Collections;
+using namespace System::Collections::Generic;
+
+namespace SketchUpNET
+{
+#pragma managed(push, off)
+	// 64 bit FNV-1a hash of a pixel buffer
+	inline unsigned long long HashPixels(const unsigned char* data, size_t length)
+	{
+		unsigned long long hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < length; i++)
+		{
+			hash ^= data[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	// Copies 32 bit image rep rows, stored bottom row first with row padding, into packed BGRA rows top row first
+	inline void PackPixels(const unsigned char* source, size_t width, size_t height, size_t padding, SUColorOrder order, unsigned char* target)
+	{
+		size_t stride = 4 * width + padding;
+		for (size_t row = 0; row < height; row++)
+		{
+			const unsigned char* s = source + (height - 1 - row) * stride;
+			unsigned char* t = target + row * 4 * width;
+			for (size_t x = 0; x < width; x++, s += 4, t += 4)
+			{
+				t[0] = s[order.blue_index];
+				t[1] = s[order.green_index];
+				t[2] = s[order.red_index];
+				t[3] = s[order.alpha_index];
+			}
+		}
+	}
+#pragma managed(pop)
+
+	/// <summary>
+	/// Pixels of a material texture. Materials using identical images share one TextureImage.
+	/// </summary>
+	public ref class TextureImage
+	{
+	public:
+
+		/// <summary>
+		/// Names of the materials using the image
+		/// </summary>
+		List<String^>^ Materials;
+
+		/// <summary>
+		/// Texture file name stored in the model
+		/// </summary>
+		String^ FileName;
+
+		/// <summary>
+		/// Width in pixels
+		/// </summary>
+		int Width;
+
+		/// <summary>
+		/// Height in pixels
+		/// </summary>
+		int Height;
+
+		/// <summary>
+		/// Pixels as packed 32 bit BGRA, top row first
+		/// </summary>
+		array<Byte>^ Pixels;
+
+		/// <summary>
+		/// Hash of the pixels the images were deduplicated by
+		/// </summary>
+		UInt64 Hash;
+
+		/// <summary>
+		/// PNG encoded image, set by EncodeAll
+		/// </summary>
+		array<Byte>^ Encoded;
+
+		/// <summary>
+		/// File the image was written to by WriteAll
+		/// </summary>
+		String^ Path;
+
+		/// <summary>
+		/// Writes the image to a stream as PNG
+		/// </summary>
+		void Save(System::IO::Stream^ stream)
+		{
+			if (Width <= 0 || Height <= 0)
+				return;
+
+			pin_ptr<Byte> p = &Pixels[0];
+			System::Drawing::Bitmap^ bitmap = gcnew System::Drawing::Bitmap(Width, Height, 4 * Width, System::Drawing::Imaging::PixelFormat::Format32bppArgb, IntPtr(p));
+			try
+			{
+				bitmap->Save(stream, System::Drawing::Imaging::ImageFormat::Png);
+			}
+			finally
+			{
+				delete bitmap;
+			}
+		}
+
+		/// <summary>
+		/// The image encoded as PNG
+		/// </summary>
+		array<Byte>^ EncodePng()
+		{
+			System::IO::MemoryStream^ stream = gcnew System::IO::MemoryStream();
+			Save(stream);
+			return stream->ToArray();
+		}
+
+		/// <summary>
+		/// Encodes all images as PNG in memory on the thread pool, setting their Encoded data
+		/// </summary>
+		/// <param name="images">Images to encode</param>
+		/// <param name="singleThreaded">Encode on the calling thread only</param>
+		static void EncodeAll(IList<TextureImage^>^ images, bool singleThreaded)
+		{
+			ImageWorker^ worker = gcnew ImageWorker(images);
+			Utilities::ForRange(0, images->Count, 1, gcnew Action<Tuple<int, int>^>(worker, &ImageWorker::Encode), singleThreaded);
+		}
+
+		/// <summary>
+		/// Writes all images as PNG files to a directory on the thread pool, setting their Path.
+		/// Files are named after the texture file name, made unique where images share a name.
+		/// </summary>
+		/// <param name="images">Images to write</param>
+		/// <param name="directory">Target directory, created if missing</param>
+		/// <param name="singleThreaded">Write on the calling thread only</param>
+		static void WriteAll(IList<TextureImage^>^ images, String^ directory, bool singleThreaded)
+		{
+			System::IO::Directory::CreateDirectory(directory);
+
+			HashSet<String^>^ names = gcnew HashSet<String^>(StringComparer::OrdinalIgnoreCase);
+			for each (TextureImage^ image in images)
+			{
+				String^ name = FileStem(image);
+				String^ unique = name;
+				for (int i = 1; !names->Add(unique); i++)
+					unique = name + "_" + i;
+				image->Path = System::IO::Path::Combine(directory, unique + ".png");
+			}
+
+			ImageWorker^ worker = gcnew ImageWorker(images);
+			Utilities::ForRange(0, images->Count, 1, gcnew Action<Tuple<int, int>^>(worker, &ImageWorker::Write), singleThreaded);
+		}
+
+	internal:
+
+		/// <summary>
+		/// Reads the image of every textured material of a model once.
+		/// Pixels are packed and hashed in parallel, images with equal content are merged.
+		/// </summary>
+		static List<TextureImage^>^ Collect(SUModelRef model, bool singleThreaded)
+		{
+			List<TextureImage^>^ found = gcnew List<TextureImage^>();
+			List<array<Byte>^>^ data = gcnew List<array<Byte>^>();
+			List<int>^ paddings = gcnew List<int>();
+
+			size_t count = 0;
+			SUModelGetNumMaterials(model, &count);
+			if (count > 0)
+			{
+				std::vector<SUMaterialRef> materials(count);
+				SUModelGetMaterials(model, count, &materials[0], &count);
+
+				for (size_t i = 0; i < count; i++)
+				{
+					SUTextureRef texture = SU_INVALID;
+					if (SUMaterialGetTexture(materials[i], &texture) != SU_ERROR_NONE)
+						continue;
+
+					// The colorized image rep is the original one for textures that are not colorized
+					SUImageRepRef rep = SU_INVALID;
+					SUImageRepCreate(&rep);
+					if (SUTextureGetColorizedImageRep(texture, &rep) == SU_ERROR_NONE && SUImageRepConvertTo32BitsPerPixel(rep) == SU_ERROR_NONE)
+					{
+						size_t width = 0, height = 0, padding = 0, size = 0, bits = 0;
+						SUImageRepGetPixelDimensions(rep, &width, &height);
+						SUImageRepGetRowPadding(rep, &padding);
+						SUImageRepGetDataSize(rep, &size, &bits);
+
+						if (width > 0 && height > 0 && bits == 32 && size >= (4 * width + padding) * height)
+						{
+							array<Byte>^ raw = gcnew array<Byte>((int)size);
+							pin_ptr<Byte> p = &raw[0];
+							SUImageRepGetData(rep, size, p);
+
+							Utilities::StringRef materialName;
+							SUMaterialGetName(materials[i], &materialName.Ref);
+							Utilities::StringRef fileName;
+							SUTextureGetFileName(texture, &fileName.Ref);
+
+							TextureImage^ image = gcnew TextureImage();
+							image->Materials = gcnew List<String^>();
+							image->Materials->Add(materialName.Value());
+							image->FileName = fileName.Value();
+							image->Width = (int)width;
+							image->Height = (int)height;
+
+							found->Add(image);
+							data->Add(raw);
+							paddings->Add((int)padding);
+						}
+					}
+					SUImageRepRelease(&rep);
+				}
+			}
+
+			ImageWorker^ worker = gcnew ImageWorker(found);
+			worker->Data = data;
+			worker->Paddings = paddings;
+			SUColorOrder order = SUGetColorOrder();
+			worker->Red = order.red_index;
+			worker->Green = order.green_index;
+			worker->Blue = order.blue_index;
+			worker->Alpha = order.alpha_index;
+			Utilities::ForRange(0, found->Count, 1, gcnew Action<Tuple<int, int>^>(worker, &ImageWorker::Pack), singleThreaded);
+
+			// Merge images with equal content, keeping the first of each
+			List<TextureImage^>^ images = gcnew List<TextureImage^>();
+			Dictionary<UInt64, TextureImage^>^ byHash = gcnew Dictionary<UInt64, TextureImage^>();
+			for each (TextureImage^ image in found)
+			{
+				TextureImage^ existing;
+				if (byHash->TryGetValue(image->Hash, existing) && existing->SamePixels(image))
+				{
+					existing->Materials->AddRange(image->Materials);
+					continue;
+				}
+				if (existing == nullptr)
+					byHash->Add(image->Hash, image);
+				images->Add(image);
+			}
+			return images;
+		}
+
+		bool SamePixels(TextureImage^ other)
+		{
+			if (Width != other->Width || Height != other->Height || Pixels->Length != other->Pixels->Length)
+				return false;
+			pin_ptr<Byte> a = &Pixels[0];
+			pin_ptr<Byte> b = &other->Pixels[0];
+			return std::memcmp(a, b, Pixels->Length) == 0;
+		}
+
+	private:
+
+		static String^ FileStem(TextureImage^ image)
+		{
+			String^ name = String::IsNullOrEmpty(image->FileName) ? nullptr : System::IO::Path::GetFileNameWithoutExtension(image->FileName);
+			if (String::IsNullOrEmpty(name))
+				name = (image->Materials->Count > 0) ? image->Materials[0] : "texture";
+			for each (wchar_t c in System::IO::Path::GetInvalidFileNameChars())
+				name = name->Replace(c, '_');
+			return name;
+		}
+
+		/// <summary>
+		/// Per image work run on the thread pool, each range handles its own images only
+		/// </summary>
+		ref class ImageWorker
+		{
+		public:
+			IList<TextureImage^>^ Images;
+			List<array<Byte>^>^ Data;
+			List<int>^ Paddings;
+			short Red, Green, Blue, Alpha;
+
+			ImageWorker(IList<TextureImage^>^ images)
+			{
+				this->Images = images;
+			}
+
+			void Pack(Tuple<int, int>^ range)
+			{
+				for (int i = range->Item1; i < range->Item2; i++)
+				{
+					TextureImage^ image = Images[i];
+					image->Pixels = gcnew array<Byte>(4 * image->Width * image->Height);
+
+					SUColorOrder order = { Red, Green, Blue, Alpha };
+					pin_ptr<Byte> source = &Data[i][0];
+					pin_ptr<Byte> target = &image->Pixels[0];
+					PackPixels(source, image->Width, image->Height, Paddings[i], order, target);
+					image->Hash = HashPixels(target, image->Pixels->Length);
+					Data[i] = nullptr;
+				}
+			}
+
+			void Encode(Tuple<int, int>^ range)
+			{
+				for (int i = range->Item1; i < range->Item2; i++)
+					Images[i]->Encoded = Images[i]->EncodePng();
+			}
+
+			void Write(Tuple<int, int>^ range)
+			{
+				for (int i = range->Item1; i < range->Item2; i++)
+				{
+					System::IO::FileStream^ stream = System::IO::File::Create(Images[i]->Path);
+					try
+					{
+						Images[i]->Save(stream);
+					}
+					finally
+					{
+						delete stream;
+					}
+				}
+			}
+		};
+	};
+
+
+}
\ No newline at end of file
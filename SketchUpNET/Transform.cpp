@@ -33,8 +33,12 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include <SketchUpAPI/transformation.h>
 #include <msclr/marshal.h>
 #include <SketchUpAPI/model/component_instance.h>
+#include <cmath>
+#include <intrin.h>
+#include <immintrin.h>
 #include <vector>
 #include "vertex.h"
+#include "utilities.h"
 
 using namespace System;
 using namespace System::Collections;
@@ -42,26 +46,328 @@ using namespace System::Collections::Generic;
 
 namespace SketchUpNET
 {
+#pragma managed(push, off)
+	// Column-major 4x4 product parent * child, applying child first
+	inline void ComposeTransforms(const double* parent, const double* child, double* result)
+	{
+		for (int col = 0; col < 4; col++)
+			for (int row = 0; row < 4; row++)
+				result[4 * col + row] = parent[row] * child[4 * col] + parent[4 + row] * child[4 * col + 1] + parent[8 + row] * child[4 * col + 2] + parent[12 + row] * child[4 * col + 3];
+	}
+
+	// Inverse of a column-major 4x4 matrix by cofactor expansion, false if it is singular
+	inline bool InvertTransform(const double* m, double* inverse)
+	{
+		double inv[16];
+		inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+		inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+		inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+		inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+		inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+		inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+		inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+		inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+		inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+		inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+		inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+		inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+		inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+		inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+		inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+		inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+		double det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+		if (det == 0.0)
+			return false;
+
+		for (int i = 0; i < 16; i++)
+			inverse[i] = inv[i] / det;
+		return true;
+	}
+
+	// Instruction sets usable for the batch kernels, detected once
+	enum class SimdLevel { Scalar, Sse2, Avx2 };
+
+	inline SimdLevel DetectSimd()
+	{
+		int info[4];
+		__cpuid(info, 0);
+		int ids = info[0];
+
+		__cpuid(info, 1);
+		bool sse2 = (info[3] & (1 << 26)) != 0;
+		bool fma = (info[2] & (1 << 12)) != 0;
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+
+		bool avx2 = false;
+		if (ids >= 7 && fma && osxsave && avx && (_xgetbv(0) & 6) == 6)
+		{
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+
+		return avx2 ? SimdLevel::Avx2 : (sse2 ? SimdLevel::Sse2 : SimdLevel::Scalar);
+	}
+
+	inline SimdLevel Simd()
+	{
+		static const SimdLevel level = DetectSimd();
+		return level;
+	}
+
+	/// <summary>
+	/// Column-major 4x4 matrix prepared for transforming packed xyz arrays in place.
+	/// Affine matrices are pre-divided by w and run through SIMD kernels,
+	/// normals use the inverse transpose of the linear part and are renormalized.
+	/// </summary>
+	struct TransformMatrix
+	{
+		// Columns of the matrix, four values each with the homogeneous row last
+		double M[16];
+		// Affine columns divided by the constant w, row 3 zeroed for the vector kernels
+		double Affine[16];
+		// Inverse transpose of the upper 3x3 in the same padded column layout
+		double Normal[12];
+		bool IsAffine;
+		// The linear part after dividing by w reverses orientation
+		bool Mirrored;
+
+		explicit TransformMatrix(const double* m)
+		{
+			for (int i = 0; i < 16; i++)
+				M[i] = m[i];
+
+			IsAffine = (m[3] == 0.0 && m[7] == 0.0 && m[11] == 0.0 && m[15] != 0.0);
+			double w = IsAffine ? 1.0 / m[15] : 1.0;
+			for (int col = 0; col < 4; col++)
+			{
+				for (int row = 0; row < 3; row++)
+					Affine[4 * col + row] = m[4 * col + row] * w;
+				Affine[4 * col + 3] = 0.0;
+			}
+
+			// Cofactors of the linear part, divided by the determinant to keep orientation
+			double a00 = m[0], a10 = m[1], a20 = m[2];
+			double a01 = m[4], a11 = m[5], a21 = m[6];
+			double a02 = m[8], a12 = m[9], a22 = m[10];
+			double c[9] = {
+				a11 * a22 - a12 * a21, -(a01 * a22 - a02 * a21), a01 * a12 - a02 * a11,
+				-(a10 * a22 - a12 * a20), a00 * a22 - a02 * a20, -(a00 * a12 - a02 * a10),
+				a10 * a21 - a11 * a20, -(a00 * a21 - a01 * a20), a00 * a11 - a01 * a10 };
+			double det = a00 * c[0] + a01 * c[3] + a02 * c[6];
+			double scale = (det != 0.0) ? 1.0 / det : 1.0;
+			Mirrored = det * (IsAffine ? m[15] : 1.0) < 0.0;
+
+			// c holds cofactor (row, col) at 3 * col + row, which is column-major for the transposed inverse
+			for (int col = 0; col < 3; col++)
+			{
+				for (int row = 0; row < 3; row++)
+					Normal[4 * col + row] = c[3 * col + row] * scale;
+				Normal[4 * col + 3] = 0.0;
+			}
+		}
+
+		void Points(double* points, size_t count) const
+		{
+			if (!IsAffine)
+				PointsProjective(M, points, count);
+			else if (Simd() == SimdLevel::Avx2)
+				PointsAvx2(Affine, points, count);
+			else if (Simd() == SimdLevel::Sse2)
+				PointsSse2(Affine, points, count);
+			else
+				PointsScalar(Affine, points, count);
+		}
+
+		void Normals(double* normals, size_t count) const
+		{
+			if (Simd() == SimdLevel::Avx2)
+				NormalsAvx2(Normal, normals, count);
+			else
+				NormalsScalar(Normal, normals, count);
+		}
+
+		static void PointsProjective(const double* m, double* p, size_t count)
+		{
+			for (size_t i = 0; i < count; i++, p += 3)
+			{
+				double x = p[0], y = p[1], z = p[2];
+				double w = m[3] * x + m[7] * y + m[11] * z + m[15];
+				p[0] = (m[0] * x + m[4] * y + m[8] * z + m[12]) / w;
+				p[1] = (m[1] * x + m[5] * y + m[9] * z + m[13]) / w;
+				p[2] = (m[2] * x + m[6] * y + m[10] * z + m[14]) / w;
+			}
+		}
+
+		static void PointsScalar(const double* c, double* p, size_t count)
+		{
+			for (size_t i = 0; i < count; i++, p += 3)
+			{
+				double x = p[0], y = p[1], z = p[2];
+				p[0] = c[0] * x + c[4] * y + c[8] * z + c[12];
+				p[1] = c[1] * x + c[5] * y + c[9] * z + c[13];
+				p[2] = c[2] * x + c[6] * y + c[10] * z + c[14];
+			}
+		}
+
+		static void PointsSse2(const double* c, double* p, size_t count)
+		{
+			__m128d c0 = _mm_loadu_pd(c), c0z = _mm_load_sd(c + 2);
+			__m128d c1 = _mm_loadu_pd(c + 4), c1z = _mm_load_sd(c + 6);
+			__m128d c2 = _mm_loadu_pd(c + 8), c2z = _mm_load_sd(c + 10);
+			__m128d c3 = _mm_loadu_pd(c + 12), c3z = _mm_load_sd(c + 14);
+			for (size_t i = 0; i < count; i++, p += 3)
+			{
+				__m128d x = _mm_load1_pd(p);
+				__m128d y = _mm_load1_pd(p + 1);
+				__m128d z = _mm_load1_pd(p + 2);
+				__m128d xy = _mm_add_pd(_mm_add_pd(_mm_mul_pd(c0, x), _mm_mul_pd(c1, y)), _mm_add_pd(_mm_mul_pd(c2, z), c3));
+				__m128d zz = _mm_add_sd(_mm_add_sd(_mm_mul_sd(c0z, x), _mm_mul_sd(c1z, y)), _mm_add_sd(_mm_mul_sd(c2z, z), c3z));
+				_mm_storeu_pd(p, xy);
+				_mm_store_sd(p + 2, zz);
+			}
+		}
+
+		static void PointsAvx2(const double* c, double* p, size_t count)
+		{
+			__m256d c0 = _mm256_loadu_pd(c);
+			__m256d c1 = _mm256_loadu_pd(c + 4);
+			__m256d c2 = _mm256_loadu_pd(c + 8);
+			__m256d c3 = _mm256_loadu_pd(c + 12);
+			__m256i xyz = _mm256_setr_epi64x(-1, -1, -1, 0);
+			for (size_t i = 0; i < count; i++, p += 3)
+			{
+				__m256d r = _mm256_fmadd_pd(c0, _mm256_broadcast_sd(p), c3);
+				r = _mm256_fmadd_pd(c1, _mm256_broadcast_sd(p + 1), r);
+				r = _mm256_fmadd_pd(c2, _mm256_broadcast_sd(p + 2), r);
+				_mm256_maskstore_pd(p, xyz, r);
+			}
+		}
+
+		static void NormalsScalar(const double* c, double* n, size_t count)
+		{
+			for (size_t i = 0; i < count; i++, n += 3)
+			{
+				double x = n[0], y = n[1], z = n[2];
+				double nx = c[0] * x + c[4] * y + c[8] * z;
+				double ny = c[1] * x + c[5] * y + c[9] * z;
+				double nz = c[2] * x + c[6] * y + c[10] * z;
+				double length = std::sqrt(nx * nx + ny * ny + nz * nz);
+				if (length > 0.0)
+				{
+					n[0] = nx / length;
+					n[1] = ny / length;
+					n[2] = nz / length;
+				}
+			}
+		}
+
+		static void NormalsAvx2(const double* c, double* n, size_t count)
+		{
+			__m256d c0 = _mm256_loadu_pd(c);
+			__m256d c1 = _mm256_loadu_pd(c + 4);
+			__m256d c2 = _mm256_loadu_pd(c + 8);
+			__m256i xyz = _mm256_setr_epi64x(-1, -1, -1, 0);
+			for (size_t i = 0; i < count; i++, n += 3)
+			{
+				__m256d r = _mm256_mul_pd(c0, _mm256_broadcast_sd(n));
+				r = _mm256_fmadd_pd(c1, _mm256_broadcast_sd(n + 1), r);
+				r = _mm256_fmadd_pd(c2, _mm256_broadcast_sd(n + 2), r);
+
+				// Squared length summed across the lanes, the fourth lane is zero
+				__m256d squared = _mm256_mul_pd(r, r);
+				__m128d sum = _mm_add_pd(_mm256_castpd256_pd128(squared), _mm256_extractf128_pd(squared, 1));
+				sum = _mm_add_sd(sum, _mm_unpackhi_pd(sum, sum));
+				double length = _mm_cvtsd_f64(_mm_sqrt_sd(sum, sum));
+				if (length > 0.0)
+					_mm256_maskstore_pd(n, xyz, _mm256_div_pd(r, _mm256_set1_pd(length)));
+			}
+		}
+	};
+#pragma managed(pop)
+
 	public ref class Transform
 	{
 	public:
 
+		/// <summary>
+		/// Transforms a single point, dividing by the homogeneous w.
+		/// Use TransformPoints for many points.
+		/// </summary>
 		Vertex^ GetTransformed(Vertex^ point)
 		{
+			array<double>^ m = this->Data;
+			double x = point->X, y = point->Y, z = point->Z;
+			double w = m[3] * x + m[7] * y + m[11] * z + m[15];
 
-			Vertex^ transformedPoint = gcnew Vertex(point->X, point->Y, point->Z);
+			return gcnew Vertex(
+				(m[0] * x + m[4] * y + m[8] * z + m[12]) / w,
+				(m[1] * x + m[5] * y + m[9] * z + m[13]) / w,
+				(m[2] * x + m[6] * y + m[10] * z + m[14]) / w);
+		}
 
-			double uniform_scale_factor = 1.0 / this->Scale;
+		/// <summary>
+		/// The transformation has no perspective part, w is constant
+		/// </summary>
+		property bool IsAffine
+		{
+			bool get() { return Data[3] == 0.0 && Data[7] == 0.0 && Data[11] == 0.0 && Data[15] != 0.0; }
+		}
 
-			transformedPoint->X = (this->Data[0] * point->X) + (point->Y*this->Data[4]) + (point->Z*this->Data[8]) + this->Data[12];
-			transformedPoint->Y = (this->Data[1] * point->X) + (point->Y*this->Data[5]) + (point->Z*this->Data[9]) + this->Data[13];
-			transformedPoint->Z = (this->Data[2] * point->X) + (point->Y*this->Data[6]) + (point->Z*this->Data[10]) + this->Data[14];
+		/// <summary>
+		/// Transforms packed xyz points in place
+		/// </summary>
+		/// <param name="points">Points as xyz triples</param>
+		void TransformPoints(array<double>^ points)
+		{
+			TransformPoints(points, 0, points->Length / 3);
+		}
 
-			transformedPoint->X = transformedPoint->X* this->Scale;
-			transformedPoint->Y = transformedPoint->Y* this->Scale;
-			transformedPoint->Z = transformedPoint->Z* this->Scale;
+		/// <summary>
+		/// Transforms a range of packed xyz points in place.
+		/// Large ranges are split across the thread pool.
+		/// </summary>
+		/// <param name="points">Points as xyz triples</param>
+		/// <param name="first">First point to transform</param>
+		/// <param name="count">Number of points</param>
+		void TransformPoints(array<double>^ points, int first, int count)
+		{
+			Run(points, first, count, false);
+		}
 
-			return transformedPoint;
+		/// <summary>
+		/// Transforms packed xyz normals in place by the inverse transpose and renormalizes them
+		/// </summary>
+		/// <param name="normals">Normals as xyz triples</param>
+		void TransformNormals(array<double>^ normals)
+		{
+			TransformNormals(normals, 0, normals->Length / 3);
+		}
+
+		/// <summary>
+		/// Transforms a range of packed xyz normals in place by the inverse transpose and renormalizes them
+		/// </summary>
+		/// <param name="normals">Normals as xyz triples</param>
+		/// <param name="first">First normal to transform</param>
+		/// <param name="count">Number of normals</param>
+		void TransformNormals(array<double>^ normals, int first, int count)
+		{
+			Run(normals, first, count, true);
+		}
+
+		/// <summary>
+		/// Transformation undoing this one
+		/// </summary>
+		/// <exception cref="InvalidOperationException">The transformation is singular</exception>
+		Transform^ Inverse()
+		{
+			array<double>^ result = gcnew array<double>(16);
+			pin_ptr<double> m = &this->Data[0];
+			pin_ptr<double> r = &result[0];
+			if (!InvertTransform(m, r))
+				throw gcnew InvalidOperationException("Transformation is not invertible");
+			return gcnew Transform(result);
 		}
 
 
@@ -83,7 +389,89 @@ namespace SketchUpNET
 		};
 
 		Transform(){};
+
+		/// <summary>
+		/// Transformation that leaves every point unchanged
+		/// </summary>
+		static property Transform^ Identity
+		{
+			Transform^ get()
+			{
+				return gcnew Transform(gcnew array<double>(16) { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 });
+			}
+		}
+
+		/// <summary>
+		/// Transformation applying child first and then this transformation,
+		/// e.g. the world transformation of an instance nested in an instance placed by this one
+		/// </summary>
+		/// <param name="child">Inner transformation</param>
+		Transform^ Multiply(Transform^ child)
+		{
+			return gcnew Transform(Compose(this->Data, child->Data));
+		}
+
 	internal:
+		/// <summary>
+		/// Column-major product of two matrices, a missing matrix counts as identity.
+		/// Always returns a new array, so the result never aliases either argument.
+		/// </summary>
+		static array<double>^ Compose(array<double>^ parent, array<double>^ child)
+		{
+			if (child == nullptr) return parent == nullptr ? nullptr : (array<double>^)parent->Clone();
+			if (parent == nullptr) return (array<double>^)child->Clone();
+
+			array<double>^ result = gcnew array<double>(16);
+			pin_ptr<double> p = &parent[0];
+			pin_ptr<double> c = &child[0];
+			pin_ptr<double> r = &result[0];
+			ComposeTransforms(p, c, r);
+			return result;
+		}
+
+		/// <summary>
+		/// Applies a prepared matrix to ranges of a pinned array from the thread pool
+		/// </summary>
+		ref class BatchTransformer
+		{
+		public:
+			BatchTransformer(const TransformMatrix* matrix, double* data, bool normals)
+			{
+				this->matrix = matrix;
+				this->data = data;
+				this->normals = normals;
+			}
+
+			void Apply(Tuple<int, int>^ range)
+			{
+				double* start = data + 3 * (size_t)range->Item1;
+				size_t count = (size_t)(range->Item2 - range->Item1);
+				if (normals)
+					matrix->Normals(start, count);
+				else
+					matrix->Points(start, count);
+			}
+
+		private:
+			const TransformMatrix* matrix;
+			double* data;
+			bool normals;
+		};
+
+		void Run(array<double>^ values, int first, int count, bool normals)
+		{
+			if (count <= 0) return;
+			if (first < 0 || 3 * ((long long)first + count) > values->Length)
+				throw gcnew ArgumentOutOfRangeException("count");
+
+			pin_ptr<double> m = &this->Data[0];
+			TransformMatrix matrix(m);
+			pin_ptr<double> p = &values[0];
+
+			BatchTransformer^ transformer = gcnew BatchTransformer(&matrix, p, normals);
+			Utilities::ForRange(first, first + count, 1 << 16, gcnew Action<Tuple<int, int>^>(transformer, &BatchTransformer::Apply), false);
+		}
+
 		static Transform^ FromSU(SUTransformation transformation)
 		{
 			double* data = transformation.values;
@@ -101,6 +489,17 @@ namespace SketchUpNET
 
 		};
 
+		SUTransformation ToSU()
+		{
+			SUTransformation transformation;
+			for (int i = 0; i < 16; i++)
+				if (i == 12 || i == 13 || i == 14)
+					transformation.values[i] = Data[i] * 39.3701;
+				else
+					transformation.values[i] = Data[i];
+			return transformation;
+		}
+
 	};
 
 
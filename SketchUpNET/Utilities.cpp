@@ -29,6 +29,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include <SketchUpAPI/model/entities.h>
 #include <SketchUpAPI/model/layer.h>
 #include <msclr/marshal.h>
+#include <vcclr.h>
 #include <vector>
 
 using namespace System;
@@ -43,42 +44,122 @@ namespace SketchUpNET
 
 		static System::String^ GetLayerName(SULayerRef layer)
 		{
-			SUStringRef layername = SU_INVALID;
-			SUStringCreate(&layername);
-			SULayerGetName(layer, &layername);
-			System::String^ name = GetString(layername);
+			StringRef layername;
+			SULayerGetName(layer, &layername.Ref);
 
-			return name;
+			return GetString(layername.Ref);
 		}
 
 
+		/// <summary>
+		/// Decodes a SketchUp string. Names up to 256 bytes are copied through a stack buffer,
+		/// longer ones through a single temporary heap buffer.
+		/// </summary>
 		static System::String^ GetString(SUStringRef name)
 		{
 			size_t name_length = 0;
 			SUStringGetUTF8Length(name, &name_length);
 			if (name_length == 0) return System::String::Empty;
-			
-			char* name_utf8 = new char[name_length +1];
+
+			char small[256];
+			std::vector<char> large;
+			char* name_utf8 = small;
+			if (name_length + 1 > sizeof(small))
+			{
+				large.resize(name_length + 1);
+				name_utf8 = large.data();
+			}
+
 			SUStringGetUTF8(name, name_length+1, name_utf8, &name_length);
 			
-			return gcnew System::String(name_utf8, 0, name_length, System::Text::Encoding::UTF8);
+			return gcnew System::String(name_utf8, 0, (int)name_length, System::Text::Encoding::UTF8);
 		}
 
-		static const char* ToString(System::String^ value)
+		/// <summary>
+		/// Runs body over [from, to) in chunks of at most grain elements.
+		/// Chunks are scheduled on the work-stealing thread pool unless singleThreaded is set.
+		/// </summary>
+		static void ForRange(int from, int to, int grain, Action<Tuple<int, int>^>^ body, bool singleThreaded)
 		{
-			array<unsigned char>^ bytes = System::Text::Encoding::UTF8->GetBytes(value);
-			char* result = new char[bytes->Length + 1];
-			result[bytes->Length] = 0;
-			int i = 0;
-			for each(unsigned char c in bytes) {
-				result[i++] = c;
+			if (to <= from) return;
+
+			if (singleThreaded || to - from <= grain)
+			{
+				body(gcnew Tuple<int, int>(from, to));
+				return;
 			}
-			return result;
+
+			System::Threading::Tasks::Parallel::ForEach<Tuple<int, int>^>(System::Collections::Concurrent::Partitioner::Create(from, to, grain), body);
 		}
 
-		
+		/// <summary>
+		/// Owned SketchUp string, released when it goes out of scope
+		/// </summary>
+		class StringRef
+		{
+		public:
+			SUStringRef Ref;
+
+			StringRef()
+			{
+				SUSetInvalid(Ref);
+				SUStringCreate(&Ref);
+			}
+
+			~StringRef()
+			{
+				SUStringRelease(&Ref);
+			}
+
+			System::String^ Value() const
+			{
+				return GetString(Ref);
+			}
+
+		private:
+			StringRef(const StringRef&);
+			StringRef& operator=(const StringRef&);
+		};
+
+		/// <summary>
+		/// Null-terminated UTF-8 copy of a managed string for the SketchUp API.
+		/// Short strings such as file paths stay in the inline buffer.
+		/// </summary>
+		class Utf8String
+		{
+		public:
+			Utf8String(System::String^ value)
+			{
+				int length = System::Text::Encoding::UTF8->GetByteCount(value);
+				char* target = small;
+				if (length + 1 > (int)sizeof(small))
+				{
+					large.resize(length + 1);
+					target = large.data();
+				}
+
+				if (length > 0)
+				{
+					pin_ptr<const wchar_t> chars = PtrToStringChars(value);
+					System::Text::Encoding::UTF8->GetBytes((wchar_t*)chars, value->Length, (unsigned char*)target, length);
+				}
+				target[length] = 0;
+				data = target;
+			}
+
+			operator const char*() const
+			{
+				return data;
+			}
 
+		private:
+			char small[512];
+			std::vector<char> large;
+			const char* data;
 
+			Utf8String(const Utf8String&);
+			Utf8String& operator=(const Utf8String&);
+		};
 
 	};
 
@@ -0,0 +1,203 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+
+namespace SketchUpNETConsole
+{
+    /// <summary>
+    /// Measures the per-file cost of loading models with and without a shared SketchUpSession,
+    /// and the cost of writing faces one by one or through the batched ModelWriter
+    /// and of exporting GLB
+    /// </summary>
+    static class Benchmark
+    {
+        public static void Run(string path, int iterations)
+        {
+            string[] files = Directory.Exists(path) ? Directory.GetFiles(path, "*.skp") : new[] { path };
+            if (files.Length == 0)
+            {
+                Console.WriteLine("No .skp files found in " + path);
+                return;
+            }
+
+            // Warm up the loader and the JIT before measuring
+            Load(files);
+
+            double perCall = Measure(files, iterations);
+            double session;
+            using (new SketchUpNET.SketchUpSession())
+                session = Measure(files, iterations);
+
+            Console.WriteLine("Files: {0}, iterations: {1}", files.Length, iterations);
+            Console.WriteLine("Per-call initialization: {0,10:F3} ms/file", perCall);
+            Console.WriteLine("Shared session:          {0,10:F3} ms/file", session);
+            Console.WriteLine("Saved per file:          {0,10:F3} ms", perCall - session);
+        }
+
+        public static void RunWrite(int faces)
+        {
+            SketchUpNET.SketchUp skp = new SketchUpNET.SketchUp();
+            skp.Surfaces = Grid(faces);
+            skp.Edges = new List<SketchUpNET.Edge>();
+            skp.Curves = new List<SketchUpNET.Curve>();
+
+            string file = Path.Combine(Path.GetTempPath(), "SketchUpNETWriteBenchmark.skp");
+            SketchUpNET.ModelWriter writer = new SketchUpNET.ModelWriter();
+
+            skp.Writer = writer;
+            double batched = MeasureWrite(skp, file);
+            skp.Writer = null;
+            double perFace = MeasureWrite(skp, file);
+            File.Delete(file);
+
+            Console.WriteLine("Faces: {0}, batches: {1}", faces, writer.BatchCount);
+            Console.WriteLine("SUEntitiesAddFaces:   {0,10:F1} ms", perFace);
+            Console.WriteLine("SUEntitiesFill:       {0,10:F1} ms", batched);
+            Console.WriteLine("Speedup:              {0,10:F1}x", perFace / batched);
+        }
+
+        /// <summary>
+        /// Compares placing instances one Instance at a time with PlaceInstances from packed transforms
+        /// </summary>
+        public static void RunPlace(int count)
+        {
+            SketchUpNET.Component seat = new SketchUpNET.Component("Seat", "seat", Grid(1), new List<SketchUpNET.Curve>(),
+                new List<SketchUpNET.Edge>(), new List<SketchUpNET.Instance>(), "", new List<SketchUpNET.Group>());
+            int side = (int)Math.Ceiling(Math.Sqrt(count));
+            double[] transforms = new double[12 * count];
+            for (int i = 0; i < count; i++)
+            {
+                double[] t = { 1, 0, 0, 2 * (i % side), 0, 1, 0, 2 * (i / side), 0, 0, 1, 0 };
+                Array.Copy(t, 0, transforms, 12 * i, 12);
+            }
+
+            string file = Path.Combine(Path.GetTempPath(), "SketchUpNETPlaceBenchmark.skp");
+            SketchUpNET.SketchUp skp = new SketchUpNET.SketchUp();
+            skp.Surfaces = new List<SketchUpNET.Surface>();
+            skp.Edges = new List<SketchUpNET.Edge>();
+            skp.Curves = new List<SketchUpNET.Curve>();
+
+            skp.Instances = new List<SketchUpNET.Instance>(count);
+            for (int i = 0; i < count; i++)
+            {
+                double[] data = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, transforms[12 * i + 3], transforms[12 * i + 7], 0, 1 };
+                SketchUpNET.Instance instance = new SketchUpNET.Instance("", null, seat.Guid, new SketchUpNET.Transform(data), "Layer0", null);
+                instance.Parent = seat;
+                skp.Instances.Add(instance);
+            }
+            double single = MeasureWrite(skp, file);
+
+            skp.Instances = null;
+            skp.PlaceInstances(seat, transforms, "Layer0", null);
+            double bulk = MeasureWrite(skp, file);
+            File.Delete(file);
+
+            Console.WriteLine("Instances: {0}", count);
+            Console.WriteLine("Instance objects:     {0,10:F1} ms", single);
+            Console.WriteLine("PlaceInstances:       {0,10:F1} ms", bulk);
+            Console.WriteLine("Speedup:              {0,10:F1}x", single / bulk);
+        }
+
+        /// <summary>
+        /// Measures GLB export throughput of a model held in memory
+        /// </summary>
+        public static void RunGlb(string path, int iterations)
+        {
+            SketchUpNET.SketchUp skp = new SketchUpNET.SketchUp();
+            skp.LoadModel(path, true);
+
+            SketchUpNET.GltfExporter exporter = new SketchUpNET.GltfExporter();
+            MemoryStream stream = new MemoryStream();
+            exporter.Write(stream, skp.Surfaces, skp.Groups, skp.Instances);
+
+            Stopwatch watch = Stopwatch.StartNew();
+            for (int i = 0; i < iterations; i++)
+            {
+                stream.SetLength(0);
+                exporter.Write(stream, skp.Surfaces, skp.Groups, skp.Instances);
+            }
+            watch.Stop();
+
+            double seconds = watch.Elapsed.TotalSeconds / iterations;
+            Console.WriteLine("Meshes: {0}, nodes: {1}, instanced placements: {2}", exporter.MeshCount, exporter.NodeCount, exporter.InstancedCount);
+            Console.WriteLine("GLB size:             {0,10:F1} MB", exporter.ByteCount / 1048576.0);
+            Console.WriteLine("Export:               {0,10:F1} ms", seconds * 1000);
+            Console.WriteLine("Throughput:           {0,10:F1} MB/s", exporter.ByteCount / 1048576.0 / seconds);
+        }
+
+        /// <summary>
+        /// Compares a full load with a load from the binary model cache
+        /// </summary>
+        public static void RunCache(string path, int iterations)
+        {
+            SketchUpNET.ModelCache cache = new SketchUpNET.ModelCache(Path.Combine(Path.GetTempPath(), "SketchUpNETCache"));
+            cache.Invalidate(path);
+
+            Stopwatch watch = Stopwatch.StartNew();
+            new SketchUpNET.SketchUp().LoadModelCached(path, true, cache);
+            watch.Stop();
+            double miss = watch.Elapsed.TotalMilliseconds;
+            long bytes = cache.ByteCount;
+
+            watch.Restart();
+            for (int i = 0; i < iterations; i++)
+                new SketchUpNET.SketchUp().LoadModelCached(path, true, cache);
+            watch.Stop();
+
+            Console.WriteLine("Cache size:           {0,10:F1} MB", bytes / 1048576.0);
+            Console.WriteLine("Load and write cache: {0,10:F1} ms", miss);
+            Console.WriteLine("Load from cache:      {0,10:F1} ms{1}", watch.Elapsed.TotalMilliseconds / iterations, cache.Hit ? "" : " (miss)");
+        }
+
+        static double MeasureWrite(SketchUpNET.SketchUp skp, string file)
+        {
+            Stopwatch watch = Stopwatch.StartNew();
+            skp.WriteNewModel(file);
+            watch.Stop();
+            return watch.Elapsed.TotalMilliseconds;
+        }
+
+        /// <summary>
+        /// Square grid of unit quads sharing their edges with their neighbours
+        /// </summary>
+        static List<SketchUpNET.Surface> Grid(int faces)
+        {
+            int side = (int)Math.Ceiling(Math.Sqrt(faces));
+            List<SketchUpNET.Surface> surfaces = new List<SketchUpNET.Surface>(faces);
+            for (int i = 0; i < faces; i++)
+            {
+                double x = i % side, y = i / side;
+                SketchUpNET.Vertex[] corners =
+                {
+                    new SketchUpNET.Vertex(x, y, 0), new SketchUpNET.Vertex(x + 1, y, 0),
+                    new SketchUpNET.Vertex(x + 1, y + 1, 0), new SketchUpNET.Vertex(x, y + 1, 0)
+                };
+                List<SketchUpNET.Edge> edges = new List<SketchUpNET.Edge>(4);
+                for (int c = 0; c < 4; c++)
+                    edges.Add(new SketchUpNET.Edge(corners[c], corners[(c + 1) % 4]));
+                surfaces.Add(new SketchUpNET.Surface(new SketchUpNET.Loop(edges)));
+            }
+            return surfaces;
+        }
+
+        static double Measure(string[] files, int iterations)
+        {
+            Stopwatch watch = Stopwatch.StartNew();
+            for (int i = 0; i < iterations; i++)
+                Load(files);
+            watch.Stop();
+            return watch.Elapsed.TotalMilliseconds / (iterations * files.Length);
+        }
+
+        static void Load(IEnumerable<string> files)
+        {
+            foreach (string file in files)
+            {
+                SketchUpNET.SketchUp skp = new SketchUpNET.SketchUp();
+                skp.LoadModel(file, false);
+            }
+        }
+    }
+}
@@ -10,6 +10,36 @@ class Program
     {
         static void Main(string[] args)
         {
+            if (args.Length > 1 && args[0] == "--bench-glb")
+            {
+                Benchmark.RunGlb(args[1], args.Length > 2 ? int.Parse(args[2]) : 10);
+                return;
+            }
+
+            if (args.Length > 1 && args[0] == "--bench-cache")
+            {
+                Benchmark.RunCache(args[1], args.Length > 2 ? int.Parse(args[2]) : 10);
+                return;
+            }
+
+            if (args.Length > 1 && args[0] == "--bench-place")
+            {
+                Benchmark.RunPlace(int.Parse(args[1]));
+                return;
+            }
+
+            if (args.Length > 1 && args[0] == "--bench-write")
+            {
+                Benchmark.RunWrite(int.Parse(args[1]));
+                return;
+            }
+
+            if (args.Length > 1 && args[0] == "--bench")
+            {
+                Benchmark.Run(args[1], args.Length > 2 ? int.Parse(args[2]) : 20);
+                return;
+            }
+
             if (args.Length > 0)
             {
                 SketchUpNET.SketchUp skp = new SketchUpNET.SketchUp();